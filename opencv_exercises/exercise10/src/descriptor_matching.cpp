@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <numeric>
 #include <opencv2/core.hpp>
@@ -5,6 +6,7 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "hammingMatcher.h"
 #include "structIO.hpp"
 
 using namespace std;
@@ -77,7 +79,55 @@ void matchDescriptors(cv::Mat &imgSource, cv::Mat &imgRef, vector<cv::KeyPoint>
   }  // wait for esc input before continuing
 }
 
-int main() {
+// cv::BFMatcher kNN matching with the distance ratio test vs. the in-tree matchHamming on the BRISK fixtures
+void benchmarkHammingMatcher() {
+  const int numRuns = 20;
+  const double minDescriptorDistRatio = 0.8;
+  string fixtures[] = {"small", "large"};
+  for (const auto &fixture : fixtures) {
+    cv::Mat descSource, descRef;
+    readDescriptors(("../data/C35A5_DescSource_BRISK_" + fixture + ".dat").c_str(), descSource);
+    readDescriptors(("../data/C35A5_DescRef_BRISK_" + fixture + ".dat").c_str(), descRef);
+
+    cv::Ptr<cv::DescriptorMatcher> matcher = cv::BFMatcher::create(cv::NORM_HAMMING, false);
+    vector<cv::DMatch> bfMatches, simdMatches;
+    double tBruteForce = 0, tSimd = 0;
+    for (int run = 0; run < numRuns; ++run) {
+      bfMatches.clear();
+      double t = (double)cv::getTickCount();
+      std::vector<std::vector<cv::DMatch>> knn_matches;
+      matcher->knnMatch(descSource, descRef, knn_matches, 2);
+      for (auto it = knn_matches.begin(); it != knn_matches.end(); ++it) {
+        if (it->size() > 1 && (*it)[0].distance < minDescriptorDistRatio * (*it)[1].distance) {
+          bfMatches.push_back((*it)[0]);
+        }
+      }
+      tBruteForce += ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+
+      simdMatches.clear();
+      t = (double)cv::getTickCount();
+      matchHamming(descSource, descRef, simdMatches, minDescriptorDistRatio);
+      tSimd += ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+    }
+
+    bool identical = bfMatches.size() == simdMatches.size() &&
+                     std::equal(bfMatches.begin(), bfMatches.end(), simdMatches.begin(),
+                                [](const cv::DMatch &m1, const cv::DMatch &m2) {
+                                  return m1.queryIdx == m2.queryIdx && m1.trainIdx == m2.trainIdx;
+                                });
+    cout << "BRISK " << fixture << " (" << descSource.rows << " x " << descRef.rows << " descriptors, "
+         << descSource.cols << " bytes): BFMatcher n=" << bfMatches.size() << " in " << 1000 * tBruteForce / numRuns
+         << " ms, matchHamming (" << hammingMatcherInstructionSet() << ") n=" << simdMatches.size() << " in "
+         << 1000 * tSimd / numRuns << " ms, identical matches: " << (identical ? "yes" : "no") << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && string(argv[1]) == "--benchmark") {
+    benchmarkHammingMatcher();
+    return 0;
+  }
+
   cv::Mat imgSource = cv::imread("../images/img1gray.png");
   cv::Mat imgRef = cv::imread("../images/img2gray.png");
 
@@ -1,26 +1,24 @@
 #include <iostream>
 #include <numeric>
+#include <string>
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
-using namespace std;
+#include "keypointNms.h"
 
-struct NmsParams {
-  // KeyPoints Non-maximum suppression parameters
-  double maxOverlap = 0.0;  // max allowed overlap between two corners/features
-  int minResponse = 100;    // minimum value for a corner in the 8bit scaled response matrix
-};
+using namespace std;
 
-bool checkOverlap(cv::KeyPoint& keyPoint1, cv::KeyPoint& keyPoint2, NmsParams& nmsParams) {
-  bool overlap = false;
+bool checkOverlap(cv::KeyPoint& keyPoint1, cv::KeyPoint& keyPoint2, const NmsParams& nmsParams) {
   double kptOveralpArea = cv::KeyPoint::overlap(keyPoint1, keyPoint2);
   return kptOveralpArea > nmsParams.maxOverlap;
 }
 
-void nonMaximumSuppression(cv::Mat& image, std::vector<cv::KeyPoint>& keyPoints, NmsParams& nmsParams,
-                           int keyPointSize) {
+// Reference implementation: every candidate pixel is compared against every accepted keypoint,
+// O(pixels x keypoints). Kept for the benchmark against the spatial hash NMS in keypointNms.cpp
+void nonMaximumSuppressionBruteForce(cv::Mat& image, std::vector<cv::KeyPoint>& keyPoints, const NmsParams& nmsParams,
+                                     int keyPointSize) {
   for (size_t i = 0; i < image.rows; i++) {
     for (size_t j = 0; j < image.cols; j++) {
       int response = static_cast<int>(image.at<float>(i, j));
@@ -48,23 +46,30 @@ void nonMaximumSuppression(cv::Mat& image, std::vector<cv::KeyPoint>& keyPoints,
     }
   }
 }
-void cornernessHarris() {
+
+// Harris response of img1.png normalized to [0..255]
+void harrisResponse(cv::Mat& dst_norm, cv::Mat& dst_norm_scaled, int apertureSize) {
   // load image from file
   cv::Mat img;
   img = cv::imread("../images/img1.png");
   cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);  // convert to grayscale
 
   // Detector parameters
-  int blockSize = 2;     // for every pixel, a blockSize × blockSize neighborhood is considered
-  int apertureSize = 3;  // aperture parameter for Sobel operator (must be odd)
-  double k = 0.04;       // Harris parameter (see equation for details)
+  int blockSize = 2;  // for every pixel, a blockSize × blockSize neighborhood is considered
+  double k = 0.04;    // Harris parameter (see equation for details)
 
   // Detect Harris corners and normalize output
-  cv::Mat dst, dst_norm, dst_norm_scaled;
+  cv::Mat dst;
   dst = cv::Mat::zeros(img.size(), CV_32FC1);
   cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
   cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
   cv::convertScaleAbs(dst_norm, dst_norm_scaled);
+}
+
+void cornernessHarris() {
+  int apertureSize = 3;  // aperture parameter for Sobel operator (must be odd)
+  cv::Mat dst_norm, dst_norm_scaled;
+  harrisResponse(dst_norm, dst_norm_scaled, apertureSize);
 
   // visualize results
   string windowName = "Harris Corner Detector Response Matrix";
@@ -78,7 +83,8 @@ void cornernessHarris() {
   NmsParams nmsSettings;
   nmsSettings.maxOverlap = 0.0;
   nmsSettings.minResponse = 100;
-  nonMaximumSuppression(dst_norm, keyPoints, nmsSettings, apertureSize);
+  nmsSettings.keypointSize = 2 * apertureSize;
+  nonMaximumSuppression(dst_norm, keyPoints, nmsSettings);
 
   windowName = "Harris Corner Detection Results";
   cv::namedWindow(windowName, 5);
@@ -92,4 +98,35 @@ void cornernessHarris() {
   }  // wait for keyboard input before continuing
 }
 
-int main() { cornernessHarris(); }
\ No newline at end of file
+// Compare brute force and spatial hash NMS on img1.png for several minResponse levels
+void benchmarkNms() {
+  int apertureSize = 3;
+  cv::Mat dst_norm, dst_norm_scaled;
+  harrisResponse(dst_norm, dst_norm_scaled, apertureSize);
+
+  int minResponses[] = {25, 50, 75, 100, 150};
+  for (int minResponse : minResponses) {
+    NmsParams nmsSettings;
+    nmsSettings.minResponse = minResponse;
+    nmsSettings.keypointSize = 2 * apertureSize;
+
+    std::vector<cv::KeyPoint> bruteForceKpts, gridKpts;
+    double t = (double)cv::getTickCount();
+    nonMaximumSuppressionBruteForce(dst_norm, bruteForceKpts, nmsSettings, apertureSize);
+    double tBruteForce = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+    t = (double)cv::getTickCount();
+    nonMaximumSuppression(dst_norm, gridKpts, nmsSettings);
+    double tGrid = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+
+    cout << "minResponse=" << minResponse << " : brute force n=" << bruteForceKpts.size() << " in " << 1000 * tBruteForce
+         << " ms, spatial hash n=" << gridKpts.size() << " in " << 1000 * tGrid << " ms" << endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && string(argv[1]) == "--benchmark") {
+    benchmarkNms();
+  } else {
+    cornernessHarris();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+
+#include "keypointNms.h"
+
+void nonMaximumSuppression(const cv::Mat &response, std::vector<cv::KeyPoint> &keypoints, const NmsParams &params) {
+  CV_Assert(response.type() == CV_32FC1);
+  std::vector<cv::KeyPoint> candidates;
+  for (int y = 0; y < response.rows; ++y) {
+    const float *row = response.ptr<float>(y);
+    for (int x = 0; x < response.cols; ++x) {
+      if (row[x] > params.minResponse) {
+        candidates.push_back(
+            cv::KeyPoint(static_cast<float>(x), static_cast<float>(y), params.keypointSize, -1, row[x]));
+      }
+    }
+  }
+  nonMaximumSuppression(candidates, params.maxOverlap);
+  keypoints.insert(keypoints.end(), candidates.begin(), candidates.end());
+}
+
+void nonMaximumSuppression(std::vector<cv::KeyPoint> &keypoints, double maxOverlap) {
+  if (keypoints.size() < 2) {
+    return;
+  }
+  // stable sort, so keypoints with equal response are visited in their original order
+  std::stable_sort(keypoints.begin(), keypoints.end(),
+                   [](const cv::KeyPoint &kpt1, const cv::KeyPoint &kpt2) { return kpt1.response > kpt2.response; });
+
+  float minX = keypoints[0].pt.x, maxX = minX;
+  float minY = keypoints[0].pt.y, maxY = minY;
+  float maxDiameter = 0.f;
+  for (const auto &kpt : keypoints) {
+    minX = std::min(minX, kpt.pt.x);
+    maxX = std::max(maxX, kpt.pt.x);
+    minY = std::min(minY, kpt.pt.y);
+    maxY = std::max(maxY, kpt.pt.y);
+    maxDiameter = std::max(maxDiameter, kpt.size);
+  }
+  // two keypoints can only overlap if they are closer than the largest diameter, hence cells of that size guarantee
+  // that overlapping keypoints are in neighbouring cells; cells are enlarged for sparse keypoints to bound the grid
+  float width = maxX - minX + 1.f;
+  float height = maxY - minY + 1.f;
+  float cellSize = std::max(std::max(maxDiameter, 1.f), std::sqrt(width * height / keypoints.size()));
+  int gridCols = static_cast<int>(width / cellSize) + 1;
+  int gridRows = static_cast<int>(height / cellSize) + 1;
+
+  // spatial hash: head of the list of kept keypoints per cell and link to the next kept keypoint in the same cell
+  std::vector<int> cellHead(gridRows * gridCols, -1);
+  std::vector<int> nextInCell;
+  nextInCell.reserve(keypoints.size());
+
+  int numKept = 0;
+  for (size_t i = 0; i < keypoints.size(); ++i) {
+    const cv::KeyPoint &kpt = keypoints[i];
+    int cellX = static_cast<int>((kpt.pt.x - minX) / cellSize);
+    int cellY = static_cast<int>((kpt.pt.y - minY) / cellSize);
+
+    bool suppressed = false;
+    for (int y = std::max(cellY - 1, 0); y <= std::min(cellY + 1, gridRows - 1) && !suppressed; ++y) {
+      for (int x = std::max(cellX - 1, 0); x <= std::min(cellX + 1, gridCols - 1) && !suppressed; ++x) {
+        for (int k = cellHead[y * gridCols + x]; k >= 0; k = nextInCell[k]) {
+          if (cv::KeyPoint::overlap(kpt, keypoints[k]) > maxOverlap) {
+            suppressed = true;
+            break;
+          }
+        }
+      }
+    }
+    if (!suppressed) {
+      // kept keypoints are compacted to the front of the vector (numKept <= i)
+      int cell = cellY * gridCols + cellX;
+      keypoints[numKept] = keypoints[i];
+      nextInCell.push_back(cellHead[cell]);
+      cellHead[cell] = numKept;
+      ++numKept;
+    }
+  }
+  keypoints.resize(numKept);
+}
@@ -2,7 +2,7 @@
 
 cd ../build
 
-for i in {0..6}
+for i in {0..9}
 do
    cd ../build
    ./2D_feature_tracking --roi 1 --detector $i --visualize 0
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Compare the OpenCV FAST detector (4) with the in-tree vectorized FAST-SIMD detector (7)
+# on the KITTI images; both use the same threshold and non-maximum suppression,
+# hence the number of keypoints per frame has to be identical.
+
+cd ../build
+
+for j in 4 7
+do
+  cd ../build
+  ./2D_feature_tracking --detector $j --descriptor 0 --matcher 0 --matcher-selector 1 --visualize 0 > /dev/null
+done
+
+for det in FAST FAST-SIMD
+do
+  awk -F, -v det=$det 'NR > 1 { kpts += $4; t += $8; n++ }
+    END { printf "%-10s mean keypoints: %8.1f  mean detection time: %7.3f ms\n", det, kpts / n, t / n }' \
+    ../output/results_${det}_BRISK_summary.csv
+done
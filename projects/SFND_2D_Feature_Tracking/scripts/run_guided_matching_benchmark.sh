@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Global vs. motion-guided brute force matching (kNN selection with ratio test) for the binary descriptors.
+# Guided matching compares each keypoint of the previous frame only with the current frame keypoints within
+# --search-radius of its predicted position; the first frame pair is always matched globally and skipped here.
+# Recall is the share of matches on the exact nearest neighbour over all current frame descriptors.
+
+cd ../build
+
+descriptors=(BRISK AKAZE BRIEF FREAK ORB)
+detectors=(4 2 4 4 4)  # AKAZE descriptors need AKAZE keypoints
+detectorNames=(FAST AKAZE FAST FAST FAST)
+
+report() {
+  awk -F, -v desc=$1 -v matcher="$2" 'NR > 3 { matched += $10; time += $11; recall += $18; n++ }
+    END { printf "%-6s %-32s matches: %7.1f  mean matching: %8.3f ms  recall: %6.2f %%\n", desc, matcher,
+          matched / n, time / n, 100 * recall / n }' ../output/results_$3_$1_summary.csv
+}
+
+for i in {0..4}
+do
+  args="--detector ${detectors[$i]} --descriptor $i --matcher 0 --matcher-selector 1 --eval-recall 1 --visualize 0"
+  ./2D_feature_tracking $args > /dev/null
+  report ${descriptors[$i]} "BRUTE_FORCE (global)" ${detectorNames[$i]}
+  for model in 0 1
+  do
+    for radius in 20 40 80
+    do
+      ./2D_feature_tracking $args --guided-matching 1 --motion-model $model --search-radius $radius > /dev/null
+      report ${descriptors[$i]} "guided model=$model radius=$radius" ${detectorNames[$i]}
+    done
+  done
+done
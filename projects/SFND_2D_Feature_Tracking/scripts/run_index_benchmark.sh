@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Descriptor index build time vs. query time per descriptor type, for brute force (0), FLANN (1), FLANN LSH (2),
+# brute force SIMD (3) and multi-index hashing (4) matching with kNN selection. The index over a frame is built once
+# and queried by the next frame; the first frame has no matches and is skipped.
+
+cd ../build
+
+descriptors=(BRISK AKAZE BRIEF FREAK ORB SIFT)
+detectors=(4 2 4 4 4 6)            # AKAZE descriptors need AKAZE keypoints, SIFT is run on SIFT keypoints
+detectorNames=(FAST AKAZE FAST FAST FAST SIFT)
+matchers=(BRUTE_FORCE FLANN FLANN_LSH BRUTE_FORCE_SIMD MULTI_INDEX_HASH)
+
+for i in {0..5}
+do
+  for m in 0 1 2 3 4
+  do
+    cd ../build
+    ./2D_feature_tracking --detector ${detectors[$i]} --descriptor $i --matcher $m --matcher-selector 1 \
+      --visualize 0 > /dev/null
+    awk -F, -v desc=${descriptors[$i]} -v matcher=${matchers[$m]} 'NR > 2 { build += $16; query += $17; n++ }
+      END { printf "%-6s %-16s mean index build: %8.3f ms  mean query: %8.3f ms\n", desc, matcher, build / n, query / n }' \
+      ../output/results_${detectorNames[$i]}_${descriptors[$i]}_summary.csv
+  done
+done
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Recall / latency of the approximate matchers against brute force for the binary descriptors (NN selection).
+# Recall is the share of matches on the exact nearest neighbour; FLANN (1) indexes the descriptors converted
+# to float vectors, FLANN LSH (2) the binary descriptors with different no. of tables and multi-probe levels.
+
+cd ../build
+
+descriptors=(BRISK AKAZE BRIEF FREAK ORB)
+detectors=(4 2 4 4 4)  # AKAZE descriptors need AKAZE keypoints
+detectorNames=(FAST AKAZE FAST FAST FAST)
+
+report() {
+  awk -F, -v desc=$1 -v matcher="$2" 'NR > 2 { query += $17; recall += $18; n++ }
+    END { printf "%-6s %-28s mean query: %8.3f ms  recall: %6.2f %%\n", desc, matcher, query / n, 100 * recall / n }' \
+    ../output/results_$3_$1_summary.csv
+}
+
+for i in {0..4}
+do
+  cd ../build
+  args="--detector ${detectors[$i]} --descriptor $i --matcher-selector 0 --eval-recall 1 --visualize 0"
+  ./2D_feature_tracking $args --matcher 0 > /dev/null
+  report ${descriptors[$i]} "BRUTE_FORCE" ${detectorNames[$i]}
+  ./2D_feature_tracking $args --matcher 1 > /dev/null
+  report ${descriptors[$i]} "FLANN (float)" ${detectorNames[$i]}
+  for tables in 4 8 12 16
+  do
+    for probe in 0 1 2
+    do
+      ./2D_feature_tracking $args --matcher 2 --lsh-tables $tables --lsh-probe $probe > /dev/null
+      report ${descriptors[$i]} "FLANN_LSH tables=$tables probe=$probe" ${detectorNames[$i]}
+    done
+  done
+done
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Crossover between brute force SIMD (3) and multi-index hashing (4) matching over the no. of keypoints per frame.
+# The detector threshold controller (--target-keypts) sets the keypoint count of FAST; both matchers return the
+# same matches (kNN selection with ratio test), so only index build + query time are compared. The first frame has
+# no matches and is skipped. The crossover is the smallest keypoint count at which multi-index hashing is faster.
+
+cd ../build
+
+descriptors=(BRISK ORB)
+descriptorIds=(0 4)
+targets=(500 1000 2000 3000 4000 6000 8000 12000 16000)
+
+matchTime() {
+  awk -F, 'NR > 2 { kpts += $4; time += $16 + $17; n++ } END { printf "%.0f %.3f\n", kpts / n, time / n }' \
+    ../output/results_FAST_$1_summary.csv
+}
+
+for i in {0..1}
+do
+  crossover=""
+  for target in ${targets[@]}
+  do
+    args="--detector 4 --descriptor ${descriptorIds[$i]} --matcher-selector 1 --target-keypts $target --visualize 0"
+    ./2D_feature_tracking $args --matcher 3 > /dev/null
+    read kpts timeBruteForce <<< $(matchTime ${descriptors[$i]})
+    for bits in 8 16
+    do
+      ./2D_feature_tracking $args --matcher 4 --mih-substring-bits $bits > /dev/null
+      read kptsMih timeMih <<< $(matchTime ${descriptors[$i]})
+      printf "%-6s keypoints: %6d  BRUTE_FORCE_SIMD: %8.3f ms  MULTI_INDEX_HASH (%2d bit): %8.3f ms\n" \
+        ${descriptors[$i]} $kpts $timeBruteForce $bits $timeMih
+      if [ -z "$crossover" ] && awk -v mih=$timeMih -v bf=$timeBruteForce 'BEGIN { exit !(mih < bf) }'; then
+        crossover="$kpts keypoints ($bits bit substrings)"
+      fi
+    done
+  done
+  echo "${descriptors[$i]} crossover: ${crossover:-not reached}"
+done
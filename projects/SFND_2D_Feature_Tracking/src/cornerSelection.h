@@ -0,0 +1,43 @@
+#ifndef cornerSelection_h
+#define cornerSelection_h
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* Bounded-cost Shi-Tomasi / Harris corner selection.
+ *
+ * cv::goodFeaturesToTrack sorts all local maxima of the response and filters them by distance, hence its cost grows
+ * with the texture of the scene. Here the response is computed in parallel image stripes, the 3x3 local maxima are
+ * selected on a regular grid keeping at most maxPerCell corners per cell, and the strongest maxCorners are retained
+ * with a bounded min-heap. The selection cost is therefore bounded by the grid size and maxCorners.
+ * Corners closer than blockSize to a stronger one are suppressed (spatial hash NMS), as with the minDistance of
+ * cv::goodFeaturesToTrack.
+ */
+struct CornerSelectionConf {
+  int blockSize = 4;           // neighbourhood size for the derivative covariation matrix
+  int apertureSize = 3;        // aperture of the Sobel operator
+  double k = 0.04;             // Harris free parameter
+  double qualityLevel = 0.01;  // min. accepted response relative to the strongest response in the image
+  int cellSize = 16;           // grid cell size in pixels
+  int maxPerCell = 4;          // hard cap on the number of corners kept per grid cell
+  int maxCorners = 2000;       // global cap on the number of corners (strongest by response)
+  double maxOverlap = 0.0;     // max. permissible overlap between two corners, no NMS if >= 1
+};
+
+struct CornerSelectionStats {
+  int numCandidates = 0;  // local maxima left after the per-cell cap
+  int numSelected = 0;    // corners left after the global cap
+  double responseTimeSec = 0;
+  double selectionTimeSec = 0;
+};
+
+// Append the selected corners to keypoints, sorted in descending response order
+CornerSelectionStats selectCornersBounded(std::vector<cv::KeyPoint> &keypoints, const cv::Mat &img, bool useHarris,
+                                          const CornerSelectionConf &conf = CornerSelectionConf());
+
+void computeCornerResponse(const cv::Mat &img, cv::Mat &response, bool useHarris, const CornerSelectionConf &conf);
+void selectCornersOnGrid(const cv::Mat &response, float minResponse, const CornerSelectionConf &conf,
+                         std::vector<cv::KeyPoint> &candidates);
+void retainStrongest(std::vector<cv::KeyPoint> &keypoints, int maxCorners);
+
+#endif /* cornerSelection_h */
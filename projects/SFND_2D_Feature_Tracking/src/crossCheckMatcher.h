@@ -0,0 +1,19 @@
+#ifndef crossCheckMatcher_h
+#define crossCheckMatcher_h
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* Brute force k-nearest neighbour matching (k=2) with the distance ratio test and a mutual consistency check.
+ *
+ * cv::BFMatcher only cross-checks nearest neighbour matching (k=1), with kNN selection the cross-check is lost. Here
+ * the distances are computed in tiles of query rows against all train rows (cv::batchDistance, any norm supported by
+ * cv::BFMatcher); each tile yields the two nearest train rows of its query rows and, from the same distances, updates
+ * the nearest query row of every train row. A match passing the ratio test is kept only if its query row is also the
+ * nearest neighbour of its train row, so the cross-check needs no second O(N*M) pass in the reverse direction.
+ * Ties are resolved in favour of the lower index in both directions, matches are returned in query order.
+ */
+void matchKnnCrossCheck(const cv::Mat &descQuery, const cv::Mat &descTrain, int normType,
+                        std::vector<cv::DMatch> &matches, double maxRatio = 0.8);
+
+#endif /* crossCheckMatcher_h */
@@ -1,26 +1,57 @@
 #ifndef dataStructures_h
 #define dataStructures_h
 
+#include <memory>
 #include <opencv2/core.hpp>
 #include <vector>
 
-enum class DetectorMethod { SHITOMASI = 0, HARRIS, AKAZE, BRISK, FAST, ORB, SIFT };
+enum class DetectorMethod { SHITOMASI = 0, HARRIS, AKAZE, BRISK, FAST, ORB, SIFT, FAST_SIMD, SHITOMASI_GRID, HARRIS_GRID };
 
 enum class DescriptorMethod { BRISK = 0, AKAZE, BRIEF, FREAK, ORB, SIFT };
 
 enum class DescriptorMetric { BINARY = 0, HOG };
 
-enum class MatcherMethod { BRUTE_FORCE = 0, FLANN };
+enum class MatcherMethod { BRUTE_FORCE = 0, FLANN, FLANN_LSH, BRUTE_FORCE_SIMD, MULTI_INDEX_HASH };
 
 enum class NeighborSelectorMethod { NN = 0, kNN };  // NearestNeighbor, kNearestNeighbor
 
+enum class MotionModel { MEDIAN_FLOW = 0, HOMOGRAPHY };  // keypoint motion between two frames
+
+struct LshIndexConf {       // FLANN LSH index over binary descriptors (MatcherMethod::FLANN_LSH)
+  int tableNumber = 12;     // no. of hash tables
+  int keySize = 20;         // no. of descriptor bits hashed per table
+  int multiProbeLevel = 2;  // neighbouring buckets probed per table, 0 = exact bucket only
+};
+
+struct MihIndexConf {      // multi-index hashing over binary descriptors (MatcherMethod::MULTI_INDEX_HASH)
+  int substringBits = 16;  // bits per hashed descriptor substring (8 or 16)
+  int maxRadius = 0;       // max. Hamming distance of a match, 0 = exact nearest neighbours
+};
+
+struct GuidedMatchingConf {                           // motion-guided descriptor matching, see guidedMatching.h
+  bool enabled = false;
+  float searchRadius = 40;                            // half size of the search window around the prediction [px]
+  MotionModel motionModel = MotionModel::HOMOGRAPHY;  // motion model used to predict the keypoint positions
+  double ransacReprojThreshold = 3.0;                 // max. reprojection error of a homography inlier [px]
+  int minMatches = 8;                                 // min. no. of matches to estimate the motion of a frame pair
+};
+
+struct DescriptorIndex;  // see descriptorIndex.h
+struct DescriptorArena;  // see descriptorArena.h
+
 struct DataFrame {  // represents the available sensor information at the same time instance
 
   cv::Mat cameraImg;  // camera image
 
   std::vector<cv::KeyPoint> keypoints;  // 2D keypoints within camera image
-  cv::Mat descriptors;                  // keypoint descriptors
+  cv::Mat descriptors;                  // keypoint descriptors (rows in descriptorArena)
+  // aligned, padded storage of the descriptors, handed on to the next frame when the frame leaves the ring buffer
+  std::shared_ptr<DescriptorArena> descriptorArena;
+  // matcher trained on the descriptors, built once when the frame is first matched as the previous frame (or as the
+  // current frame by the fallback of guided matching)
+  std::shared_ptr<DescriptorIndex> descriptorIndex;
   std::vector<cv::DMatch> kptMatches;   // keypoint matches between previous and current frame
+  cv::Mat keypointMotion;               // 3x3 homography from previous to current frame keypoints, empty if unknown
 };
 
 struct DetectionResult {
@@ -37,8 +68,16 @@ struct DetectionResult {
 
   double detectionComputeTimeSec = 0;
   double descriptorComputeTimeSec = 0;
-  double matchesComputeTimeSec = 0;
+  double matchesComputeTimeSec = 0;  // index build + query
+  double indexBuildTimeSec = 0;      // 0 if the descriptor index of the previous frame was reused
+  double indexQueryTimeSec = 0;
+  double matcherRecall = 0;          // share of matches on the exact (brute force) nearest neighbour, if evaluated
   double totalComputationTimeSec = 0;
+
+  // detector threshold controller state (all zero if the controller is disabled)
+  double detectorThreshold = 0;    // detector parameter used for this frame
+  double controllerError = 0;      // relative deviation of the frame from the controller target
+  bool thresholdAdjusted = false;  // parameter changed for the next frame
 };
 
 struct Distribution {
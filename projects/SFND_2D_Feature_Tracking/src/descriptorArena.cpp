@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "descriptorArena.h"
+
+namespace {
+
+DescriptorTraits makeTraits(int type, int cols) {
+  DescriptorTraits traits;
+  traits.type = type;
+  traits.cols = cols;
+  traits.rowBytes = cols * static_cast<int>(CV_ELEM_SIZE(type));
+  int numChunks = (traits.rowBytes + kDescriptorRowPadding - 1) / kDescriptorRowPadding;
+  traits.paddedRowBytes = numChunks * kDescriptorRowPadding;
+  return traits;
+}
+
+// Make room for capacity bytes; the old content is dropped
+void reserveArena(DescriptorArena &arena, size_t capacity) {
+  // grow by at least 50 % so a slowly rising no. of keypoints does not allocate every frame
+  capacity = std::max(capacity, arena.capacity + arena.capacity / 2);
+  arena.memory.reset(new uchar[capacity + kDescriptorAlignment]);
+  void *aligned = arena.memory.get();
+  size_t space = capacity + kDescriptorAlignment;
+  arena.data = static_cast<uchar *>(std::align(kDescriptorAlignment, capacity, aligned, space));
+  arena.capacity = capacity;
+  ++arena.numAllocations;
+}
+
+}  // namespace
+
+DescriptorTraits getDescriptorTraits(DescriptorMethod descriptorMethod) {
+  switch (descriptorMethod) {
+    case DescriptorMethod::BRISK:
+      return makeTraits(CV_8U, 64);
+    case DescriptorMethod::AKAZE:
+      return makeTraits(CV_8U, 61);  // MLDB with 486 bits
+    case DescriptorMethod::BRIEF:
+      return makeTraits(CV_8U, 64);
+    case DescriptorMethod::FREAK:
+      return makeTraits(CV_8U, 64);
+    case DescriptorMethod::ORB:
+      return makeTraits(CV_8U, 32);
+    case DescriptorMethod::SIFT:
+      return makeTraits(CV_32F, 128);
+    default:
+      return DescriptorTraits();
+  }
+}
+
+double storeDescriptors(DataFrame &frame, const cv::Mat &descriptors, const DescriptorTraits &traits) {
+  if (descriptors.empty()) {
+    frame.descriptors = descriptors;
+    return 0.0;
+  }
+  double t = (double)cv::getTickCount();
+  DescriptorTraits layout = traits;
+  if (descriptors.type() != traits.type || descriptors.cols != traits.cols) {
+    std::cout << "Descriptors (" << descriptors.cols << " columns, type " << descriptors.type()
+              << ") differ from the expected layout, using their own layout" << std::endl;
+    layout = makeTraits(descriptors.type(), descriptors.cols);
+  }
+  if (!frame.descriptorArena) {
+    frame.descriptorArena = std::make_shared<DescriptorArena>();
+  }
+  DescriptorArena &arena = *frame.descriptorArena;
+  size_t required = static_cast<size_t>(descriptors.rows) * layout.paddedRowBytes;
+  if (required > arena.capacity) {
+    reserveArena(arena, required);
+  }
+  for (int i = 0; i < descriptors.rows; ++i) {
+    uchar *row = arena.data + static_cast<size_t>(i) * layout.paddedRowBytes;
+    std::memcpy(row, descriptors.ptr(i), layout.rowBytes);
+    std::memset(row + layout.rowBytes, 0, layout.paddedRowBytes - layout.rowBytes);
+  }
+  arena.traits = layout;
+  arena.numRows = descriptors.rows;
+  frame.descriptors = cv::Mat(descriptors.rows, layout.cols, layout.type, arena.data, layout.paddedRowBytes);
+  return ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+}
+
+int paddedRowBytes(const DataFrame &previousFrame, const DataFrame &currentFrame) {
+  const DescriptorArena *previousArena = previousFrame.descriptorArena.get();
+  const DescriptorArena *currentArena = currentFrame.descriptorArena.get();
+  if (previousArena == nullptr || currentArena == nullptr) {
+    return 0;
+  }
+  // the descriptors may have been replaced after they were stored
+  if (previousFrame.descriptors.data != previousArena->data || currentFrame.descriptors.data != currentArena->data) {
+    return 0;
+  }
+  if (previousFrame.descriptors.rows != previousArena->numRows ||
+      currentFrame.descriptors.rows != currentArena->numRows) {
+    return 0;
+  }
+  if (previousArena->traits.type != currentArena->traits.type ||
+      previousArena->traits.paddedRowBytes != currentArena->traits.paddedRowBytes) {
+    return 0;
+  }
+  return previousArena->traits.paddedRowBytes;
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+
+#include "descriptorIndex.h"
+
+namespace {
+
+// cv::BFMatcher cross-checks nearest neighbour matching only, kNN matching with cross-check scans trainDescriptors
+void createBruteForceMatcher(DescriptorIndex &index, const cv::Mat &descriptors) {
+  index.matcher = cv::BFMatcher::create(index.normType, index.crossCheck);
+  if (index.crossCheck) {
+    index.trainDescriptors = descriptors;
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<DescriptorIndex> buildDescriptorIndex(const cv::Mat &descriptors, MatcherMethod matcherMethod,
+                                                      int normType, bool crossCheck, const LshIndexConf &lshConf,
+                                                      const MihIndexConf &mihConf) {
+  std::shared_ptr<DescriptorIndex> index = std::make_shared<DescriptorIndex>();
+  index->matcherMethod = matcherMethod;
+  index->normType = normType;
+  index->crossCheck = crossCheck;
+  bool binaryDescriptors = descriptors.depth() == CV_8U;
+  switch (matcherMethod) {
+    case MatcherMethod::FLANN_LSH:
+      if (binaryDescriptors) {
+        index->matcher = cv::makePtr<cv::FlannBasedMatcher>(cv::makePtr<cv::flann::LshIndexParams>(
+            lshConf.tableNumber, lshConf.keySize, lshConf.multiProbeLevel));
+        break;
+      }
+      std::cout << "LSH requires binary descriptors! Using the FLANN KD-tree" << std::endl;
+      index->matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
+      break;
+    case MatcherMethod::FLANN:
+      // the KD-tree works on CV_32F only, binary descriptors are indexed as float vectors with the L2 norm
+      index->floatDescriptors = binaryDescriptors;
+      index->matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
+      break;
+    case MatcherMethod::BRUTE_FORCE_SIMD:
+      if (binaryDescriptors && normType == cv::NORM_HAMMING) {
+        index->trainDescriptors = descriptors;
+        index->numDescriptors = descriptors.rows;
+        return index;
+      }
+      if (descriptors.type() == CV_32F && normType == cv::NORM_L2) {
+        // the float descriptors are packed into the panels of the blocked matrix product
+        double t = (double)cv::getTickCount();
+        index->l2Index = buildL2MatcherIndex(descriptors);
+        index->buildTimeSec = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+        index->numDescriptors = descriptors.rows;
+        return index;
+      }
+      std::cout << "BRUTE_FORCE_SIMD supports binary (Hamming) and float (L2) descriptors only! Using BRUTE_FORCE"
+                << std::endl;
+      createBruteForceMatcher(*index, descriptors);
+      break;
+    case MatcherMethod::MULTI_INDEX_HASH:
+      if (binaryDescriptors && normType == cv::NORM_HAMMING && !crossCheck) {
+        double t = (double)cv::getTickCount();
+        index->multiIndexHash = buildMultiIndexHash(descriptors, mihConf.substringBits);
+        index->buildTimeSec = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+        index->numDescriptors = descriptors.rows;
+        return index;
+      }
+      std::cout << "MULTI_INDEX_HASH supports binary descriptors without cross-check only! Using BRUTE_FORCE"
+                << std::endl;
+      createBruteForceMatcher(*index, descriptors);
+      break;
+    case MatcherMethod::BRUTE_FORCE:
+      createBruteForceMatcher(*index, descriptors);
+      break;
+    default:
+      std::cout << "Unknown descriptor matcher method! Defaulting to BRUTE_FORCE" << std::endl;
+      createBruteForceMatcher(*index, descriptors);
+      break;
+  }
+
+  // FLANN builds its search index in train(), brute force only keeps a reference to the descriptors
+  double t = (double)cv::getTickCount();
+  index->matcher->add(std::vector<cv::Mat>(1, toIndexDescriptors(*index, descriptors)));
+  index->matcher->train();
+  index->buildTimeSec = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+  index->numDescriptors = descriptors.rows;
+  return index;
+}
+
+bool isDescriptorIndexValid(const std::shared_ptr<DescriptorIndex> &index, MatcherMethod matcherMethod, int normType,
+                            bool crossCheck) {
+  return index != nullptr && index->matcherMethod == matcherMethod && index->normType == normType &&
+         index->crossCheck == crossCheck;
+}
+
+cv::Mat toIndexDescriptors(const DescriptorIndex &index, const cv::Mat &descriptors) {
+  if (!index.floatDescriptors || descriptors.type() == CV_32F) {
+    // FLANN expects continuous rows, descriptors in an arena may have padded rows (descriptorArena.h)
+    bool flann = index.matcherMethod == MatcherMethod::FLANN || index.matcherMethod == MatcherMethod::FLANN_LSH;
+    return flann && !descriptors.isContinuous() ? descriptors.clone() : descriptors;
+  }
+  cv::Mat converted;
+  descriptors.convertTo(converted, CV_32F);
+  return converted;
+}
+
+double evaluateMatchRecall(const cv::Mat &descPrevious, const cv::Mat &descCurrent,
+                           const std::vector<cv::DMatch> &matches, int normType) {
+  if (matches.empty()) {
+    return 0.0;
+  }
+  std::vector<cv::DMatch> exactMatches;
+  cv::BFMatcher::create(normType)->match(descCurrent, descPrevious, exactMatches);
+  std::vector<float> exactDistance(descCurrent.rows, -1.f);
+  std::vector<int> exactNeighbour(descCurrent.rows, -1);
+  for (const auto &match : exactMatches) {
+    exactDistance[match.queryIdx] = match.distance;
+    exactNeighbour[match.queryIdx] = match.trainIdx;
+  }
+
+  int numHits = 0;
+  for (const auto &match : matches) {
+    int curr = match.trainIdx;
+    if (exactNeighbour[curr] == match.queryIdx) {
+      ++numHits;
+    } else if (exactNeighbour[curr] >= 0) {
+      // a different neighbour at the same distance is as good as the exact one
+      double distance = cv::norm(descCurrent.row(curr), descPrevious.row(match.queryIdx), normType);
+      numHits += distance <= exactDistance[curr] ? 1 : 0;
+    }
+  }
+  return static_cast<double>(numHits) / matches.size();
+}
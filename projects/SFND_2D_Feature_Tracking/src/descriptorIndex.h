@@ -0,0 +1,59 @@
+#ifndef descriptorIndex_h
+#define descriptorIndex_h
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "dataStructures.h"
+#include "l2Matcher.h"
+#include "multiIndexHash.h"
+
+/* Matcher trained with the descriptors of a single frame.
+ *
+ * The index is built once per frame, the first time the frame is used as the train side of a frame pair, and is kept
+ * in the ring buffer next to the descriptors (DataFrame::descriptorIndex). Later frame pairs query it with the
+ * descriptors of the newer frame, hence a FLANN index is never rebuilt for descriptors which have been indexed before.
+ *
+ * FLANN_LSH indexes binary descriptors as they are (CV_8U, Hamming distance). The KD-tree of FLANN only supports
+ * CV_32F, hence for binary descriptors FLANN indexes a converted copy and the queries are converted as well
+ * (floatDescriptors); the descriptors of the frame are never modified.
+ * BRUTE_FORCE_SIMD has no matcher object: the in-tree Hamming kernel (hammingMatcher.h) scans trainDescriptors,
+ * float descriptors are matched by the blocked matrix product of l2Matcher.h over the packed l2Index.
+ * Brute force matchers with cross-check keep trainDescriptors as well, kNN matching with cross-check is done by
+ * matchKnnCrossCheck (crossCheckMatcher.h) as cv::BFMatcher only cross-checks nearest neighbour matching.
+ * MULTI_INDEX_HASH has no matcher object either, the queries are answered by the hash tables of multiIndexHash.
+ */
+struct DescriptorIndex {
+  cv::Ptr<cv::DescriptorMatcher> matcher;
+  MatcherMethod matcherMethod = MatcherMethod::BRUTE_FORCE;
+  int normType = cv::NORM_HAMMING;
+  bool crossCheck = false;
+  bool floatDescriptors = false;                   // queries have to be converted to CV_32F
+  cv::Mat trainDescriptors;                        // BRUTE_FORCE_SIMD and cross-checked brute force
+  std::shared_ptr<MultiIndexHash> multiIndexHash;  // MULTI_INDEX_HASH only
+  std::shared_ptr<L2MatcherIndex> l2Index;         // BRUTE_FORCE_SIMD with float descriptors only
+  int numDescriptors = 0;
+  double buildTimeSec = 0;
+};
+
+std::shared_ptr<DescriptorIndex> buildDescriptorIndex(const cv::Mat &descriptors, MatcherMethod matcherMethod,
+                                                      int normType, bool crossCheck,
+                                                      const LshIndexConf &lshConf = LshIndexConf(),
+                                                      const MihIndexConf &mihConf = MihIndexConf());
+
+// True if the index exists and has been built with the given matcher configuration
+bool isDescriptorIndexValid(const std::shared_ptr<DescriptorIndex> &index, MatcherMethod matcherMethod, int normType,
+                            bool crossCheck);
+
+// Descriptors in the representation expected by the index (shares the data unless a conversion or copy is needed)
+cv::Mat toIndexDescriptors(const DescriptorIndex &index, const cv::Mat &descriptors);
+
+// Fraction of the matches (queryIdx = previous, trainIdx = current frame) whose previous frame descriptor is the exact
+// nearest neighbour (brute force, ties by distance count as hits) of the current frame descriptor
+double evaluateMatchRecall(const cv::Mat &descPrevious, const cv::Mat &descCurrent,
+                           const std::vector<cv::DMatch> &matches, int normType);
+
+#endif /* descriptorIndex_h */
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "fastCorners.h"
+
+/* NOTE
+ * The segment test and the corner score follow the reference implementation of OpenCV (features2d/src/fast.cpp,
+ * FAST_t<16> and cornerScore<16>) so that both detectors report identical keypoints:
+ *  - a pixel p is a corner if at least 9 contiguous circle pixels are all brighter than I(p) + threshold or all
+ *    darker than I(p) - threshold
+ *  - the corner score is the largest threshold for which p would still be detected as a corner, minus one
+ *  - non-maximum suppression keeps a corner only if its score is strictly larger than the score of all 8 neighbours
+ */
+
+namespace {
+
+const int kPatternSize = 16;  // no. of pixels on the Bresenham circle of radius 3
+const int kArcLength = 9;  // no. of contiguous pixels required for a corner
+const int kNumOffsets = kPatternSize + kArcLength;  // circle offsets repeated to handle the wrap-around
+const int kBorder = 3;  // circle radius, no corners are detected closer to the border
+const float kKeypointSize = 7.f;  // keypoint diameter reported by OpenCV for FAST-9
+
+void makeCircleOffsets(int pixel[kNumOffsets], int rowStride) {
+  static const int offsets16[kPatternSize][2] = {
+    {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3},
+    {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3}};
+  for (int k = 0; k < kPatternSize; ++k) {
+    pixel[k] = offsets16[k][0] + offsets16[k][1] * rowStride;
+  }
+  for (int k = kPatternSize; k < kNumOffsets; ++k) {
+    pixel[k] = pixel[k - kPatternSize];
+  }
+}
+
+bool isCornerScalar(const uchar *ptr, const int pixel[kNumOffsets], int threshold) {
+  int v = ptr[0];
+  int darker = v - threshold, brighter = v + threshold;
+
+  // quick rejection: any arc of 9 pixels covers two neighbouring compass points (0/4/8/12)
+  int state[4];
+  for (int k = 0; k < 4; ++k) {
+    int x = ptr[pixel[4 * k]];
+    state[k] = (x < darker ? 1 : 0) | (x > brighter ? 2 : 0);
+  }
+  if (((state[0] & state[1]) | (state[1] & state[2]) | (state[2] & state[3]) | (state[3] & state[0])) == 0) {
+    return false;
+  }
+
+  int countDarker = 0, countBrighter = 0;
+  for (int k = 0; k < kNumOffsets; ++k) {
+    int x = ptr[pixel[k]];
+    countDarker = x < darker ? countDarker + 1 : 0;
+    countBrighter = x > brighter ? countBrighter + 1 : 0;
+    if (countDarker >= kArcLength || countBrighter >= kArcLength) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int cornerScoreScalar(const uchar *ptr, const int pixel[kNumOffsets], int threshold) {
+  int v = ptr[0];
+  short d[kNumOffsets];
+  for (int k = 0; k < kNumOffsets; ++k) {
+    d[k] = static_cast<short>(v - ptr[pixel[k]]);
+  }
+
+  // largest minimum over all arcs of 9 pixels darker than the center
+  int a0 = threshold;
+  for (int k = 0; k < kPatternSize; k += 2) {
+    int a = std::min(static_cast<int>(d[k + 1]), static_cast<int>(d[k + 2]));
+    a = std::min(a, static_cast<int>(d[k + 3]));
+    if (a <= a0) {
+      continue;
+    }
+    for (int i = 4; i <= 8; ++i) {
+      a = std::min(a, static_cast<int>(d[k + i]));
+    }
+    a0 = std::max(a0, std::min(a, static_cast<int>(d[k])));
+    a0 = std::max(a0, std::min(a, static_cast<int>(d[k + 9])));
+  }
+
+  // smallest maximum over all arcs of 9 pixels brighter than the center
+  int b0 = -a0;
+  for (int k = 0; k < kPatternSize; k += 2) {
+    int b = std::max(static_cast<int>(d[k + 1]), static_cast<int>(d[k + 2]));
+    b = std::max(b, static_cast<int>(d[k + 3]));
+    b = std::max(b, static_cast<int>(d[k + 4]));
+    b = std::max(b, static_cast<int>(d[k + 5]));
+    if (b >= b0) {
+      continue;
+    }
+    for (int i = 6; i <= 8; ++i) {
+      b = std::max(b, static_cast<int>(d[k + i]));
+    }
+    b0 = std::min(b0, std::max(b, static_cast<int>(d[k])));
+    b0 = std::min(b0, std::max(b, static_cast<int>(d[k + 9])));
+  }
+  return -b0 - 1;
+}
+
+// Segment test (and score) for the columns [j, colEnd) of one image row; non-corners are left at 0 in the score row
+void processRowScalar(const uchar *rowPtr, int j, int colEnd, const int pixel[kNumOffsets], int threshold,
+                      bool nonmaxSuppression, uchar *scoreRow) {
+  for (; j < colEnd; ++j) {
+    const uchar *ptr = rowPtr + j;
+    if (isCornerScalar(ptr, pixel, threshold)) {
+      scoreRow[j] = nonmaxSuppression ? static_cast<uchar>(cornerScoreScalar(ptr, pixel, threshold)) : 1;
+    }
+  }
+}
+
+bool isLocalMaximum(const uchar *pprev, const uchar *prev, const uchar *curr, int j) {
+  int score = prev[j];
+  return score > prev[j + 1] && score > prev[j - 1] && score > pprev[j - 1] && score > pprev[j] &&
+         score > pprev[j + 1] && score > curr[j - 1] && score > curr[j] && score > curr[j + 1];
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+/* Thin wrappers around the 8 bit / 16 bit integer intrinsics used by the kernel so that the same kernel is
+ * instantiated for 256 bit (AVX2) and 128 bit (SSE2) registers. unpack/pack operate per 128 bit lane for AVX2,
+ * the lane order is therefore restored when packing the 16 bit scores back to 8 bit.
+ */
+#if defined(__AVX2__)
+struct SimdOps {
+  typedef __m256i Vec;
+  static const int kLanes = 32;
+  static const unsigned int kLaneMask = 0xFFFFFFFFu;
+  static Vec load(const uchar *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+  static void store(uchar *p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+  static Vec set1(int v) { return _mm256_set1_epi8(static_cast<char>(v)); }
+  static Vec set1_16(int v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+  static Vec zero() { return _mm256_setzero_si256(); }
+  static Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+  static Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+  static Vec bitXor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+  static Vec add(Vec a, Vec b) { return _mm256_add_epi8(a, b); }
+  static Vec addsU(Vec a, Vec b) { return _mm256_adds_epu8(a, b); }
+  static Vec subsU(Vec a, Vec b) { return _mm256_subs_epu8(a, b); }
+  static Vec minU(Vec a, Vec b) { return _mm256_min_epu8(a, b); }
+  static Vec maxU(Vec a, Vec b) { return _mm256_max_epu8(a, b); }
+  static Vec gtS(Vec a, Vec b) { return _mm256_cmpgt_epi8(a, b); }
+  static Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+  static unsigned int moveMask(Vec a) { return static_cast<unsigned int>(_mm256_movemask_epi8(a)); }
+  static Vec unpackLo(Vec a) { return _mm256_unpacklo_epi8(a, zero()); }
+  static Vec unpackHi(Vec a) { return _mm256_unpackhi_epi8(a, zero()); }
+  static Vec sub16(Vec a, Vec b) { return _mm256_sub_epi16(a, b); }
+  static Vec min16(Vec a, Vec b) { return _mm256_min_epi16(a, b); }
+  static Vec max16(Vec a, Vec b) { return _mm256_max_epi16(a, b); }
+  static Vec packU16(Vec a, Vec b) { return _mm256_packus_epi16(a, b); }
+  static const char *name() { return "AVX2"; }
+};
+#else
+struct SimdOps {
+  typedef __m128i Vec;
+  static const int kLanes = 16;
+  static const unsigned int kLaneMask = 0xFFFFu;
+  static Vec load(const uchar *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+  static void store(uchar *p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+  static Vec set1(int v) { return _mm_set1_epi8(static_cast<char>(v)); }
+  static Vec set1_16(int v) { return _mm_set1_epi16(static_cast<short>(v)); }
+  static Vec zero() { return _mm_setzero_si128(); }
+  static Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+  static Vec bitXor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+  static Vec add(Vec a, Vec b) { return _mm_add_epi8(a, b); }
+  static Vec addsU(Vec a, Vec b) { return _mm_adds_epu8(a, b); }
+  static Vec subsU(Vec a, Vec b) { return _mm_subs_epu8(a, b); }
+  static Vec minU(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+  static Vec maxU(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+  static Vec gtS(Vec a, Vec b) { return _mm_cmpgt_epi8(a, b); }
+  static Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+  static unsigned int moveMask(Vec a) { return static_cast<unsigned int>(_mm_movemask_epi8(a)); }
+  static Vec unpackLo(Vec a) { return _mm_unpacklo_epi8(a, zero()); }
+  static Vec unpackHi(Vec a) { return _mm_unpackhi_epi8(a, zero()); }
+  static Vec sub16(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+  static Vec min16(Vec a, Vec b) { return _mm_min_epi16(a, b); }
+  static Vec max16(Vec a, Vec b) { return _mm_max_epi16(a, b); }
+  static Vec packU16(Vec a, Vec b) { return _mm_packus_epi16(a, b); }
+  static const char *name() { return "SSE2"; }
+};
+#endif
+
+typedef SimdOps::Vec Vec;
+
+// Corner score of all lanes (16 bit) given the center values and the 16 circle pixels widened to 16 bit
+Vec cornerScoreLanes(const Vec center, const Vec circle[kPatternSize]) {
+  Vec d[kNumOffsets];
+  for (int k = 0; k < kPatternSize; ++k) {
+    d[k] = SimdOps::sub16(center, circle[k]);
+  }
+  for (int k = kPatternSize; k < kNumOffsets; ++k) {
+    d[k] = d[k - kPatternSize];
+  }
+
+  Vec q0 = SimdOps::set1_16(-1000);
+  Vec q1 = SimdOps::set1_16(1000);
+  for (int k = 0; k < kPatternSize; k += 2) {
+    Vec a = SimdOps::min16(d[k + 1], d[k + 2]);
+    Vec b = SimdOps::max16(d[k + 1], d[k + 2]);
+    for (int i = 3; i <= 8; ++i) {
+      a = SimdOps::min16(a, d[k + i]);
+      b = SimdOps::max16(b, d[k + i]);
+    }
+    q0 = SimdOps::max16(q0, SimdOps::min16(a, d[k]));
+    q1 = SimdOps::min16(q1, SimdOps::max16(b, d[k]));
+    q0 = SimdOps::max16(q0, SimdOps::min16(a, d[k + 9]));
+    q1 = SimdOps::min16(q1, SimdOps::max16(b, d[k + 9]));
+  }
+  q0 = SimdOps::max16(q0, SimdOps::sub16(SimdOps::zero(), q1));
+  return SimdOps::sub16(q0, SimdOps::set1_16(1));
+}
+
+// Vectorized segment test and score for one row; returns the first column which has not been processed
+int processRowSimd(const uchar *rowPtr, int j, int colEnd, const int pixel[kNumOffsets], int threshold,
+                   bool nonmaxSuppression, uchar *scoreRow) {
+  const Vec signFlip = SimdOps::set1(0x80);
+  const Vec vThreshold = SimdOps::set1(threshold);
+  const Vec one = SimdOps::set1(1);
+  const Vec minArc = SimdOps::set1(kArcLength - 1);
+
+  for (; j + SimdOps::kLanes <= colEnd; j += SimdOps::kLanes) {
+    const uchar *ptr = rowPtr + j;
+    Vec v = SimdOps::load(ptr);
+    // signed comparison of unsigned values: flip the sign bit on both sides
+    Vec brighter = SimdOps::bitXor(SimdOps::addsU(v, vThreshold), signFlip);
+    Vec darker = SimdOps::bitXor(SimdOps::subsU(v, vThreshold), signFlip);
+
+    Vec circle[kPatternSize], isBrighter[kPatternSize], isDarker[kPatternSize];
+    for (int k = 0; k < kPatternSize; k += 4) {
+      circle[k] = SimdOps::load(ptr + pixel[k]);
+      Vec x = SimdOps::bitXor(circle[k], signFlip);
+      isBrighter[k] = SimdOps::gtS(x, brighter);
+      isDarker[k] = SimdOps::gtS(darker, x);
+    }
+
+    // quick rejection: any arc of 9 pixels covers two neighbouring compass points (0/4/8/12)
+    Vec candidates = SimdOps::zero();
+    for (int k = 0; k < kPatternSize; k += 4) {
+      int kNext = (k + 4) % kPatternSize;
+      candidates = SimdOps::bitOr(candidates, SimdOps::bitAnd(isBrighter[k], isBrighter[kNext]));
+      candidates = SimdOps::bitOr(candidates, SimdOps::bitAnd(isDarker[k], isDarker[kNext]));
+    }
+    if (SimdOps::moveMask(candidates) == 0) {
+      continue;
+    }
+
+    for (int k = 0; k < kPatternSize; ++k) {
+      if (k % 4 == 0) {
+        continue;
+      }
+      circle[k] = SimdOps::load(ptr + pixel[k]);
+      Vec x = SimdOps::bitXor(circle[k], signFlip);
+      isBrighter[k] = SimdOps::gtS(x, brighter);
+      isDarker[k] = SimdOps::gtS(darker, x);
+    }
+
+    // length of the longest run of brighter/darker pixels around the circle, per lane
+    Vec runBrighter = SimdOps::zero(), runDarker = SimdOps::zero();
+    Vec maxBrighter = SimdOps::zero(), maxDarker = SimdOps::zero();
+    for (int k = 0; k < kNumOffsets; ++k) {
+      runBrighter = SimdOps::bitAnd(SimdOps::add(runBrighter, one), isBrighter[k % kPatternSize]);
+      runDarker = SimdOps::bitAnd(SimdOps::add(runDarker, one), isDarker[k % kPatternSize]);
+      maxBrighter = SimdOps::maxU(maxBrighter, runBrighter);
+      maxDarker = SimdOps::maxU(maxDarker, runDarker);
+    }
+    Vec corners = SimdOps::bitOr(SimdOps::gtS(maxBrighter, minArc), SimdOps::gtS(maxDarker, minArc));
+    if (SimdOps::moveMask(corners) == 0) {
+      continue;
+    }
+
+    if (!nonmaxSuppression) {
+      SimdOps::store(scoreRow + j, SimdOps::bitAnd(corners, one));
+      continue;
+    }
+
+    Vec circleLo[kPatternSize], circleHi[kPatternSize];
+    for (int k = 0; k < kPatternSize; ++k) {
+      circleLo[k] = SimdOps::unpackLo(circle[k]);
+      circleHi[k] = SimdOps::unpackHi(circle[k]);
+    }
+    Vec scoreLo = cornerScoreLanes(SimdOps::unpackLo(v), circleLo);
+    Vec scoreHi = cornerScoreLanes(SimdOps::unpackHi(v), circleHi);
+    Vec scores = SimdOps::packU16(scoreLo, scoreHi);
+    SimdOps::store(scoreRow + j, SimdOps::bitAnd(scores, corners));
+  }
+  return j;
+}
+
+// Vectorized 3x3 non-maximum suppression of the score row prev; returns the first column not processed
+int suppressNonMaximaSimd(const uchar *pprev, const uchar *prev, const uchar *curr, int j, int colEnd, int row,
+                          std::vector<cv::KeyPoint> &keypoints) {
+  for (; j + SimdOps::kLanes <= colEnd; j += SimdOps::kLanes) {
+    Vec score = SimdOps::load(prev + j);
+    // score > neighbour <=> saturated difference is non-zero
+    Vec margin = SimdOps::subsU(score, SimdOps::load(prev + j - 1));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(prev + j + 1)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(pprev + j - 1)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(pprev + j)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(pprev + j + 1)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(curr + j - 1)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(curr + j)));
+    margin = SimdOps::minU(margin, SimdOps::subsU(score, SimdOps::load(curr + j + 1)));
+
+    unsigned int maxima = SimdOps::moveMask(SimdOps::eq(margin, SimdOps::zero())) ^ SimdOps::kLaneMask;
+    while (maxima != 0) {
+      int lane = __builtin_ctz(maxima);
+      maxima &= maxima - 1;
+      keypoints.push_back(cv::KeyPoint(static_cast<float>(j + lane), static_cast<float>(row), kKeypointSize,
+                                       -1, static_cast<float>(prev[j + lane])));
+    }
+  }
+  return j;
+}
+
+#endif
+
+}  // namespace
+
+void detectFastCorners(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, int threshold,
+                       bool nonmaxSuppression) {
+  CV_Assert(img.type() == CV_8UC1);
+  keypoints.clear();
+  if (img.rows <= 2 * kBorder || img.cols <= 2 * kBorder) {
+    return;
+  }
+  threshold = std::min(std::max(threshold, 0), 255);
+
+  int pixel[kNumOffsets];
+  makeCircleOffsets(pixel, static_cast<int>(img.step));
+
+  // three rolling score rows (previous-previous, previous and current image row) for the 3x3 suppression
+  int colEnd = img.cols - kBorder;
+  std::vector<uchar> scoreBuffer(3 * img.cols, 0);
+  uchar *scoreRows[3] = {&scoreBuffer[0], &scoreBuffer[img.cols], &scoreBuffer[2 * img.cols]};
+
+  for (int i = kBorder; i < img.rows - kBorder + 1; ++i) {
+    uchar *curr = scoreRows[(i - kBorder) % 3];
+    std::memset(curr, 0, img.cols);
+
+    // the last iteration only flushes the suppression of the previous row
+    if (i < img.rows - kBorder) {
+      const uchar *rowPtr = img.ptr<uchar>(i);
+      int j = kBorder;
+#if defined(__AVX2__) || defined(__SSE2__)
+      j = processRowSimd(rowPtr, j, colEnd, pixel, threshold, nonmaxSuppression, curr);
+#endif
+      processRowScalar(rowPtr, j, colEnd, pixel, threshold, nonmaxSuppression, curr);
+    }
+
+    if (i == kBorder) {
+      continue;
+    }
+    const uchar *prev = scoreRows[(i - kBorder - 1 + 3) % 3];
+    const uchar *pprev = scoreRows[(i - kBorder - 2 + 3) % 3];
+    int row = i - 1;
+    if (!nonmaxSuppression) {
+      for (int j = kBorder; j < colEnd; ++j) {
+        if (prev[j] != 0) {
+          keypoints.push_back(cv::KeyPoint(static_cast<float>(j), static_cast<float>(row), kKeypointSize));
+        }
+      }
+      continue;
+    }
+
+    int j = kBorder;
+#if defined(__AVX2__) || defined(__SSE2__)
+    j = suppressNonMaximaSimd(pprev, prev, curr, j, colEnd, row, keypoints);
+#endif
+    for (; j < colEnd; ++j) {
+      if (isLocalMaximum(pprev, prev, curr, j)) {
+        keypoints.push_back(cv::KeyPoint(static_cast<float>(j), static_cast<float>(row), kKeypointSize, -1,
+                                         static_cast<float>(prev[j])));
+      }
+    }
+  }
+}
+
+void FastCornerDetector::detect(cv::InputArray image, std::vector<cv::KeyPoint> &keypoints, cv::InputArray mask) {
+  detectFastCorners(image.getMat(), keypoints, threshold_, nonmaxSuppression_);
+  if (!mask.empty()) {
+    cv::KeyPointsFilter::runByPixelsMask(keypoints, mask.getMat());
+  }
+}
+
+const char *fastCornersInstructionSet() {
+#if defined(__AVX2__) || defined(__SSE2__)
+  return SimdOps::name();
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef fastCorners_h
+#define fastCorners_h
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <vector>
+
+/* In-tree FAST-9 (9 contiguous pixels on a 16 pixel Bresenham circle) corner detector.
+ *
+ * Produces the same keypoints (position, size=7, response=corner score) and in the same row-major order as
+ * cv::FAST with cv::FastFeatureDetector::TYPE_9_16. The segment test, the corner score and the 3x3 non-maximum
+ * suppression are vectorized and process 32 pixels per iteration with AVX2 or 16 pixels per iteration with SSE2;
+ * a scalar implementation is used for the row tails and on targets without SSE2.
+ * The input image has to be of type CV_8UC1.
+ */
+void detectFastCorners(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, int threshold,
+                       bool nonmaxSuppression = true);
+
+// Name of the instruction set used by detectFastCorners (AVX2, SSE2 or scalar)
+const char *fastCornersInstructionSet();
+
+// cv::FeatureDetector wrapper around detectFastCorners so it can be used wherever an OpenCV detector is expected
+class FastCornerDetector : public cv::Feature2D {
+ public:
+  FastCornerDetector(int threshold, bool nonmaxSuppression)
+    : threshold_(threshold), nonmaxSuppression_(nonmaxSuppression) {}
+
+  static cv::Ptr<FastCornerDetector> create(int threshold = 10, bool nonmaxSuppression = true) {
+    return cv::makePtr<FastCornerDetector>(threshold, nonmaxSuppression);
+  }
+
+  using cv::Feature2D::detect;
+  void detect(cv::InputArray image, std::vector<cv::KeyPoint> &keypoints,
+              cv::InputArray mask = cv::noArray()) override;
+
+ private:
+  int threshold_;
+  bool nonmaxSuppression_;
+};
+
+#endif /* fastCorners_h */
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "descriptorIndex.h"
+#include "guidedMatching.h"
+#include "matching2D.hpp"
+
+namespace {
+
+// Keypoints bucketed in a regular grid; the keypoints of cell c are cellKeypoints[cellStart[c]..cellStart[c + 1])
+struct KeypointGrid {
+  float minX = 0.f;
+  float minY = 0.f;
+  float cellSize = 1.f;
+  int gridCols = 0;
+  int gridRows = 0;
+  std::vector<int> cellStart;
+  std::vector<int> cellKeypoints;
+};
+
+void buildKeypointGrid(const std::vector<cv::KeyPoint> &keypoints, float cellSize, KeypointGrid &grid) {
+  grid.cellSize = std::max(cellSize, 1.f);
+  grid.gridCols = grid.gridRows = 0;
+  grid.cellStart.assign(1, 0);
+  grid.cellKeypoints.clear();
+  if (keypoints.empty()) {
+    return;
+  }
+  float maxX = keypoints[0].pt.x, maxY = keypoints[0].pt.y;
+  grid.minX = maxX;
+  grid.minY = maxY;
+  for (const auto &kpt : keypoints) {
+    grid.minX = std::min(grid.minX, kpt.pt.x);
+    grid.minY = std::min(grid.minY, kpt.pt.y);
+    maxX = std::max(maxX, kpt.pt.x);
+    maxY = std::max(maxY, kpt.pt.y);
+  }
+  grid.gridCols = static_cast<int>((maxX - grid.minX) / grid.cellSize) + 1;
+  grid.gridRows = static_cast<int>((maxY - grid.minY) / grid.cellSize) + 1;
+
+  // counting sort of the keypoint indices by cell, keypoints of a cell keep their index order
+  std::vector<int> cellOfKeypoint(keypoints.size());
+  grid.cellStart.assign(grid.gridRows * grid.gridCols + 1, 0);
+  for (size_t i = 0; i < keypoints.size(); ++i) {
+    int cellX = static_cast<int>((keypoints[i].pt.x - grid.minX) / grid.cellSize);
+    int cellY = static_cast<int>((keypoints[i].pt.y - grid.minY) / grid.cellSize);
+    cellOfKeypoint[i] = cellY * grid.gridCols + cellX;
+    ++grid.cellStart[cellOfKeypoint[i] + 1];
+  }
+  for (size_t c = 1; c < grid.cellStart.size(); ++c) {
+    grid.cellStart[c] += grid.cellStart[c - 1];
+  }
+  std::vector<int> cellFill(grid.cellStart.begin(), grid.cellStart.end() - 1);
+  grid.cellKeypoints.resize(keypoints.size());
+  for (size_t i = 0; i < keypoints.size(); ++i) {
+    grid.cellKeypoints[cellFill[cellOfKeypoint[i]]++] = static_cast<int>(i);
+  }
+}
+
+// Cell range [first, last] covering [low, high] along one grid axis; false if the interval lies outside the grid
+bool cellRange(float low, float high, float origin, float cellSize, int numCells, int &first, int &last) {
+  float firstCell = std::floor((low - origin) / cellSize);
+  float lastCell = std::floor((high - origin) / cellSize);
+  if (lastCell < 0.f || firstCell >= numCells) {
+    return false;
+  }
+  first = std::max(static_cast<int>(firstCell), 0);
+  last = std::min(static_cast<int>(lastCell), numCells - 1);
+  return true;
+}
+
+// Distance between two descriptor rows, as computed by cv::BFMatcher for the given norm type
+float descriptorDistance(const cv::Mat &descA, int rowA, const cv::Mat &descB, int rowB, int normType) {
+  if (normType == cv::NORM_HAMMING) {
+    return static_cast<float>(cv::hal::normHamming(descA.ptr<uchar>(rowA), descB.ptr<uchar>(rowB), descA.cols));
+  }
+  float sum = 0.f;
+  if (descA.depth() == CV_32F) {
+    const float *a = descA.ptr<float>(rowA);
+    const float *b = descB.ptr<float>(rowB);
+    for (int i = 0; i < descA.cols; ++i) {
+      float diff = a[i] - b[i];
+      sum += diff * diff;
+    }
+  } else {
+    const uchar *a = descA.ptr<uchar>(rowA);
+    const uchar *b = descB.ptr<uchar>(rowB);
+    for (int i = 0; i < descA.cols; ++i) {
+      float diff = static_cast<float>(a[i]) - static_cast<float>(b[i]);
+      sum += diff * diff;
+    }
+  }
+  return std::sqrt(sum);
+}
+
+}  // namespace
+
+double matchDescriptorsGuided(const DataFrame &previousFrame, DataFrame &currentFrame, const cv::Mat &motion,
+                              std::vector<cv::DMatch> &matches, int normType, MatcherMethod matcherMethod,
+                              NeighborSelectorMethod nnSelector, bool crossCheck, const GuidedMatchingConf &conf,
+                              GuidedMatchingStats *stats, const LshIndexConf &lshConf, const MihIndexConf &mihConf) {
+  const cv::Mat &descPrevious = previousFrame.descriptors;
+  const cv::Mat &descCurrent = currentFrame.descriptors;
+  CV_Assert(static_cast<int>(previousFrame.keypoints.size()) == descPrevious.rows &&
+            static_cast<int>(currentFrame.keypoints.size()) == descCurrent.rows);
+  CV_Assert(motion.type() == CV_64F && motion.rows == 3 && motion.cols == 3 && motion.isContinuous());
+
+  bool bruteForce = matcherMethod == MatcherMethod::BRUTE_FORCE || matcherMethod == MatcherMethod::BRUTE_FORCE_SIMD;
+  if (crossCheck && !bruteForce) {
+    std::cout << "Cross-check is supported by the brute force matchers only, ignored" << std::endl;
+  }
+  crossCheck = crossCheck && bruteForce;
+
+  double t = (double)cv::getTickCount();
+  bool useRatioTest = nnSelector == NeighborSelectorMethod::kNN;
+  float minDescriptorDistRatio = 0.8f;
+  int minCandidates = useRatioTest ? 2 : 1;
+  float radius = conf.searchRadius;
+
+  KeypointGrid grid;
+  buildKeypointGrid(currentFrame.keypoints, radius, grid);
+
+  // per previous keypoint: index of the matched current keypoint, unmatched (-1, needs the fallback) or rejected
+  const int unmatched = -1;
+  const int rejected = -2;
+  int numPrevious = descPrevious.rows;
+  std::vector<int> bestIdx(numPrevious, unmatched);
+  std::vector<float> bestDist(numPrevious, 0.f);
+  std::vector<int> numCandidates(numPrevious, 0);
+  std::vector<cv::Point2f> predicted(numPrevious);
+  std::vector<char> isPredicted(numPrevious, 0);  // not vector<bool>, its elements share bytes
+  const double *h = motion.ptr<double>(0);
+  cv::parallel_for_(cv::Range(0, numPrevious), [&](const cv::Range &range) {
+    for (int i = range.start; i < range.end; ++i) {
+      const cv::Point2f &pt = previousFrame.keypoints[i].pt;
+      double w = h[6] * pt.x + h[7] * pt.y + h[8];
+      if (w <= std::numeric_limits<double>::epsilon()) {
+        continue;  // the motion maps the keypoint to infinity
+      }
+      float predX = static_cast<float>((h[0] * pt.x + h[1] * pt.y + h[2]) / w);
+      float predY = static_cast<float>((h[3] * pt.x + h[4] * pt.y + h[5]) / w);
+      predicted[i] = cv::Point2f(predX, predY);
+      isPredicted[i] = 1;
+      int firstCol, lastCol, firstRow, lastRow;
+      bool inGrid =
+          cellRange(predX - radius, predX + radius, grid.minX, grid.cellSize, grid.gridCols, firstCol, lastCol) &&
+          cellRange(predY - radius, predY + radius, grid.minY, grid.cellSize, grid.gridRows, firstRow, lastRow);
+      if (!inGrid) {
+        continue;  // the search window lies outside the current frame keypoints
+      }
+
+      float best = std::numeric_limits<float>::max();
+      float secondBest = best;
+      int idx = unmatched;
+      int count = 0;
+      for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+          int cell = row * grid.gridCols + col;
+          for (int c = grid.cellStart[cell]; c < grid.cellStart[cell + 1]; ++c) {
+            int k = grid.cellKeypoints[c];
+            const cv::Point2f &candidate = currentFrame.keypoints[k].pt;
+            if (std::abs(candidate.x - predX) > radius || std::abs(candidate.y - predY) > radius) {
+              continue;
+            }
+            float distance = descriptorDistance(descPrevious, i, descCurrent, k, normType);
+            ++count;
+            // cells are not visited in index order: ties go to the lower index as with brute force
+            if (distance < best || (distance == best && k < idx)) {
+              secondBest = best;
+              best = distance;
+              idx = k;
+            } else if (distance < secondBest) {
+              secondBest = distance;
+            }
+          }
+        }
+      }
+      numCandidates[i] = count;
+      if (count < minCandidates) {
+        continue;
+      }
+      if (useRatioTest && !(best < minDescriptorDistRatio * secondBest)) {
+        bestIdx[i] = rejected;
+        continue;
+      }
+      bestIdx[i] = idx;
+      bestDist[i] = best;
+    }
+  });
+
+  // fallback: the selected matcher over all current frame descriptors for keypoints without enough candidates
+  std::vector<int> fallbackRows;
+  std::vector<char> isFallback(numPrevious, 0);
+  for (int i = 0; i < numPrevious; ++i) {
+    if (bestIdx[i] == unmatched) {
+      fallbackRows.push_back(i);
+      isFallback[i] = 1;
+    }
+  }
+  if (!fallbackRows.empty() && descCurrent.rows > 0) {
+    cv::Mat descFallback(static_cast<int>(fallbackRows.size()), descPrevious.cols, descPrevious.type());
+    for (size_t j = 0; j < fallbackRows.size(); ++j) {
+      descPrevious.row(fallbackRows[j]).copyTo(descFallback.row(static_cast<int>(j)));
+    }
+    // the index is built without cross-check, the fallback rows are only a part of the previous frame
+    if (!isDescriptorIndexValid(currentFrame.descriptorIndex, matcherMethod, normType, false)) {
+      currentFrame.descriptorIndex =
+          buildDescriptorIndex(descCurrent, matcherMethod, normType, false, lshConf, mihConf);
+    }
+    std::vector<cv::DMatch> fallbackMatches;
+    matchDescriptorsWithIndex(*currentFrame.descriptorIndex, descFallback, fallbackMatches, nnSelector, false,
+                              mihConf);
+    for (const auto &match : fallbackMatches) {
+      bestIdx[fallbackRows[match.queryIdx]] = match.trainIdx;
+      bestDist[fallbackRows[match.queryIdx]] = match.distance;
+    }
+  }
+
+  // cross-check: the previous keypoints competing for a current keypoint, found through a grid of their predictions
+  std::vector<int> numReverse(numPrevious, 0);
+  int numCrossCheckRejected = 0;
+  if (crossCheck) {
+    std::vector<cv::KeyPoint> predictedKeypoints;
+    std::vector<int> previousOfPredicted;
+    for (int i = 0; i < numPrevious; ++i) {
+      if (isPredicted[i]) {
+        predictedKeypoints.push_back(cv::KeyPoint(predicted[i], 1.f));
+        previousOfPredicted.push_back(i);
+      }
+    }
+    KeypointGrid predictedGrid;
+    buildKeypointGrid(predictedKeypoints, radius, predictedGrid);
+    cv::parallel_for_(cv::Range(0, numPrevious), [&](const cv::Range &range) {
+      for (int i = range.start; i < range.end; ++i) {
+        int k = bestIdx[i];
+        if (k < 0) {
+          continue;
+        }
+        // distances recomputed the same way for all competitors, the fallback matcher may differ slightly
+        float best = descriptorDistance(descPrevious, i, descCurrent, k, normType);
+        int nearest = i, count = 1;
+        auto compete = [&](int j) {
+          float distance = descriptorDistance(descPrevious, j, descCurrent, k, normType);
+          ++count;
+          if (distance < best || (distance == best && j < nearest)) {
+            best = distance;
+            nearest = j;
+          }
+        };
+        const cv::Point2f &pt = currentFrame.keypoints[k].pt;
+        int firstCol, lastCol, firstRow, lastRow;
+        if (isFallback[i]) {
+          for (int j = 0; j < numPrevious; ++j) {
+            if (j != i) {
+              compete(j);
+            }
+          }
+        } else if (cellRange(pt.x - radius, pt.x + radius, predictedGrid.minX, predictedGrid.cellSize,
+                             predictedGrid.gridCols, firstCol, lastCol) &&
+                   cellRange(pt.y - radius, pt.y + radius, predictedGrid.minY, predictedGrid.cellSize,
+                             predictedGrid.gridRows, firstRow, lastRow)) {
+          for (int row = firstRow; row <= lastRow; ++row) {
+            for (int col = firstCol; col <= lastCol; ++col) {
+              int cell = row * predictedGrid.gridCols + col;
+              for (int c = predictedGrid.cellStart[cell]; c < predictedGrid.cellStart[cell + 1]; ++c) {
+                int j = previousOfPredicted[predictedGrid.cellKeypoints[c]];
+                if (j == i || std::abs(predicted[j].x - pt.x) > radius ||
+                    std::abs(predicted[j].y - pt.y) > radius) {
+                  continue;
+                }
+                compete(j);
+              }
+            }
+          }
+        }
+        numReverse[i] = count;
+        if (nearest != i) {
+          bestIdx[i] = rejected;
+        }
+      }
+    });
+    for (int i = 0; i < numPrevious; ++i) {
+      numCrossCheckRejected += numReverse[i] > 0 && bestIdx[i] == rejected;
+    }
+  }
+
+  for (int i = 0; i < numPrevious; ++i) {
+    if (bestIdx[i] >= 0) {
+      matches.push_back(cv::DMatch(i, bestIdx[i], bestDist[i]));
+    }
+  }
+  double timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+
+  long numComparisons = static_cast<long>(fallbackRows.size()) * descCurrent.rows;
+  for (int i = 0; i < numPrevious; ++i) {
+    numComparisons += numCandidates[i] + numReverse[i];
+  }
+  std::cout << "Guided matching (" << (useRatioTest ? "kNN" : "NN") << ") with n=" << matches.size()
+            << " matches in " << 1000 * timeMatching / 1.0 << " ms" << std::endl;
+  std::cout << "  " << (numPrevious > 0 ? static_cast<double>(numComparisons) / numPrevious : 0.0)
+            << " descriptor distances per keypoint instead of " << descCurrent.rows << ", "
+            << fallbackRows.size() << " keypoints matched globally";
+  if (crossCheck) {
+    std::cout << ", " << numCrossCheckRejected << " matches rejected by the cross-check";
+  }
+  std::cout << std::endl;
+  if (stats != nullptr) {
+    stats->numQueries = numPrevious;
+    stats->numFallback = static_cast<int>(fallbackRows.size());
+    stats->numComparisons = numComparisons;
+    stats->numCrossCheckRejected = numCrossCheckRejected;
+    stats->timeSec = timeMatching;
+  }
+  return timeMatching;
+}
+
+double estimateKeypointMotion(const std::vector<cv::KeyPoint> &kptsPrevious,
+                              const std::vector<cv::KeyPoint> &kptsCurrent, const std::vector<cv::DMatch> &matches,
+                              const GuidedMatchingConf &conf, cv::Mat &motion) {
+  motion.release();
+  if (static_cast<int>(matches.size()) < std::max(conf.minMatches, 4)) {
+    std::cout << "Too few matches (" << matches.size() << ") to estimate the keypoint motion" << std::endl;
+    return 0.0;
+  }
+  double t = (double)cv::getTickCount();
+  std::vector<cv::Point2f> ptsPrevious, ptsCurrent;
+  ptsPrevious.reserve(matches.size());
+  ptsCurrent.reserve(matches.size());
+  for (const auto &match : matches) {
+    ptsPrevious.push_back(kptsPrevious[match.queryIdx].pt);
+    ptsCurrent.push_back(kptsCurrent[match.trainIdx].pt);
+  }
+  if (conf.motionModel == MotionModel::HOMOGRAPHY) {
+    motion = cv::findHomography(ptsPrevious, ptsCurrent, cv::RANSAC, conf.ransacReprojThreshold);
+  }
+  if (motion.empty()) {
+    // median flow, also used if RANSAC did not find a homography
+    std::vector<float> flowX, flowY;
+    flowX.reserve(matches.size());
+    flowY.reserve(matches.size());
+    for (size_t i = 0; i < ptsPrevious.size(); ++i) {
+      flowX.push_back(ptsCurrent[i].x - ptsPrevious[i].x);
+      flowY.push_back(ptsCurrent[i].y - ptsPrevious[i].y);
+    }
+    size_t mid = flowX.size() / 2;
+    std::nth_element(flowX.begin(), flowX.begin() + mid, flowX.end());
+    std::nth_element(flowY.begin(), flowY.begin() + mid, flowY.end());
+    motion = cv::Mat::eye(3, 3, CV_64F);
+    motion.at<double>(0, 2) = flowX[mid];
+    motion.at<double>(1, 2) = flowY[mid];
+  }
+  return ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+}
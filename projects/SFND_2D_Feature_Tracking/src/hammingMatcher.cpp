@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "hammingMatcher.h"
+
+/* NOTE
+ * The distance of a descriptor pair is the popcount of the XOR of both descriptors. With AVX2 the popcount is taken
+ * per byte by a 4 bit table lookup (vpshufb) and summed up with vpsadbw; the per byte counts of four train rows are
+ * reduced together, so only one horizontal sum is needed per four distances. AVX-512 VPOPCNTDQ counts the bits of a
+ * 64 byte descriptor with a single instruction. Without AVX2 the popcount of 64 bit words is used if the popcnt
+ * instruction is enabled (e.g. -msse4.2), otherwise SSE2 counts the bits within the bytes (x86-64 baseline).
+ */
+
+namespace {
+
+const int kQueryBlockSize = 64;  // query rows per parallel work item
+
+inline int popcount64(const uchar *a, const uchar *b) {
+  uint64_t wa, wb;
+  std::memcpy(&wa, a, sizeof(wa));
+  std::memcpy(&wb, b, sizeof(wb));
+  return __builtin_popcountll(wa ^ wb);
+}
+
+// NumBytes = 0 for descriptor sizes without a specialized kernel
+template <int NumBytes>
+inline int hammingDistance(const uchar *a, const uchar *b, int numBytes) {
+  int distance = 0;
+  int i = 0;
+  for (; i + 8 <= numBytes; i += 8) {
+    distance += popcount64(a + i, b + i);
+  }
+  for (; i < numBytes; ++i) {
+    distance += __builtin_popcount(static_cast<unsigned>(a[i] ^ b[i]));
+  }
+  return distance;
+}
+
+template <>
+inline int hammingDistance<32>(const uchar *a, const uchar *b, int) {
+  return popcount64(a, b) + popcount64(a + 8, b + 8) + popcount64(a + 16, b + 16) + popcount64(a + 24, b + 24);
+}
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+template <>
+inline int hammingDistance<64>(const uchar *a, const uchar *b, int) {
+  __m512i counts = _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_loadu_si512(a), _mm512_loadu_si512(b)));
+  __m256i sums = _mm256_add_epi64(_mm512_castsi512_si256(counts), _mm512_extracti64x4_epi64(counts, 1));
+  __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+  return static_cast<int>(_mm_cvtsi128_si64(sum) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum)));
+}
+#else
+template <>
+inline int hammingDistance<64>(const uchar *a, const uchar *b, int) {
+  return hammingDistance<32>(a, b, 32) + hammingDistance<32>(a + 32, b + 32, 32);
+}
+#endif
+
+// Distances between the query and the train rows t..t+3, used if HasBatchKernel (scanning row by row is faster for
+// the scalar popcount)
+template <int NumBytes>
+struct HasBatchKernel {
+  static const bool value = false;
+};
+
+template <int NumBytes>
+inline void hammingDistance4(const uchar *query, const cv::Mat &descTrain, int t, int numBytes, int *distances) {
+  for (int k = 0; k < 4; ++k) {
+    distances[k] = hammingDistance<NumBytes>(query, descTrain.ptr<uchar>(t + k), numBytes);
+  }
+}
+
+#if defined(__AVX2__)
+// per byte popcount of a XOR b
+inline __m256i popcountBytes256(__m256i a, const uchar *b) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+  __m256i x = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+  __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, lowNibble));
+  __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowNibble));
+  return _mm256_add_epi8(lo, hi);
+}
+
+// sum of the per byte counts of four rows
+inline void sumBytes256x4(__m256i c0, __m256i c1, __m256i c2, __m256i c3, int *distances) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i s0 = _mm256_sad_epu8(c0, zero), s1 = _mm256_sad_epu8(c1, zero);
+  __m256i s2 = _mm256_sad_epu8(c2, zero), s3 = _mm256_sad_epu8(c3, zero);
+  // 64 bit lanes: {s0, s1, s0, s1} and {s2, s3, s2, s3} partial sums, then the 128 bit halves are added
+  __m256i s01 = _mm256_add_epi64(_mm256_unpacklo_epi64(s0, s1), _mm256_unpackhi_epi64(s0, s1));
+  __m256i s23 = _mm256_add_epi64(_mm256_unpacklo_epi64(s2, s3), _mm256_unpackhi_epi64(s2, s3));
+  __m256i sums =
+      _mm256_add_epi64(_mm256_permute2x128_si256(s01, s23, 0x20), _mm256_permute2x128_si256(s01, s23, 0x31));
+  // the distances fit into the low 32 bits of each lane
+  __m256i packed = _mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(distances), _mm256_castsi256_si128(packed));
+}
+
+template <>
+struct HasBatchKernel<32> {
+  static const bool value = true;
+};
+
+template <>
+inline void hammingDistance4<32>(const uchar *query, const cv::Mat &descTrain, int t, int, int *distances) {
+  __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query));
+  sumBytes256x4(popcountBytes256(q, descTrain.ptr<uchar>(t)), popcountBytes256(q, descTrain.ptr<uchar>(t + 1)),
+                popcountBytes256(q, descTrain.ptr<uchar>(t + 2)), popcountBytes256(q, descTrain.ptr<uchar>(t + 3)),
+                distances);
+}
+
+#if !(defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__))
+template <>
+struct HasBatchKernel<64> {
+  static const bool value = true;
+};
+
+template <>
+inline void hammingDistance4<64>(const uchar *query, const cv::Mat &descTrain, int t, int, int *distances) {
+  __m256i q0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query));
+  __m256i q1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query + 32));
+  __m256i counts[4];
+  for (int k = 0; k < 4; ++k) {
+    const uchar *train = descTrain.ptr<uchar>(t + k);
+    // the per byte counts are at most 8, the sum of both halves fits into a byte
+    counts[k] = _mm256_add_epi8(popcountBytes256(q0, train), popcountBytes256(q1, train + 32));
+  }
+  sumBytes256x4(counts[0], counts[1], counts[2], counts[3], distances);
+}
+#endif
+#elif defined(__SSE2__) && !defined(__POPCNT__)
+// per byte popcount of a XOR b, counted in the bytes (SWAR) as SSE2 has no byte shuffle
+inline __m128i popcountBytes128(__m128i a, const uchar *b) {
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0f);
+  __m128i x = _mm_xor_si128(a, _mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+  x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+  x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+  return _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+}
+
+// per byte counts of a NumBytes descriptor folded into 16 bytes (at most 8 * NumBytes / 16 per byte)
+template <int NumBytes>
+inline __m128i popcountBytes128(const __m128i *query, const uchar *train) {
+  __m128i counts = popcountBytes128(query[0], train);
+  for (int i = 1; i < NumBytes / 16; ++i) {
+    counts = _mm_add_epi8(counts, popcountBytes128(query[i], train + 16 * i));
+  }
+  return counts;
+}
+
+template <>
+struct HasBatchKernel<32> {
+  static const bool value = true;
+};
+
+template <>
+struct HasBatchKernel<64> {
+  static const bool value = true;
+};
+
+template <int NumBytes>
+inline void hammingDistance4Sse2(const uchar *query, const cv::Mat &descTrain, int t, int *distances) {
+  __m128i q[NumBytes / 16];
+  for (int i = 0; i < NumBytes / 16; ++i) {
+    q[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(query + 16 * i));
+  }
+  const __m128i zero = _mm_setzero_si128();
+  __m128i s0 = _mm_sad_epu8(popcountBytes128<NumBytes>(q, descTrain.ptr<uchar>(t)), zero);
+  __m128i s1 = _mm_sad_epu8(popcountBytes128<NumBytes>(q, descTrain.ptr<uchar>(t + 1)), zero);
+  __m128i s2 = _mm_sad_epu8(popcountBytes128<NumBytes>(q, descTrain.ptr<uchar>(t + 2)), zero);
+  __m128i s3 = _mm_sad_epu8(popcountBytes128<NumBytes>(q, descTrain.ptr<uchar>(t + 3)), zero);
+  // 64 bit lanes {d0, d1} and {d2, d3}, packed to four 32 bit distances
+  __m128i s01 = _mm_add_epi64(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+  __m128i s23 = _mm_add_epi64(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+  __m128i packed = _mm_unpacklo_epi64(_mm_shuffle_epi32(s01, _MM_SHUFFLE(3, 1, 2, 0)),
+                    _mm_shuffle_epi32(s23, _MM_SHUFFLE(3, 1, 2, 0)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(distances), packed);
+}
+
+template <>
+inline void hammingDistance4<32>(const uchar *query, const cv::Mat &descTrain, int t, int, int *distances) {
+  hammingDistance4Sse2<32>(query, descTrain, t, distances);
+}
+
+template <>
+inline void hammingDistance4<64>(const uchar *query, const cv::Mat &descTrain, int t, int, int *distances) {
+  hammingDistance4Sse2<64>(query, descTrain, t, distances);
+}
+#endif
+
+inline void updateBest(int distance, int t, int &best, int &second, int &idx) {
+  if (distance < best) {
+    second = best;
+    best = distance;
+    idx = t;
+  } else if (distance < second) {
+    second = distance;
+  }
+}
+
+// Nearest query row of train row t, the query rows are scanned in ascending order (ties keep the lower index)
+inline void updateReverseBest(int distance, int t, int q, int *reverseDistance, int *reverseIdx) {
+  if (reverseDistance != nullptr && distance < reverseDistance[t]) {
+    reverseDistance[t] = distance;
+    reverseIdx[t] = q;
+  }
+}
+
+/* Best and second best distance of each query row in range against all train rows; bestIdx is -1 if there is none.
+ * If reverseDistance is given, the nearest query row of every train row within range is tracked from the same
+ * distances (cross-check).
+ */
+template <int NumBytes>
+void scanQueryRows(const cv::Mat &descQuery, const cv::Mat &descTrain, const cv::Range &range, int numBytes,
+                   int *bestIdx, int *bestDistance, int *secondDistance, int *reverseDistance, int *reverseIdx) {
+  int distances[4];
+  for (int q = range.start; q < range.end; ++q) {
+    const uchar *query = descQuery.ptr<uchar>(q);
+    int best = INT_MAX, second = INT_MAX, idx = -1;
+    int t = 0;
+    for (; HasBatchKernel<NumBytes>::value && t + 4 <= descTrain.rows; t += 4) {
+      hammingDistance4<NumBytes>(query, descTrain, t, numBytes, distances);
+      for (int k = 0; k < 4; ++k) {
+        updateBest(distances[k], t + k, best, second, idx);
+        updateReverseBest(distances[k], t + k, q, reverseDistance, reverseIdx);
+      }
+    }
+    for (; t < descTrain.rows; ++t) {
+      int distance = hammingDistance<NumBytes>(query, descTrain.ptr<uchar>(t), numBytes);
+      updateBest(distance, t, best, second, idx);
+      updateReverseBest(distance, t, q, reverseDistance, reverseIdx);
+    }
+    bestIdx[q] = idx;
+    bestDistance[q] = best;
+    secondDistance[q] = second;
+  }
+}
+
+}  // namespace
+
+void matchHamming(const cv::Mat &descQuery, const cv::Mat &descTrain, std::vector<cv::DMatch> &matches,
+                  double maxRatio, bool crossCheck, int rowBytes) {
+  CV_Assert(descQuery.depth() == CV_8U && descTrain.depth() == CV_8U && descQuery.cols == descTrain.cols);
+  std::vector<int> bestIdx(descQuery.rows), bestDistance(descQuery.rows), secondDistance(descQuery.rows);
+  // nearest query row of each train row (cross-check), merged from the query blocks
+  std::vector<int> reverseDistance(crossCheck ? descTrain.rows : 0, INT_MAX);
+  std::vector<int> reverseIdx(crossCheck ? descTrain.rows : 0, -1);
+  std::mutex reverseMutex;
+  int numBytes = descQuery.cols * descQuery.channels();
+  if (rowBytes > 0) {
+    // the rows are zero padded up to rowBytes, the padding does not change the distances
+    CV_Assert(rowBytes >= numBytes && rowBytes <= static_cast<int>(std::min(descQuery.step[0], descTrain.step[0])));
+    numBytes = rowBytes;
+  }
+  int numBlocks = (descQuery.rows + kQueryBlockSize - 1) / kQueryBlockSize;
+  cv::parallel_for_(cv::Range(0, numBlocks), [&](const cv::Range &blocks) {
+    cv::Range range(blocks.start * kQueryBlockSize, std::min(blocks.end * kQueryBlockSize, descQuery.rows));
+    std::vector<int> blockReverseDistance(reverseDistance.size(), INT_MAX);
+    std::vector<int> blockReverseIdx(reverseIdx.size(), -1);
+    int *revDistance = crossCheck ? blockReverseDistance.data() : nullptr;
+    int *revIdx = crossCheck ? blockReverseIdx.data() : nullptr;
+    if (numBytes == 32) {
+      scanQueryRows<32>(descQuery, descTrain, range, numBytes, bestIdx.data(), bestDistance.data(),
+                        secondDistance.data(), revDistance, revIdx);
+    } else if (numBytes == 64) {
+      scanQueryRows<64>(descQuery, descTrain, range, numBytes, bestIdx.data(), bestDistance.data(),
+                        secondDistance.data(), revDistance, revIdx);
+    } else {
+      scanQueryRows<0>(descQuery, descTrain, range, numBytes, bestIdx.data(), bestDistance.data(),
+                       secondDistance.data(), revDistance, revIdx);
+    }
+    if (crossCheck) {
+      // ties in favour of the lower query index, independent of the order the blocks finish in
+      std::lock_guard<std::mutex> lock(reverseMutex);
+      for (size_t t = 0; t < reverseDistance.size(); ++t) {
+        if (blockReverseDistance[t] < reverseDistance[t] ||
+            (blockReverseDistance[t] == reverseDistance[t] && blockReverseIdx[t] < reverseIdx[t])) {
+          reverseDistance[t] = blockReverseDistance[t];
+          reverseIdx[t] = blockReverseIdx[t];
+        }
+      }
+    }
+  });
+
+  // matches are emitted in query order; the ratio test needs a second neighbour, as in runKNN
+  for (int q = 0; q < descQuery.rows; ++q) {
+    if (bestIdx[q] < 0 || (crossCheck && reverseIdx[bestIdx[q]] != q)) {
+      continue;
+    }
+    if (maxRatio <= 0 || (secondDistance[q] != INT_MAX && bestDistance[q] < maxRatio * secondDistance[q])) {
+      matches.push_back(cv::DMatch(q, bestIdx[q], 0, static_cast<float>(bestDistance[q])));
+    }
+  }
+}
+
+const char *hammingMatcherInstructionSet() {
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+  return "AVX-512 VPOPCNTDQ";
+#elif defined(__AVX2__)
+  return "AVX2";
+#elif defined(__POPCNT__)
+  return "POPCNT";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "l2Matcher.h"
+
+namespace {
+
+const int kPanelWidth = 16;      // train rows per packed panel (columns of the micro-kernel)
+const int kMicroRows = 4;        // query rows per micro-kernel call
+const int kQueryBlockSize = 64;  // query rows per parallel work item
+const int kTilePanels = 16;      // train panels per cache tile (256 SIFT descriptors = 128 KiB)
+
+#if defined(__AVX2__) && defined(__FMA__)
+// dots[i * kPanelWidth + j] = query[i] . train row j of the panel, two 8 float accumulators per query row
+inline void dotProducts(const float *const *query, const float *panel, int dims, float *dots) {
+  __m256 acc[kMicroRows][2];
+  for (int i = 0; i < kMicroRows; ++i) {
+    acc[i][0] = _mm256_setzero_ps();
+    acc[i][1] = _mm256_setzero_ps();
+  }
+  for (int k = 0; k < dims; ++k) {
+    __m256 b0 = _mm256_loadu_ps(panel + k * kPanelWidth);
+    __m256 b1 = _mm256_loadu_ps(panel + k * kPanelWidth + 8);
+    for (int i = 0; i < kMicroRows; ++i) {
+      __m256 a = _mm256_broadcast_ss(query[i] + k);
+      acc[i][0] = _mm256_fmadd_ps(a, b0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(a, b1, acc[i][1]);
+    }
+  }
+  for (int i = 0; i < kMicroRows; ++i) {
+    _mm256_storeu_ps(dots + i * kPanelWidth, acc[i][0]);
+    _mm256_storeu_ps(dots + i * kPanelWidth + 8, acc[i][1]);
+  }
+}
+#else
+// dots[i * kPanelWidth + j] = query[i] . train row j of the panel, the inner loop is vectorized by the compiler
+inline void dotProducts(const float *const *query, const float *panel, int dims, float *dots) {
+  float acc[kMicroRows][kPanelWidth] = {};
+  for (int k = 0; k < dims; ++k) {
+    const float *train = panel + k * kPanelWidth;
+    for (int i = 0; i < kMicroRows; ++i) {
+      float a = query[i][k];
+      for (int j = 0; j < kPanelWidth; ++j) {
+        acc[i][j] += a * train[j];
+      }
+    }
+  }
+  for (int i = 0; i < kMicroRows; ++i) {
+    std::copy(acc[i], acc[i] + kPanelWidth, dots + i * kPanelWidth);
+  }
+}
+#endif
+
+inline float squaredNorm(const float *descriptor, int dims) {
+  float norm = 0;
+  for (int k = 0; k < dims; ++k) {
+    norm += descriptor[k] * descriptor[k];
+  }
+  return norm;
+}
+
+}  // namespace
+
+std::shared_ptr<L2MatcherIndex> buildL2MatcherIndex(const cv::Mat &descriptors) {
+  CV_Assert(descriptors.type() == CV_32F);
+  std::shared_ptr<L2MatcherIndex> index = std::make_shared<L2MatcherIndex>();
+  index->descriptors = descriptors;
+  int dims = descriptors.cols;
+  index->numPanels = (descriptors.rows + kPanelWidth - 1) / kPanelWidth;
+  index->panels.assign(static_cast<size_t>(index->numPanels) * dims * kPanelWidth, 0.f);
+  index->norms.resize(descriptors.rows);
+  for (int t = 0; t < descriptors.rows; ++t) {
+    const float *descriptor = descriptors.ptr<float>(t);
+    float *panel = &index->panels[static_cast<size_t>(t / kPanelWidth) * dims * kPanelWidth] + t % kPanelWidth;
+    for (int k = 0; k < dims; ++k) {
+      panel[k * kPanelWidth] = descriptor[k];
+    }
+    index->norms[t] = squaredNorm(descriptor, dims);
+  }
+  return index;
+}
+
+void matchL2(const cv::Mat &descQuery, const L2MatcherIndex &index, std::vector<cv::DMatch> &matches,
+             double maxRatio, bool crossCheck) {
+  CV_Assert(descQuery.type() == CV_32F && descQuery.cols == index.descriptors.cols);
+  int numTrain = index.descriptors.rows;
+  int dims = descQuery.cols;
+  if (numTrain == 0 || descQuery.empty()) {
+    return;
+  }
+  // squared distances of the nearest and second nearest train row of each query row
+  std::vector<int> bestIdx(descQuery.rows, -1);
+  std::vector<float> bestDistance(descQuery.rows, FLT_MAX), secondDistance(descQuery.rows, FLT_MAX);
+  // nearest query row of each train row (cross-check), merged from the query blocks
+  std::vector<int> reverseIdx(crossCheck ? numTrain : 0, -1);
+  std::vector<float> reverseDistance(crossCheck ? numTrain : 0, FLT_MAX);
+  std::mutex reverseMutex;
+
+  int numBlocks = (descQuery.rows + kQueryBlockSize - 1) / kQueryBlockSize;
+  cv::parallel_for_(cv::Range(0, numBlocks), [&](const cv::Range &blocks) {
+    std::vector<int> blockReverseIdx(reverseIdx.size(), -1);
+    std::vector<float> blockReverseDistance(reverseDistance.size(), FLT_MAX);
+    float queryNorms[kQueryBlockSize];
+    float dots[kMicroRows * kPanelWidth];
+    for (int block = blocks.start; block < blocks.end; ++block) {
+      int first = block * kQueryBlockSize;
+      int last = std::min(first + kQueryBlockSize, descQuery.rows);
+      for (int q = first; q < last; ++q) {
+        queryNorms[q - first] = squaredNorm(descQuery.ptr<float>(q), dims);
+      }
+      // the panels of a tile stay in cache while all rows of the query block are multiplied with them
+      for (int tile = 0; tile < index.numPanels; tile += kTilePanels) {
+        int tileEnd = std::min(tile + kTilePanels, index.numPanels);
+        for (int q0 = first; q0 < last; q0 += kMicroRows) {
+          int numRows = std::min(kMicroRows, last - q0);
+          const float *rows[kMicroRows];
+          for (int i = 0; i < kMicroRows; ++i) {
+            rows[i] = descQuery.ptr<float>(q0 + std::min(i, numRows - 1));  // padding rows are ignored
+          }
+          for (int p = tile; p < tileEnd; ++p) {
+            dotProducts(rows, &index.panels[static_cast<size_t>(p) * dims * kPanelWidth], dims, dots);
+            int numCols = std::min(kPanelWidth, numTrain - p * kPanelWidth);
+            const float *trainNorms = &index.norms[p * kPanelWidth];
+            for (int i = 0; i < numRows; ++i) {
+              int q = q0 + i;
+              float queryNorm = queryNorms[q - first];
+              const float *rowDots = dots + i * kPanelWidth;
+              float best = bestDistance[q], second = secondDistance[q];
+              int idx = bestIdx[q];
+              for (int j = 0; j < numCols; ++j) {
+                int t = p * kPanelWidth + j;
+                float distance = std::max(0.f, queryNorm + trainNorms[j] - 2 * rowDots[j]);
+                // train rows are visited in ascending order, ties keep the lower index
+                if (distance < best) {
+                  second = best;
+                  best = distance;
+                  idx = t;
+                } else if (distance < second) {
+                  second = distance;
+                }
+                if (crossCheck && distance < blockReverseDistance[t]) {
+                  blockReverseDistance[t] = distance;
+                  blockReverseIdx[t] = q;
+                }
+              }
+              bestDistance[q] = best;
+              secondDistance[q] = second;
+              bestIdx[q] = idx;
+            }
+          }
+        }
+      }
+    }
+    if (crossCheck) {
+      // ties in favour of the lower query index, independent of the order the blocks finish in
+      std::lock_guard<std::mutex> lock(reverseMutex);
+      for (int t = 0; t < numTrain; ++t) {
+        if (blockReverseIdx[t] >= 0 &&
+            (reverseIdx[t] < 0 || blockReverseDistance[t] < reverseDistance[t] ||
+             (blockReverseDistance[t] == reverseDistance[t] && blockReverseIdx[t] < reverseIdx[t]))) {
+          reverseDistance[t] = blockReverseDistance[t];
+          reverseIdx[t] = blockReverseIdx[t];
+        }
+      }
+    }
+  });
+
+  // matches are emitted in query order; the ratio test needs a second neighbour, as in runKNN
+  for (int q = 0; q < descQuery.rows; ++q) {
+    if (bestIdx[q] < 0 || (crossCheck && reverseIdx[bestIdx[q]] != q)) {
+      continue;
+    }
+    float distance = std::sqrt(bestDistance[q]);
+    if (maxRatio <= 0 || (secondDistance[q] != FLT_MAX && distance < maxRatio * std::sqrt(secondDistance[q]))) {
+      matches.push_back(cv::DMatch(q, bestIdx[q], 0, distance));
+    }
+  }
+}
+
+const char *l2MatcherInstructionSet() {
+#if defined(__AVX2__) && defined(__FMA__)
+  return "AVX2+FMA";
+#else
+  return "compiler vectorized";
+#endif
+}
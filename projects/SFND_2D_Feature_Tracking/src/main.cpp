@@ -16,6 +16,9 @@
 #include <vector>
 
 #include "dataStructures.h"
+#include "descriptorArena.h"
+#include "descriptorIndex.h"
+#include "guidedMatching.h"
 #include "matching2D.hpp"
 #include "tclap/CmdLine.h"
 #include "utils.h"
@@ -30,11 +33,17 @@ int main(int argc, const char *argv[]) {
   bool applyROI = false;
   bool crossCheckBruteForce = false;
   int maxKeypoints = 0;
+  int targetKeypoints = 0;  // threshold controller target, 0 = fixed detector parameters
+  double targetTimeMs = 0;  // threshold controller detection + description time budget, 0 = not used
   int detectorSelected = static_cast<int>(DetectorMethod::SHITOMASI);    // default
   int descriptorSelected = static_cast<int>(DescriptorMethod::BRISK);    // default
   int DescriptorMetricSel = static_cast<int>(DescriptorMetric::BINARY);  // default
   int matcherSelected = static_cast<int>(MatcherMethod::BRUTE_FORCE);    // default
   int nnMatcherSelected = static_cast<int>(NeighborSelectorMethod::NN);  // default
+  LshIndexConf lshConf;
+  MihIndexConf mihConf;
+  GuidedMatchingConf guidedConf;
+  bool evaluateRecall = false;  // compare the matches against exact brute force matching
 
   // Command line arguments are used for debugging
   try {
@@ -61,13 +70,56 @@ int main(int argc, const char *argv[]) {
                                      DescriptorMetricSel, "int");
     cmdlineArg.add(descrMetric);
 
+    TCLAP::ValueArg<int> lshTables("", "lsh-tables", "No. of hash tables of the FLANN_LSH matcher", false,
+                                   lshConf.tableNumber, "int");
+    cmdlineArg.add(lshTables);
+
+    TCLAP::ValueArg<int> lshKeySize("", "lsh-key-size", "No. of descriptor bits hashed per FLANN_LSH table", false,
+                                    lshConf.keySize, "int");
+    cmdlineArg.add(lshKeySize);
+
+    TCLAP::ValueArg<int> lshProbe("", "lsh-probe", "Multi-probe level of the FLANN_LSH matcher", false,
+                                  lshConf.multiProbeLevel, "int");
+    cmdlineArg.add(lshProbe);
+
+    TCLAP::ValueArg<int> mihSubstringBits("", "mih-substring-bits",
+                                          "Bits per hashed substring of the MULTI_INDEX_HASH matcher (8 or 16)", false,
+                                          mihConf.substringBits, "int");
+    cmdlineArg.add(mihSubstringBits);
+
+    TCLAP::ValueArg<int> mihMaxRadius("", "mih-max-radius",
+                                      "Max. Hamming distance of a MULTI_INDEX_HASH match (0: exact nearest neighbours)",
+                                      false, mihConf.maxRadius, "int");
+    cmdlineArg.add(mihMaxRadius);
+
+    TCLAP::ValueArg<bool> evalRecall("", "eval-recall",
+                                     "Report the share of matches on the exact (brute force) nearest neighbour", false,
+                                     evaluateRecall, "bool");
+    cmdlineArg.add(evalRecall);
+
+    TCLAP::ValueArg<bool> guidedMatching(
+        "", "guided-matching",
+        "Match each keypoint only against keypoints near its position predicted by the last frame pair motion", false,
+        guidedConf.enabled, "bool");
+    cmdlineArg.add(guidedMatching);
+
+    TCLAP::ValueArg<float> searchRadius("", "search-radius", "Half size of the guided matching search window [px]",
+                                        false, guidedConf.searchRadius, "float");
+    cmdlineArg.add(searchRadius);
+
+    TCLAP::ValueArg<int> motionModel("", "motion-model",
+                                     "Keypoint motion model for guided matching (0: median flow, 1: homography)",
+                                     false, static_cast<int>(guidedConf.motionModel), "int");
+    cmdlineArg.add(motionModel);
+
     TCLAP::ValueArg<bool> useROI("", "roi", "Apply an ROI on preceeding vehicle", false, applyROI, "bool");
     cmdlineArg.add(useROI);
 
     TCLAP::ValueArg<bool> useCrossCheck(
         "", "cross-check",
-        "Cross-Check matching between source and destination images. Used only for BRUTE_FORCE matcher.", false,
-        crossCheckBruteForce, "bool");
+        "Cross-Check matching between source and destination images (NN and kNN selection). Used only for the "
+        "BRUTE_FORCE and BRUTE_FORCE_SIMD matchers.",
+        false, crossCheckBruteForce, "bool");
     cmdlineArg.add(useCrossCheck);
 
     TCLAP::ValueArg<int> maxNumKeypoints("", "max-keypts",
@@ -75,6 +127,17 @@ int main(int argc, const char *argv[]) {
                                          maxKeypoints, "int");
     cmdlineArg.add(maxNumKeypoints);
 
+    TCLAP::ValueArg<int> targetNumKeypoints(
+        "", "target-keypts", "Adapt the detector threshold from frame to frame to detect about this number of keypoints",
+        false, targetKeypoints, "int");
+    cmdlineArg.add(targetNumKeypoints);
+
+    TCLAP::ValueArg<double> targetTime(
+        "", "target-time",
+        "Adapt the detector threshold from frame to frame to keep detection + description within this time (ms)", false,
+        targetTimeMs, "double");
+    cmdlineArg.add(targetTime);
+
     TCLAP::ValueArg<bool> visualize("", "visualize", "Show results in OpenCV window", false, visualizeResult, "bool");
     cmdlineArg.add(visualize);
 
@@ -85,6 +148,8 @@ int main(int argc, const char *argv[]) {
 
     applyROI = useROI.getValue();
     maxKeypoints = maxNumKeypoints.getValue();
+    targetKeypoints = targetNumKeypoints.getValue();
+    targetTimeMs = targetTime.getValue();
 
     detectorSelected = detType.getValue();
     descriptorSelected = descType.getValue();
@@ -92,6 +157,15 @@ int main(int argc, const char *argv[]) {
     matcherSelected = matcherType.getValue();
     nnMatcherSelected = nnType.getValue();
     crossCheckBruteForce = useCrossCheck.getValue();
+    lshConf.tableNumber = lshTables.getValue();
+    lshConf.keySize = lshKeySize.getValue();
+    lshConf.multiProbeLevel = lshProbe.getValue();
+    mihConf.substringBits = mihSubstringBits.getValue();
+    mihConf.maxRadius = mihMaxRadius.getValue();
+    evaluateRecall = evalRecall.getValue();
+    guidedConf.enabled = guidedMatching.getValue();
+    guidedConf.searchRadius = searchRadius.getValue();
+    guidedConf.motionModel = static_cast<MotionModel>(motionModel.getValue());
 
     // Check AKAZE descriptor/detector combination
     if (descriptorSelected == static_cast<int>(DescriptorMethod::AKAZE) &&
@@ -115,6 +189,7 @@ int main(int argc, const char *argv[]) {
 
   DetectorMethod detectorMethod = static_cast<DetectorMethod>(detectorSelected);
   DescriptorMethod descriptorMethod = static_cast<DescriptorMethod>(descriptorSelected);
+  ThresholdController thresholdCtrl = createThresholdController(detectorMethod, targetKeypoints, targetTimeMs);
   // output files
   std::ofstream summaryCsvFile;
   initSummaryFile(summaryCsvFile, detectorMethod, descriptorMethod);
@@ -149,7 +224,7 @@ int main(int argc, const char *argv[]) {
      */
     // extract 2D keypoints from current image
     std::vector<cv::KeyPoint> keypoints;  // create empty feature list for current image
-    double timeKptDetection = detectKeypoints(detectorMethod, keypoints, imgGray, visualizeResult);
+    double timeKptDetection = detectKeypoints(detectorMethod, keypoints, imgGray, visualizeResult, &thresholdCtrl);
     detectionInfoStats.imageIndex = imgIndex;
     detectionInfoStats.detector = detectorMethod;
     detectionInfoStats.numKeypointsFrame = keypoints.size();
@@ -201,11 +276,22 @@ int main(int argc, const char *argv[]) {
     cv::Mat descriptors;
     double timeDescriptor = descKeypoints(descriptorMethod, (dataBuffer.end() - 1)->keypoints,
                                           (dataBuffer.end() - 1)->cameraImg, descriptors);
-    // push descriptors for current frame to end of data buffer
-    (dataBuffer.end() - 1)->descriptors = descriptors;
+    // push descriptors for current frame to end of data buffer (aligned, padded rows in the arena of the frame)
+    timeDescriptor += storeDescriptors(*(dataBuffer.end() - 1), descriptors, getDescriptorTraits(descriptorMethod));
     detectionInfoStats.descriptor = descriptorMethod;
     detectionInfoStats.descriptorComputeTimeSec = timeDescriptor;
 
+    // adapt the detector threshold for the next frame
+    if (thresholdCtrl.enabled) {
+      detectionInfoStats.detectorThreshold = thresholdCtrl.threshold;
+      updateThresholdController(thresholdCtrl, detectionInfoStats.numKeypointsFrame,
+                                1000 * (timeKptDetection + timeDescriptor));
+      detectionInfoStats.controllerError = thresholdCtrl.lastError;
+      detectionInfoStats.thresholdAdjusted = thresholdCtrl.lastAdjusted;
+      cout << "Threshold controller: threshold " << detectionInfoStats.detectorThreshold << " -> "
+           << thresholdCtrl.threshold << " (error " << 100 * thresholdCtrl.lastError << " %)" << endl;
+    }
+
     /* MATCH KEYPOINT DESCRIPTORS */
     if (dataBuffer.size() > 1) {
       // wait until at least two images have been processed
@@ -214,13 +300,36 @@ int main(int argc, const char *argv[]) {
       DescriptorMetric descriptorMetric = static_cast<DescriptorMetric>(DescriptorMetricSel);
       NeighborSelectorMethod nnSelector = static_cast<NeighborSelectorMethod>(nnMatcherSelected);
 
-      double timeMatcher =
-          matchDescriptors((dataBuffer.end() - 2)->keypoints, (dataBuffer.end() - 1)->keypoints,
-                           (dataBuffer.end() - 2)->descriptors, (dataBuffer.end() - 1)->descriptors, matches,
-                           descriptorMethod, descriptorMetric, matcherMethod, nnSelector, crossCheckBruteForce);
+      double timeIndexBuild = 0.0;
+      double timeMatcher = 0.0;
+      if (guidedConf.enabled && !(dataBuffer.end() - 2)->keypointMotion.empty()) {
+        // windows around the keypoint positions predicted by the motion of the last frame pair; the index of the
+        // selected matcher is built over the current frame for the keypoints matched globally only
+        timeMatcher = matchDescriptorsGuided(*(dataBuffer.end() - 2), *(dataBuffer.end() - 1),
+                                             (dataBuffer.end() - 2)->keypointMotion, matches,
+                                             selectNormTypeMatcher(descriptorMethod, descriptorMetric), matcherMethod,
+                                             nnSelector, crossCheckBruteForce, guidedConf, nullptr, lshConf, mihConf);
+      } else {
+        timeMatcher = matchDescriptors(*(dataBuffer.end() - 2), *(dataBuffer.end() - 1), matches, descriptorMethod,
+                                       descriptorMetric, matcherMethod, nnSelector, crossCheckBruteForce,
+                                       &timeIndexBuild, lshConf, mihConf);
+      }
+      if (guidedConf.enabled) {
+        // the motion estimate is part of the matching cost of guided matching
+        timeMatcher += estimateKeypointMotion((dataBuffer.end() - 2)->keypoints, (dataBuffer.end() - 1)->keypoints,
+                                              matches, guidedConf, (dataBuffer.end() - 1)->keypointMotion);
+      }
 
       detectionInfoStats.numMatches = matches.size();
-      detectionInfoStats.matchesComputeTimeSec = timeMatcher;
+      detectionInfoStats.indexBuildTimeSec = timeIndexBuild;
+      detectionInfoStats.indexQueryTimeSec = timeMatcher;
+      detectionInfoStats.matchesComputeTimeSec = timeIndexBuild + timeMatcher;
+      if (evaluateRecall) {
+        detectionInfoStats.matcherRecall =
+            evaluateMatchRecall((dataBuffer.end() - 2)->descriptors, (dataBuffer.end() - 1)->descriptors, matches,
+                                selectNormTypeMatcher(descriptorMethod, descriptorMetric));
+        cout << "Matcher recall: " << 100 * detectionInfoStats.matcherRecall << " %" << endl;
+      }
 
       // store matches in current data frame
       (dataBuffer.end() - 1)->kptMatches = matches;
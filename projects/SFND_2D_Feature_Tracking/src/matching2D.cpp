@@ -1,11 +1,21 @@
+#include <algorithm>
 #include <numeric>
 
+#include "cornerSelection.h"
+#include "crossCheckMatcher.h"
+#include "descriptorArena.h"
+#include "descriptorIndex.h"
+#include "fastCorners.h"
+#include "hammingMatcher.h"
+#include "l2Matcher.h"
 #include "matching2D.hpp"
+#include "multiIndexHash.h"
 #include "utils.h"
 
 using namespace std;
 
-double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool visualize) {
+double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool visualize,
+                       const ThresholdController *thresholdCtrl) {
   double timeDetector;
   std::cout << "#2 : DETECT KEYPOINTS" << std::endl;
   switch (detector) {
@@ -15,8 +25,14 @@ double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypo
     case DetectorMethod::HARRIS:
       timeDetector = detKeypointsHarris(keypoints, img);
       break;
+    case DetectorMethod::SHITOMASI_GRID:
+      timeDetector = detKeypointsGrid(keypoints, img, false);
+      break;
+    case DetectorMethod::HARRIS_GRID:
+      timeDetector = detKeypointsGrid(keypoints, img, true);
+      break;
     default:
-      timeDetector = detKeypointsModern(detector, keypoints, img);
+      timeDetector = detKeypointsModern(detector, keypoints, img, thresholdCtrl);
       break;
   }
   // visualize results
@@ -74,30 +90,59 @@ double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img
   return t;
 }
 
-double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
+// Shi-Tomasi/Harris corners with bounded selection cost (grid NMS with per-cell cap and global top-K)
+double detKeypointsGrid(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris) {
+  CornerSelectionConf conf;
+  auto tick = cv::getTickCount();
+  CornerSelectionStats stats = selectCornersBounded(keypoints, img, useHarris, conf);
+  double t = static_cast<double>((cv::getTickCount() - tick)) / cv::getTickFrequency();
+  cout << (useHarris ? "Harris" : "Shi-Tomasi") << " grid detection with n=" << stats.numSelected << " (max "
+       << conf.maxCorners << ", " << stats.numCandidates << " candidates) keypoints in " << 1000 * t
+       << " ms (response " << 1000 * stats.responseTimeSec << " ms, selection " << 1000 * stats.selectionTimeSec
+       << " ms)" << endl;
+  return t;
+}
+
+double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
+                          const ThresholdController *thresholdCtrl) {
   cv::Ptr<cv::FeatureDetector> detectorPtr = nullptr;
+  // the threshold controller (if enabled) overrides the fixed detector parameters below
+  bool useCtrl = (thresholdCtrl != nullptr && thresholdCtrl->enabled);
   auto tick = cv::getTickCount();
   switch (detector) {
     case DetectorMethod::FAST: {
-      int threshold = 40;  // difference between intensity of the central pixel and pixels of a circle around this pixel
+      // difference between intensity of the central pixel and pixels of a circle around this pixel
+      int threshold = useCtrl ? static_cast<int>(thresholdCtrl->threshold) : 40;
       bool setNMS = true;  // perform non-maxima suppression on keypoints
       cv::FastFeatureDetector::DetectorType type = cv::FastFeatureDetector::TYPE_9_16;
       detectorPtr = cv::FastFeatureDetector::create(threshold, setNMS, type);
       break;
     }
+    case DetectorMethod::FAST_SIMD: {
+      // same parameters as FAST, but using the in-tree vectorized kernel
+      int threshold = useCtrl ? static_cast<int>(thresholdCtrl->threshold) : 40;
+      detectorPtr = FastCornerDetector::create(threshold, true);
+      break;
+    }
     case DetectorMethod::BRISK:
-      detectorPtr = cv::BRISK::create();
+      detectorPtr = useCtrl ? cv::BRISK::create(static_cast<int>(thresholdCtrl->threshold)) : cv::BRISK::create();
       break;
     case DetectorMethod::ORB: {
-      int maxNumberFeatures = 500;
+      int maxNumberFeatures = useCtrl ? static_cast<int>(thresholdCtrl->threshold) : 500;
       detectorPtr = cv::ORB::create(maxNumberFeatures);
       break;
     }
-    case DetectorMethod::AKAZE:
-      detectorPtr = cv::AKAZE::create();
+    case DetectorMethod::AKAZE: {
+      cv::Ptr<cv::AKAZE> akaze = cv::AKAZE::create();
+      if (useCtrl) {
+        akaze->setThreshold(thresholdCtrl->threshold);
+      }
+      detectorPtr = akaze;
       break;
+    }
     case DetectorMethod::SIFT:
-      detectorPtr = cv::xfeatures2d::SIFT::create();
+      detectorPtr = useCtrl ? cv::xfeatures2d::SIFT::create(0, 3, thresholdCtrl->threshold)
+                            : cv::xfeatures2d::SIFT::create();
       break;
     default:
       std::cout << "Unknown detector method!" << std::endl;
@@ -158,68 +203,132 @@ double descKeypoints(DescriptorMethod descriptor, vector<cv::KeyPoint> &keypoint
 }
 
 // Find best matches for keypoints in two camera images based on several matching methods
-double matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource,
-                        cv::Mat &descRef, std::vector<cv::DMatch> &matches, DescriptorMethod descriptorMethod,
-                        DescriptorMetric descrMetric, MatcherMethod matcherMethod, NeighborSelectorMethod nnSelector,
-                        bool crossCheck) {
-  // configure matcher
-  cv::Ptr<cv::DescriptorMatcher> matcher;
+double matchDescriptorsWithIndex(DescriptorIndex &index, const cv::Mat &descriptors, std::vector<cv::DMatch> &matches,
+                                 NeighborSelectorMethod nnSelector, bool crossCheck, const MihIndexConf &mihConf,
+                                 int rowBytes) {
+  cv::Ptr<cv::DescriptorMatcher> &matcher = index.matcher;
+  cv::Mat descQuery = toIndexDescriptors(index, descriptors);
+
+  // Perform actual matching
+  /*
+   * TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering
+   * with t=0.8
+   */
+  double timeMatching = 0.0;
+  double minDescriptorDistRatio = 0.8;
+  if (!index.matcher) {
+    // BRUTE_FORCE_SIMD, MULTI_INDEX_HASH: nearest neighbour selection and ratio test are done during the search
+    bool useRatioTest = nnSelector == NeighborSelectorMethod::kNN;
+    double t = (double)cv::getTickCount();
+    if (index.multiIndexHash) {
+      matchMultiIndexHash(descriptors, *index.multiIndexHash, matches, useRatioTest ? minDescriptorDistRatio : 0.0,
+                          mihConf.maxRadius);
+    } else if (index.l2Index) {
+      matchL2(descriptors, *index.l2Index, matches, useRatioTest ? minDescriptorDistRatio : 0.0, crossCheck);
+    } else {
+      matchHamming(descriptors, index.trainDescriptors, matches, useRatioTest ? minDescriptorDistRatio : 0.0,
+                   crossCheck, rowBytes);
+    }
+    timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+    std::cout << " (" << (useRatioTest ? "kNN" : "NN") << ") with n=" << matches.size() << " matches in "
+              << 1000 * timeMatching / 1.0 << " ms" << std::endl;
+  } else {
+    switch (nnSelector) {
+      case NeighborSelectorMethod::NN: {
+        std::cout << "Using NN match selection ..." << std::endl;
+        double t = (double)cv::getTickCount();
+        matcher->match(descQuery, matches);  // Finds the best match in the index for each descriptor
+        timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+        std::cout << " (NN) with n=" << matches.size() << " matches in " << 1000 * timeMatching / 1.0 << " ms"
+                  << std::endl;
+        break;
+      }
+      case NeighborSelectorMethod::kNN: {
+        if (crossCheck && !index.trainDescriptors.empty()) {
+          // cv::BFMatcher ignores the cross-check for k > 1, ratio test and cross-check in a single pass
+          std::cout << "Using kNN match selection with cross-check ..." << std::endl;
+          double t = (double)cv::getTickCount();
+          matchKnnCrossCheck(descQuery, index.trainDescriptors, index.normType, matches, minDescriptorDistRatio);
+          timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+          std::cout << " (kNN) with n=" << matches.size() << " cross-checked matches in " << 1000 * timeMatching / 1.0
+                    << " ms" << std::endl;
+          break;
+        }
+        std::cout << "Using kNN match selection ..." << std::endl;
+        // k nearest neighbors (k=2)
+        int desiredNumMatches = 2;
+        timeMatching = runKNN(descQuery, matches, matcher, desiredNumMatches, minDescriptorDistRatio);
+
+      } break;
+      default:
+        std::cout << "Unknown keypoint/descriptor matching method: allowed NN/kNN only!" << std::endl;
+        return 0.0;
+    }
+  }
+  return timeMatching;
+}
+
+double matchDescriptors(DataFrame &previousFrame, DataFrame &currentFrame, std::vector<cv::DMatch> &matches,
+                        DescriptorMethod descriptorMethod, DescriptorMetric descrMetric, MatcherMethod matcherMethod,
+                        NeighborSelectorMethod nnSelector, bool crossCheck, double *indexBuildTimeSec,
+                        const LshIndexConf &lshConf, const MihIndexConf &mihConf) {
+  if (indexBuildTimeSec != nullptr) {
+    *indexBuildTimeSec = 0.0;
+  }
+  if (previousFrame.descriptors.empty() || currentFrame.descriptors.empty()) {
+    std::cout << "No descriptors to match!" << std::endl;
+    return 0.0;
+  }
   int normType = selectNormTypeMatcher(descriptorMethod, descrMetric);
   /*
    * TASK MP.5 -> add FLANN matching
    */
   // Select matcher method to be used
   switch (matcherMethod) {
-    case MatcherMethod::FLANN: {
+    case MatcherMethod::FLANN:
       std::cout << "Using FLANN matching ..." << std::endl;
-      if (descSource.type() != CV_32F) {
-        // OpenCV bug workaround : convert binary descriptors to floating point due to
-        // a bug in current OpenCV implementation
-        std::cout << "Bypassing OpenCV FLANN implementation bug ..." << std::endl;
-        descSource.convertTo(descSource, CV_32F);
-      }
-      if (descRef.type() != CV_32F) {
-        descRef.convertTo(descRef, CV_32F);
-      }
-      matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
       break;
-    }
+    case MatcherMethod::FLANN_LSH:
+      std::cout << "Using FLANN LSH matching ..." << std::endl;
+      break;
     case MatcherMethod::BRUTE_FORCE:
       std::cout << "Using BRUTE_FORCE matching ..." << std::endl;
-      matcher = cv::BFMatcher::create(normType, crossCheck);
+      break;
+    case MatcherMethod::BRUTE_FORCE_SIMD:
+      std::cout << "Using BRUTE_FORCE_SIMD ("
+                << (currentFrame.descriptors.depth() == CV_32F ? l2MatcherInstructionSet()
+                                                               : hammingMatcherInstructionSet())
+                << ") matching ..." << std::endl;
+      break;
+    case MatcherMethod::MULTI_INDEX_HASH:
+      std::cout << "Using MULTI_INDEX_HASH matching ..." << std::endl;
       break;
     default:
-      std::cout << "Unknown descriptor matcher method! Defaulting to BRUTE_FORCE" << std::endl;
-      matcher = cv::BFMatcher::create(normType, crossCheck);
+      break;
   }
 
-  // Perform actual matching
-  /*
-   * TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering
-   * with t=0.8
-   */
-  double timeMatching = 0.0;
-  switch (nnSelector) {
-    case NeighborSelectorMethod::NN: {
-      std::cout << "Using NN match selection ..." << std::endl;
-      double t = (double)cv::getTickCount();
-      matcher->match(descSource, descRef, matches);  // Finds the best match for each descriptor in desc1
-      timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
-      std::cout << " (NN) with n=" << matches.size() << " matches in " << 1000 * timeMatching / 1.0 << " ms"
-                << std::endl;
-      break;
-    }
-    case NeighborSelectorMethod::kNN: {
-      std::cout << "Using kNN match selection ..." << std::endl;
-      // k nearest neighbors (k=2)
-      int desiredNumMatches = 2;
-      double minDescriptorDistRatio = 0.8;
-      timeMatching = runKNN(descSource, descRef, matches, matcher, desiredNumMatches, minDescriptorDistRatio);
+  if (crossCheck && (matcherMethod == MatcherMethod::FLANN || matcherMethod == MatcherMethod::FLANN_LSH)) {
+    std::cout << "Cross-check is supported by the brute force matchers only, ignored" << std::endl;
+  }
 
-    } break;
-    default:
-      std::cout << "Unknown keypoint/descriptor matching method: allowed NN/kNN only!" << std::endl;
-      return 0.0;
+  // build the index over the previous frame only if it has not been built by an earlier frame pair
+  if (!isDescriptorIndexValid(previousFrame.descriptorIndex, matcherMethod, normType, crossCheck)) {
+    previousFrame.descriptorIndex =
+        buildDescriptorIndex(previousFrame.descriptors, matcherMethod, normType, crossCheck, lshConf, mihConf);
+    std::cout << "Descriptor index (n=" << previousFrame.descriptorIndex->numDescriptors << ") built in "
+              << 1000 * previousFrame.descriptorIndex->buildTimeSec / 1.0 << " ms" << std::endl;
+    if (indexBuildTimeSec != nullptr) {
+      *indexBuildTimeSec = previousFrame.descriptorIndex->buildTimeSec;
+    }
+  } else {
+    std::cout << "Reusing descriptor index of previous frame" << std::endl;
+  }
+  double timeMatching =
+      matchDescriptorsWithIndex(*previousFrame.descriptorIndex, currentFrame.descriptors, matches, nnSelector,
+                                crossCheck, mihConf, paddedRowBytes(previousFrame, currentFrame));
+  // the current frame is the query side of the index
+  for (auto &match : matches) {
+    std::swap(match.queryIdx, match.trainIdx);
   }
   std::cout << "#4 : MATCH KEYPOINT DESCRIPTORS done" << std::endl;
   return timeMatching;
@@ -241,15 +350,16 @@ int selectNormTypeMatcher(DescriptorMethod descriptorMethod, DescriptorMetric de
   }
 }
 
-double runKNN(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
-              cv::Ptr<cv::DescriptorMatcher> &matcher, int desiredNumMatches, double minDescriptorDistRatio) {
+double runKNN(const cv::Mat &descQuery, std::vector<cv::DMatch> &matches, cv::Ptr<cv::DescriptorMatcher> &matcher,
+              int desiredNumMatches, double minDescriptorDistRatio) {
   std::vector<std::vector<cv::DMatch>> knn_matches;
   double time = (double)cv::getTickCount();
-  matcher->knnMatch(descSource, descRef, knn_matches, desiredNumMatches);
+  matcher->knnMatch(descQuery, knn_matches, desiredNumMatches);
   time = ((double)cv::getTickCount() - time) / cv::getTickFrequency();
   std::cout << " (kNN) with n=" << knn_matches.size() << " matches in " << 1000 * time / 1.0 << " ms" << std::endl;
   for (auto it = knn_matches.begin(); it != knn_matches.end(); ++it) {
-    if ((*it)[0].distance < minDescriptorDistRatio * (*it)[1].distance) {
+    // the ratio test needs a second neighbour (missing for tiny indices or cross-checked brute force)
+    if (it->size() > 1 && (*it)[0].distance < minDescriptorDistRatio * (*it)[1].distance) {
       matches.push_back((*it)[0]);
     }
   }
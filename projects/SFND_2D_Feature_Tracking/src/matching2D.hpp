@@ -17,24 +17,35 @@
 #include <opencv2/xfeatures2d/nonfree.hpp>
 
 #include "dataStructures.h"
+#include "thresholdController.h"
 
 double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
-                       bool visualize = false);
+                       bool visualize = false, const ThresholdController *thresholdCtrl = nullptr);
 double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris);
 double detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
 double detKeypointsShiTomasi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
-double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
+double detKeypointsGrid(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris);
+double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
+                          const ThresholdController *thresholdCtrl = nullptr);
 
 double descKeypoints(DescriptorMethod descriptor, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
                      cv::Mat &descriptors);
 
-double matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource,
-                        cv::Mat &descRef, std::vector<cv::DMatch> &matches, DescriptorMethod descriptorMethod,
-                        DescriptorMetric descrMetric, MatcherMethod matcherMethod, NeighborSelectorMethod nnSelector,
-                        bool crossCheck);
+// Match the current frame against the descriptor index of the previous frame (built on first use and kept in the
+// frame); returns the query time, the index build time (0 if the index was reused) is stored in indexBuildTimeSec
+double matchDescriptors(DataFrame &previousFrame, DataFrame &currentFrame, std::vector<cv::DMatch> &matches,
+                        DescriptorMethod descriptorMethod, DescriptorMetric descrMetric, MatcherMethod matcherMethod,
+                        NeighborSelectorMethod nnSelector, bool crossCheck, double *indexBuildTimeSec = nullptr,
+                        const LshIndexConf &lshConf = LshIndexConf(), const MihIndexConf &mihConf = MihIndexConf());
+/* Nearest neighbour (NN) or ratio tested (kNN) matches of the descriptors in the index, queryIdx = descriptor row,
+ * trainIdx = index row; rowBytes as for matchHamming (hammingMatcher.h). Returns the matching time in seconds.
+ */
+double matchDescriptorsWithIndex(DescriptorIndex &index, const cv::Mat &descriptors, std::vector<cv::DMatch> &matches,
+                                 NeighborSelectorMethod nnSelector, bool crossCheck,
+                                 const MihIndexConf &mihConf = MihIndexConf(), int rowBytes = 0);
 int selectNormTypeMatcher(DescriptorMethod descriptorMethod, DescriptorMetric descrMetric);
-double runKNN(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
-              cv::Ptr<cv::DescriptorMatcher> &matcher, int desiredNumMatches, double minDescriptorDistRatio);
+double runKNN(const cv::Mat &descQuery, std::vector<cv::DMatch> &matches, cv::Ptr<cv::DescriptorMatcher> &matcher,
+              int desiredNumMatches, double minDescriptorDistRatio);
 
 std::string DetectorMethodToString(int value);
 std::string DescriptorMethodToString(int value);
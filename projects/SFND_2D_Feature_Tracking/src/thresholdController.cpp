@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "thresholdController.h"
+#include "utils.h"
+
+ThresholdController createThresholdController(DetectorMethod detector, int targetKeypoints, double targetTimeMs) {
+  ThresholdController ctrl;
+  ctrl.targetKeypoints = targetKeypoints;
+  ctrl.targetTimeMs = targetTimeMs;
+  if (targetKeypoints <= 0 && targetTimeMs <= 0) {
+    return ctrl;
+  }
+
+  // initial values are the fixed parameters used by detKeypointsModern
+  ctrl.enabled = true;
+  switch (detector) {
+    case DetectorMethod::FAST:
+    case DetectorMethod::FAST_SIMD:
+      ctrl.threshold = 40;
+      ctrl.minThreshold = 1;
+      ctrl.maxThreshold = 250;
+      break;
+    case DetectorMethod::BRISK:
+      ctrl.threshold = 30;
+      ctrl.minThreshold = 1;
+      ctrl.maxThreshold = 250;
+      break;
+    case DetectorMethod::ORB:
+      ctrl.threshold = 500;
+      ctrl.minThreshold = 50;
+      ctrl.maxThreshold = 50000;
+      ctrl.higherGivesMore = true;
+      break;
+    case DetectorMethod::AKAZE:
+      ctrl.threshold = 0.001;
+      ctrl.minThreshold = 1e-5;
+      ctrl.maxThreshold = 0.1;
+      ctrl.integerThreshold = false;
+      break;
+    case DetectorMethod::SIFT:
+      ctrl.threshold = 0.04;
+      ctrl.minThreshold = 1e-3;
+      ctrl.maxThreshold = 0.5;
+      ctrl.integerThreshold = false;
+      break;
+    default:
+      std::cout << "Threshold control is not supported for the " << DetectorMethodToString(detector)
+                << " detector, using fixed parameters" << std::endl;
+      ctrl.enabled = false;
+      break;
+  }
+  return ctrl;
+}
+
+void updateThresholdController(ThresholdController &ctrl, int numKeypoints, double timeMs) {
+  ctrl.lastAdjusted = false;
+  if (!ctrl.enabled) {
+    return;
+  }
+  double ratio = (ctrl.targetKeypoints > 0) ? std::max(numKeypoints, 1) / static_cast<double>(ctrl.targetKeypoints)
+                                            : std::max(timeMs, 1e-3) / ctrl.targetTimeMs;
+  ctrl.lastError = ratio - 1.0;
+  double band = ctrl.settled ? ctrl.outerBand : ctrl.innerBand;
+  ctrl.settled = (std::abs(ctrl.lastError) <= band);
+  if (ctrl.settled) {
+    return;
+  }
+
+  // too many keypoints (or too slow): raise the threshold, resp. lower the max. number of features
+  double scale = std::pow(ratio, ctrl.gain);
+  double newThreshold = ctrl.higherGivesMore ? ctrl.threshold / scale : ctrl.threshold * scale;
+  if (ctrl.integerThreshold) {
+    newThreshold = std::round(newThreshold);
+    if (newThreshold == ctrl.threshold) {
+      // move at least one step, otherwise small thresholds would never change
+      bool increase = (ratio > 1.0) != ctrl.higherGivesMore;
+      newThreshold += increase ? 1 : -1;
+    }
+  }
+  newThreshold = std::min(std::max(newThreshold, ctrl.minThreshold), ctrl.maxThreshold);
+  ctrl.lastAdjusted = (newThreshold != ctrl.threshold);
+  ctrl.threshold = newThreshold;
+}
@@ -0,0 +1,36 @@
+#ifndef thresholdController_h
+#define thresholdController_h
+
+#include "dataStructures.h"
+
+/* Closed-loop controller for the sensitivity parameter of the modern detectors.
+ *
+ * After every frame the parameter is scaled by (measured / target)^gain, where the measured value is either the number
+ * of detected keypoints or the detection + description time of the frame. The controller uses hysteresis: once settled
+ * it only starts adjusting again when the deviation leaves the outer band, and then keeps adjusting until the
+ * deviation is inside the inner band, so frame to frame noise does not make it oscillate. The controlled parameter is the
+ * FAST/BRISK threshold, the AKAZE threshold, the SIFT contrast threshold or the max. number of ORB features.
+ */
+struct ThresholdController {
+  bool enabled = false;
+  int targetKeypoints = 0;   // target no. of keypoints per frame
+  double targetTimeMs = 0;   // target detection + description time per frame, used if targetKeypoints is 0
+  double outerBand = 0.15;   // relative deviation from the target which triggers an adjustment
+  double innerBand = 0.05;   // relative deviation from the target at which the controller settles
+  double gain = 0.7;         // exponent of the multiplicative update (1 = full correction, < 1 damped)
+
+  double threshold = 0;  // current detector parameter
+  double minThreshold = 0;
+  double maxThreshold = 0;
+  bool higherGivesMore = false;  // raising the parameter yields more keypoints (ORB max. features)
+  bool integerThreshold = true;
+
+  double lastError = 0;       // relative deviation of the last frame from the target
+  bool settled = true;        // deviation within the bands, parameter is held
+  bool lastAdjusted = false;  // parameter has been changed after the last frame
+};
+
+ThresholdController createThresholdController(DetectorMethod detector, int targetKeypoints, double targetTimeMs);
+void updateThresholdController(ThresholdController &ctrl, int numKeypoints, double timeMs);
+
+#endif /* thresholdController_h */
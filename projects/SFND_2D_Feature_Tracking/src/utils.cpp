@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -25,15 +26,20 @@ std::string getDatasetImageName(DataSetConfig &dataInfo, size_t imgIndex) {
   return ss.str();
 }
 
-void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame) {
-  int dataBufferSize = 2;  // no. of images which are held in memory (ring buffer) at the same time
+void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame, size_t bufferSize) {
+  size_t dataBufferSize = std::max<size_t>(bufferSize, 2);  // no. of images which are held in memory at the same time
   if (buffer.size() < dataBufferSize) {
     buffer.emplace_back(newFrame);
     std::cout << "Initializing buffer; Buffer size is: " << buffer.size() << std::endl;
   } else {
     std::rotate(buffer.begin(), buffer.begin() + 1, buffer.end());
+    // recycle the descriptor memory of the dropped frame unless something else still refers to it
+    std::shared_ptr<DescriptorArena> arena = buffer.back().descriptorArena;
     buffer.pop_back();
     buffer.emplace_back(newFrame);
+    if (!buffer.back().descriptorArena && arena.use_count() == 1) {
+      buffer.back().descriptorArena = arena;
+    }
     std::cout << "Updating buffer; Buffer size is: " << buffer.size() << std::endl;
   }
 
@@ -118,9 +124,23 @@ void initSummaryFile(std::ofstream &ost, DetectorMethod detector, DescriptorMeth
         << ","
         << "DescriptorTime(ms)"
         << ","
+        << "MatchedPoints"
+        << ","
         << "MatchingTime(ms)"
         << ","
-        << "TotalTime(ms)" << std::endl;
+        << "TotalTime(ms)"
+        << ","
+        << "DetectorThreshold"
+        << ","
+        << "ControllerError"
+        << ","
+        << "ThresholdAdjusted"
+        << ","
+        << "IndexBuildTime(ms)"
+        << ","
+        << "IndexQueryTime(ms)"
+        << ","
+        << "MatcherRecall" << std::endl;
     //  ost << "Frame"
     //     << ","
     //     << "DetectorType"
@@ -171,6 +191,8 @@ void appendToSummaryInfoFile(std::ofstream &ost, DetectionResult &stats) {
         << 1000.0 * stats.detectionComputeTimeSec << "," << 1000.0 * stats.descriptorComputeTimeSec << ","
         << stats.numMatches << "," << 1000.0 * stats.matchesComputeTimeSec << ", "
         << 1000.0 * (stats.detectionComputeTimeSec + stats.descriptorComputeTimeSec + stats.matchesComputeTimeSec)
+        << "," << stats.detectorThreshold << "," << stats.controllerError << "," << stats.thresholdAdjusted << ","
+        << 1000.0 * stats.indexBuildTimeSec << "," << 1000.0 * stats.indexQueryTimeSec << "," << stats.matcherRecall
         << std::endl;
     //   ost << stats.imageIndex << "," << DetectorMethodToString(stats.detector) << ","
     //       << DescriptorMethodToString(stats.descriptor) << "," << stats.numKeypointsROI << "," << stats.numMatches <<
@@ -22,7 +22,8 @@ struct DataSetConfig {
 void loadNextImage(std::string imgFullFilename, cv::Mat &imgGray);
 std::string getDatasetImageName(DataSetConfig &dataInfo, size_t imgIndex);
 
-void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame);
+// Ring buffer of the last bufferSize frames, at least the previous and the current frame
+void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame, size_t bufferSize = 2);
 
 bool isInsideROI(cv::KeyPoint &kpt, cv::Rect &rectangle);
 
@@ -48,6 +49,12 @@ inline std::string DetectorMethodToString(const DetectorMethod &v) {
       return "ORB";
     case DetectorMethod::SIFT:
       return "SIFT";
+    case DetectorMethod::FAST_SIMD:
+      return "FAST-SIMD";
+    case DetectorMethod::SHITOMASI_GRID:
+      return "SHI-TOMASI-GRID";
+    case DetectorMethod::HARRIS_GRID:
+      return "HARRIS-GRID";
     default:
       return "[Unknown DetectorMethod]";
   }
@@ -89,6 +96,12 @@ inline std::string MatcherMethodToString(const MatcherMethod &v) {
       return "BRUTE_FORCE";
     case MatcherMethod::FLANN:
       return "FLANN";
+    case MatcherMethod::FLANN_LSH:
+      return "FLANN_LSH";
+    case MatcherMethod::BRUTE_FORCE_SIMD:
+      return "BRUTE_FORCE_SIMD";
+    case MatcherMethod::MULTI_INDEX_HASH:
+      return "MULTI_INDEX_HASH";
     default:
       return "[Unknown MatcherMethod]";
   }
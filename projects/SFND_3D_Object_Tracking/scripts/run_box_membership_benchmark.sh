@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Keypoint-to-box membership built with a box grid vs. testing every keypoint against every box, for scenes with many
+# boxes: the keypoints of each KITTI frame (FAST) with 10 to 1000 random boxes (--eval-box-membership). Reports the
+# mean time per frame of both, the speedup and the no. of frames whose memberships differ (expected: 0).
+
+cd ../build
+
+report() {
+  awk -v boxes="$1" '
+    /Box membership benchmark:/ {
+      keypoints += $5; grid += $12; allPairs += $16; n++
+      if ($20 != "identical") mismatches++
+    }
+    END {
+      printf "%5d boxes  keypoints: %6.0f  grid: %7.3f ms  all pairs: %7.3f ms  speedup: %5.1f  mismatches: %d\n",
+             boxes, keypoints / n, grid / n, allPairs / n, grid > 0 ? allPairs / grid : 0, mismatches
+    }'
+}
+
+args="--detector 4 --descriptor 0 --show-ttc 0"
+for boxes in 10 50 200 500 1000
+do
+  ./3D_object_tracking $args --eval-box-membership $boxes | report $boxes
+done
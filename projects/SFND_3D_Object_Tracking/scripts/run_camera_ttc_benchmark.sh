@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Camera TTC from sampled keypoint pairs vs. all unique pairs (FAST + BRISK) for several pair budgets, and the
+# histogram median of the distance ratios vs. the exact median for several error bounds, and the RANSAC / LMedS scale
+# fit vs. the median distance ratio.
+# Every frame is estimated both ways (--eval-camera-ttc); reported are the deviations from the reference (all pairs,
+# exact median) and the mean time of both estimates.
+
+cd ../build
+
+for budget in 2000 5000 20000 50000
+do
+  ./3D_object_tracking --detector 4 --descriptor 0 --show-ttc 0 --camera-ttc-pairs 1 --camera-ttc-pair-budget $budget \
+    --eval-camera-ttc 1 | awk -v budget=$budget '
+    /Camera TTC accuracy:/ {
+      split($0, parts, "deviation "); deviation = parts[2] + 0; deviation = deviation < 0 ? -deviation : deviation
+      split($0, times, " ms"); n1 = split(times[1], a, " "); n2 = split(times[2], b, " ")
+      sum += deviation; if (deviation > max) max = deviation; sampled += a[n1]; all += b[n2]; n++
+    }
+    END {
+      printf "budget %6d  |deviation| mean: %6.2f %%  max: %6.2f %%  time sampled: %7.3f ms  all pairs: %7.3f ms\n",
+             budget, n ? sum / n : 0, max, n ? sampled / n : 0, n ? all / n : 0
+    }'
+done
+
+# Histogram median vs. exact median of the distance ratios of all keypoint pairs, for several error bounds
+for error in 1e-3 1e-5 1e-7
+do
+  ./3D_object_tracking --detector 4 --descriptor 0 --show-ttc 0 --camera-ttc-median 1 --median-error $error \
+    --eval-camera-ttc 1 | awk -v error=$error '
+    /Camera TTC median accuracy:/ {
+      split($0, parts, "ratio error "); ratio = parts[2] + 0; ratio = ratio < 0 ? -ratio : ratio
+      split($0, parts, "TTC deviation "); deviation = parts[2] + 0; deviation = deviation < 0 ? -deviation : deviation
+      split($0, times, " ms"); n1 = split(times[1], a, " "); n2 = split(times[2], b, " ")
+      sub(/\(/, "", b[n2]); if (ratio > max) max = ratio; sum += deviation; histogram += a[n1]; exact += b[n2]; n++
+    }
+    END {
+      printf "error %s  max. |ratio error|: %.2e  |TTC deviation| mean: %6.3f %%", error, max, n ? sum / n : 0
+      printf "  time histogram: %7.3f ms  exact: %7.3f ms\n", n ? histogram / n : 0, n ? exact / n : 0
+    }'
+done
+
+# RANSAC / LMedS scale of a similarity transform vs. the median distance ratio of all keypoint pairs
+for method in 1 2
+do
+  ./3D_object_tracking --detector 4 --descriptor 0 --show-ttc 0 --camera-ttc-method $method --eval-camera-ttc 1 | \
+    awk -v method=$method '
+    /Camera TTC agreement:/ {
+      split($0, parts, "deviation "); deviation = parts[2] + 0; deviation = deviation < 0 ? -deviation : deviation
+      split($0, times, " ms"); n1 = split(times[1], a, "("); n2 = split(times[2], b, "(")
+      sum += deviation; if (deviation > max) max = deviation; fit += a[n1]; ratios += b[n2]; n++
+    }
+    END {
+      name = method == 1 ? "RANSAC" : "LMedS "
+      printf "method %s  |deviation| mean: %6.2f %%  max: %6.2f %%", name, n ? sum / n : 0, max
+      printf "  time fit: %7.3f ms  distance ratios: %7.3f ms\n", n ? fit / n : 0, n ? ratios / n : 0
+    }'
+done
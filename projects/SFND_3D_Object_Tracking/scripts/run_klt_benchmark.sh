@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Detect/describe/match (FAST + BRISK, brute force kNN) vs. KLT tracking (FAST keypoints, re-detected when fewer than
+# --klt-min-tracks keypoints are tracked) on the KITTI sequence.
+# Latency is the time to get the keypoint correspondences of a frame pair (first frame excluded). TTC stability is
+# measured on the camera TTC of the preceding vehicle: mean and stddev over the sequence, mean absolute change between
+# consecutive frames and the no. of invalid estimates (nan, inf or negative); the mean absolute deviation from the
+# lidar TTC is given for reference.
+
+cd ../build
+
+report() {
+  awk -v name="$1" '
+    /Keypoint correspondences in/ { if (frames++ > 0) { time += $5; n++ } }
+    /TTC Lidar:/ {
+      lidar = $4; camera = $8
+      if (camera !~ /^-?[0-9.e+-]+$/ || camera + 0 <= 0) { invalid++; next }
+      sum += camera; sumSq += camera * camera; valid++; deviation += (camera > lidar ? camera - lidar : lidar - camera)
+      if (last != "") { change += (camera > last ? camera - last : last - camera); changes++ }
+      last = camera
+    }
+    END {
+      mean = valid ? sum / valid : 0
+      stddev = valid ? sqrt(sumSq / valid - mean * mean) : 0
+      printf "%-24s latency: %8.2f ms  TTC camera: %6.2f +- %5.2f s  mean |change|: %5.2f s", name, time / n, mean,
+             stddev, changes ? change / changes : 0
+      printf "  invalid: %d  |camera - lidar|: %5.2f s\n", invalid, valid ? deviation / valid : 0
+    }'
+}
+
+args="--detector 4 --descriptor 0 --show-ttc 0"
+./3D_object_tracking $args --matcher 0 --matcher-selector 1 | report "FAST + BRISK"
+for minTracks in 300 1000 2000
+do
+  ./3D_object_tracking $args --klt-tracking 1 --klt-min-tracks $minTracks | report "KLT min-tracks=$minTracks"
+done
+./3D_object_tracking $args --klt-tracking 1 --klt-fb-error 0.5 | report "KLT fb-error=0.5"
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <limits>
+
+#include "boxAssignment.h"
+
+namespace {
+
+struct Edge {
+	int votes, row, col;
+};
+
+std::vector<int> assignGreedy(const std::vector<int> &votes, int rows, int cols, int minVotes) {
+	std::vector<Edge> edges;
+	for (int row = 0; row < rows; ++row) {
+		for (int col = 0; col < cols; ++col) {
+			int v = votes[row * cols + col];
+			if (v >= minVotes) {
+				edges.push_back({v, row, col});
+			}
+		}
+	}
+	// most votes first, ties in matrix order so the result does not depend on the sort implementation
+	std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+		return a.votes != b.votes ? a.votes > b.votes : (a.row != b.row ? a.row < b.row : a.col < b.col);
+	});
+	std::vector<int> colOfRow(rows, -1);
+	std::vector<char> colAssigned(cols, 0);
+	for (const auto &edge : edges) {
+		if (colOfRow[edge.row] < 0 && !colAssigned[edge.col]) {
+			colOfRow[edge.row] = edge.col;
+			colAssigned[edge.col] = 1;
+		}
+	}
+	return colOfRow;
+}
+
+/* Minimum cost assignment of every row of an n x m cost matrix (n <= m) to a distinct column, shortest augmenting
+ * paths with row / column potentials (Kuhn-Munkres in O(n^2 m))
+ */
+std::vector<int> minCostAssignment(const std::vector<long> &cost, int n, int m) {
+	const long inf = std::numeric_limits<long>::max() / 2;
+	// 1-based: column 0 is the virtual start of the augmenting path
+	std::vector<long> u(n + 1, 0), v(m + 1, 0), minSlack(m + 1);
+	std::vector<int> rowOfCol(m + 1, 0), way(m + 1, 0);
+	std::vector<char> used(m + 1);
+	for (int row = 1; row <= n; ++row) {
+		rowOfCol[0] = row;
+		int col0 = 0;
+		std::fill(minSlack.begin(), minSlack.end(), inf);
+		std::fill(used.begin(), used.end(), 0);
+		do {
+			used[col0] = 1;
+			int row0 = rowOfCol[col0], col1 = 0;
+			long delta = inf;
+			for (int col = 1; col <= m; ++col) {
+				if (used[col]) {
+					continue;
+				}
+				long slack = cost[(row0 - 1) * m + (col - 1)] - u[row0] - v[col];
+				if (slack < minSlack[col]) {
+					minSlack[col] = slack;
+					way[col] = col0;
+				}
+				if (minSlack[col] < delta) {
+					delta = minSlack[col];
+					col1 = col;
+				}
+			}
+			for (int col = 0; col <= m; ++col) {
+				if (used[col]) {
+					u[rowOfCol[col]] += delta;
+					v[col] -= delta;
+				} else {
+					minSlack[col] -= delta;
+				}
+			}
+			col0 = col1;
+		} while (rowOfCol[col0] != 0);
+		// augment along the path
+		do {
+			int col1 = way[col0];
+			rowOfCol[col0] = rowOfCol[col1];
+			col0 = col1;
+		} while (col0 != 0);
+	}
+	std::vector<int> colOfRow(n, -1);
+	for (int col = 1; col <= m; ++col) {
+		if (rowOfCol[col] > 0) {
+			colOfRow[rowOfCol[col] - 1] = col - 1;
+		}
+	}
+	return colOfRow;
+}
+
+std::vector<int> assignHungarian(const std::vector<int> &votes, int rows, int cols, int minVotes) {
+	// maximum votes = minimum of (max. votes - votes); the smaller dimension is assigned completely
+	bool transposed = rows > cols;
+	int n = transposed ? cols : rows, m = transposed ? rows : cols;
+	int maxVotes = 0;
+	for (int v : votes) {
+		maxVotes = std::max(maxVotes, v);
+	}
+	auto effectiveVotes = [&](int row, int col) {
+		int v = votes[row * cols + col];
+		return v >= minVotes ? v : 0;
+	};
+	std::vector<long> cost(static_cast<size_t>(n) * m);
+	for (int i = 0; i < n; ++i) {
+		for (int j = 0; j < m; ++j) {
+			int v = transposed ? effectiveVotes(j, i) : effectiveVotes(i, j);
+			cost[static_cast<size_t>(i) * m + j] = maxVotes - v;
+		}
+	}
+	std::vector<int> assigned = minCostAssignment(cost, n, m);
+
+	std::vector<int> colOfRow(rows, -1);
+	for (int i = 0; i < n; ++i) {
+		int row = transposed ? assigned[i] : i, col = transposed ? i : assigned[i];
+		// pairs without (enough) votes only complete the assignment
+		if (row >= 0 && col >= 0 && votes[row * cols + col] >= minVotes) {
+			colOfRow[row] = col;
+		}
+	}
+	return colOfRow;
+}
+
+}  // namespace
+
+std::vector<int> assignBoxes(const std::vector<int> &votes, int rows, int cols, BoxAssignment method, int minVotes) {
+	if (rows == 0 || cols == 0) {
+		return std::vector<int>(rows, -1);
+	}
+	minVotes = std::max(minVotes, 1);
+	return method == BoxAssignment::HUNGARIAN ? assignHungarian(votes, rows, cols, minVotes)
+											  : assignGreedy(votes, rows, cols, minVotes);
+}
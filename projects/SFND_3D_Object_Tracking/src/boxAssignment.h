@@ -0,0 +1,18 @@
+#ifndef BOX_ASSIGNMENT_H_
+#define BOX_ASSIGNMENT_H_
+
+#include <vector>
+
+#include "dataStructures.h"
+
+/* One-to-one assignment of the rows (previous frame boxes) to the columns (current frame boxes) of a dense vote
+ * matrix, votes[row * cols + col] = no. of keypoint matches shared by the two boxes:
+ * - GREEDY: the pairs with votes sorted by votes (descending), each one taken if neither of its boxes is assigned yet;
+ *   O(E log E) for E pairs with votes. Not optimal in general, but the pair with the most votes of its row and its
+ *   column is always taken.
+ * - HUNGARIAN (Kuhn-Munkres): the assignment with the most votes in total; O(n^3) for n = max(rows, cols).
+ * Pairs with fewer than minVotes votes are never assigned. Returns the column of each row, -1 if it is not assigned.
+ */
+std::vector<int> assignBoxes(const std::vector<int> &votes, int rows, int cols, BoxAssignment method, int minVotes);
+
+#endif /* BOX_ASSIGNMENT_H_ */
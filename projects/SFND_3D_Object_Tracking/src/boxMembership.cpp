@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "boxMembership.h"
+
+namespace {
+
+const unsigned kBenchmarkSeed = 42;
+const int kBenchmarkRepetitions = 10;
+
+/* Grid of cells over the extent of the boxes, the boxes overlapping each cell in compressed rows: the boxes of cell c
+ * are boxOfCell[cellStart[c] .. cellStart[c + 1])
+ */
+struct BoxGrid {
+	int originX = 0, originY = 0;
+	int cellSize = 1;
+	int cols = 0, rows = 0;
+	std::vector<int> cellStart;
+	std::vector<int> boxOfCell;
+};
+
+// Cell range [first, last] overlapped by the pixel range [begin, end) on an axis of the grid
+void cellRange(int begin, int end, int origin, int cellSize, int numCells, int &first, int &last) {
+	first = std::max((begin - origin) / cellSize, 0);
+	last = std::min((end - 1 - origin) / cellSize, numCells - 1);
+}
+
+BoxGrid buildBoxGrid(const std::vector<BoundingBox> &boxes, int cellSize) {
+	BoxGrid grid;
+	grid.cellSize = std::max(cellSize, 1);
+	int minX = std::numeric_limits<int>::max(), minY = minX;
+	int maxX = std::numeric_limits<int>::min(), maxY = maxX;
+	for (const auto &box : boxes) {
+		if (box.roi.width <= 0 || box.roi.height <= 0) {
+			continue;
+		}
+		minX = std::min(minX, box.roi.x);
+		minY = std::min(minY, box.roi.y);
+		maxX = std::max(maxX, box.roi.x + box.roi.width);
+		maxY = std::max(maxY, box.roi.y + box.roi.height);
+	}
+	if (minX >= maxX) {
+		grid.cellStart.assign(1, 0);
+		return grid;
+	}
+	grid.originX = minX;
+	grid.originY = minY;
+	grid.cols = (maxX - minX + grid.cellSize - 1) / grid.cellSize;
+	grid.rows = (maxY - minY + grid.cellSize - 1) / grid.cellSize;
+
+	// count the boxes of each cell, then fill (counting sort)
+	std::vector<int> count(grid.cols * grid.rows + 1, 0);
+	auto forCellsOfBox = [&](const cv::Rect &roi, int boxIdx, bool fill) {
+		int firstCol, lastCol, firstRow, lastRow;
+		cellRange(roi.x, roi.x + roi.width, grid.originX, grid.cellSize, grid.cols, firstCol, lastCol);
+		cellRange(roi.y, roi.y + roi.height, grid.originY, grid.cellSize, grid.rows, firstRow, lastRow);
+		for (int row = firstRow; row <= lastRow; ++row) {
+			for (int col = firstCol; col <= lastCol; ++col) {
+				int cell = row * grid.cols + col;
+				if (fill) {
+					grid.boxOfCell[count[cell]++] = boxIdx;
+				} else {
+					++count[cell + 1];
+				}
+			}
+		}
+	};
+	int numBoxes = static_cast<int>(boxes.size());
+	for (int b = 0; b < numBoxes; ++b) {
+		if (boxes[b].roi.width > 0 && boxes[b].roi.height > 0) {
+			forCellsOfBox(boxes[b].roi, b, false);
+		}
+	}
+	for (size_t cell = 1; cell < count.size(); ++cell) {
+		count[cell] += count[cell - 1];
+	}
+	grid.cellStart = count;
+	grid.boxOfCell.resize(count.back());
+	for (int b = 0; b < numBoxes; ++b) {
+		if (boxes[b].roi.width > 0 && boxes[b].roi.height > 0) {
+			forCellsOfBox(boxes[b].roi, b, true);
+		}
+	}
+	return grid;
+}
+
+}  // namespace
+
+std::shared_ptr<BoxMembership> buildBoxMembership(const std::vector<cv::KeyPoint> &keypoints,
+												  const std::vector<BoundingBox> &boxes, int cellSize) {
+	auto membership = std::make_shared<BoxMembership>();
+	membership->numKeypoints = static_cast<int>(keypoints.size());
+	membership->numBoxes = static_cast<int>(boxes.size());
+	membership->wordsPerKeypoint = (membership->numBoxes + 63) / 64;
+	membership->bits.assign(static_cast<size_t>(membership->numKeypoints) * membership->wordsPerKeypoint, 0);
+	if (membership->numBoxes == 0) {
+		return membership;
+	}
+
+	BoxGrid grid = buildBoxGrid(boxes, cellSize);
+	for (int k = 0; k < membership->numKeypoints; ++k) {
+		// the pixel cv::Rect::contains tests a keypoint at: its position rounded to the nearest integer
+		cv::Point pt(cvRound(keypoints[k].pt.x), cvRound(keypoints[k].pt.y));
+		if (pt.x < grid.originX || pt.y < grid.originY) {
+			continue;
+		}
+		int col = (pt.x - grid.originX) / grid.cellSize;
+		int row = (pt.y - grid.originY) / grid.cellSize;
+		if (col >= grid.cols || row >= grid.rows) {
+			continue;
+		}
+		int cell = row * grid.cols + col;
+		uint64_t *bits = membership->bits.data() + static_cast<size_t>(k) * membership->wordsPerKeypoint;
+		for (int i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; ++i) {
+			int b = grid.boxOfCell[i];
+			if (boxes[b].roi.contains(pt)) {
+				bits[b >> 6] |= uint64_t(1) << (b & 63);
+			}
+		}
+	}
+	return membership;
+}
+
+const BoxMembership *validBoxMembership(const DataFrame &frame) {
+	const BoxMembership *membership = frame.boxMembership.get();
+	if (!membership || membership->numKeypoints != static_cast<int>(frame.keypoints.size()) ||
+		membership->numBoxes != static_cast<int>(frame.boundingBoxes.size())) {
+		return nullptr;
+	}
+	return membership;
+}
+
+const BoxMembership &updateBoxMembership(DataFrame &frame) {
+	if (!validBoxMembership(frame)) {
+		double t = (double)cv::getTickCount();
+		frame.boxMembership = buildBoxMembership(frame.keypoints, frame.boundingBoxes);
+		t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+		std::cout << "  >>> Box membership of " << frame.keypoints.size() << " keypoints in "
+				  << frame.boundingBoxes.size() << " boxes built in " << 1000 * t / 1.0 << " ms" << std::endl;
+	}
+	return *frame.boxMembership;
+}
+
+void benchmarkBoxMembership(const std::vector<cv::KeyPoint> &keypoints, const cv::Size &imageSize, int numBoxes) {
+	// random boxes of 2 .. 20 % of the image size, like object detections of near and far objects
+	std::mt19937 rng(kBenchmarkSeed);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::vector<BoundingBox> boxes(numBoxes);
+	for (int b = 0; b < numBoxes; ++b) {
+		int width = static_cast<int>(imageSize.width * (0.02f + 0.18f * unit(rng)));
+		int height = static_cast<int>(imageSize.height * (0.02f + 0.18f * unit(rng)));
+		boxes[b].boxID = b;
+		boxes[b].roi = cv::Rect(static_cast<int>((imageSize.width - width) * unit(rng)),
+								static_cast<int>((imageSize.height - height) * unit(rng)), width, height);
+	}
+	int numKeypoints = static_cast<int>(keypoints.size());
+
+	// reference: every keypoint against every box, the same bitsets
+	double tBrute = (double)cv::getTickCount();
+	std::vector<uint64_t> bruteBits;
+	for (int r = 0; r < kBenchmarkRepetitions; ++r) {
+		int words = (numBoxes + 63) / 64;
+		bruteBits.assign(static_cast<size_t>(numKeypoints) * words, 0);
+		for (int k = 0; k < numKeypoints; ++k) {
+			for (int b = 0; b < numBoxes; ++b) {
+				if (boxes[b].roi.contains(keypoints[k].pt)) {
+					bruteBits[static_cast<size_t>(k) * words + (b >> 6)] |= uint64_t(1) << (b & 63);
+				}
+			}
+		}
+	}
+	tBrute = ((double)cv::getTickCount() - tBrute) / cv::getTickFrequency() / kBenchmarkRepetitions;
+
+	double tGrid = (double)cv::getTickCount();
+	std::shared_ptr<BoxMembership> membership;
+	for (int r = 0; r < kBenchmarkRepetitions; ++r) {
+		membership = buildBoxMembership(keypoints, boxes);
+	}
+	tGrid = ((double)cv::getTickCount() - tGrid) / cv::getTickFrequency() / kBenchmarkRepetitions;
+
+	long numMemberships = 0;
+	for (uint64_t word : membership->bits) {
+		numMemberships += __builtin_popcountll(word);
+	}
+	std::cout << "  >>> Box membership benchmark: " << numKeypoints << " keypoints, " << numBoxes << " boxes, "
+			  << numMemberships << " memberships; grid " << 1000 * tGrid / 1.0 << " ms, all pairs "
+			  << 1000 * tBrute / 1.0 << " ms, speedup " << tBrute / tGrid << ", "
+			  << (membership->bits == bruteBits ? "identical" : "MISMATCH") << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef BOX_MEMBERSHIP_H_
+#define BOX_MEMBERSHIP_H_
+
+#include <cstdint>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "dataStructures.h"
+
+/* Boxes enclosing each keypoint of a frame, computed once per frame and queried in O(1) by box matching
+ * (matchBoundingBoxes) and keypoint clustering (clusterKptMatchesWithROI).
+ *
+ * Every keypoint has a bitset of the frame's boxes (by index into boundingBoxes, bit b of word b / 64) that contain it
+ * (cv::Rect::contains, which tests the keypoint position rounded to whole pixels). The candidate boxes of a keypoint
+ * come from a grid of cellSize pixels over the extent of the boxes, each cell listing the boxes overlapping it, so
+ * building costs O(keypoints x boxes per cell) instead of O(keypoints x boxes); the cell of a keypoint is looked up at
+ * the same rounded position. The membership of a frame is built once, when the frame is first matched as the current
+ * frame, and reused when it is the previous frame. It is up to date as long as the no. of keypoints and boxes of the
+ * frame have not changed.
+ */
+struct BoxMembership {
+	int numKeypoints = 0;
+	int numBoxes = 0;
+	int wordsPerKeypoint = 0;	 // 64 bit words of the bitset of a keypoint
+	std::vector<uint64_t> bits;	 // bitset of keypoint k: words [k * wordsPerKeypoint, (k + 1) * wordsPerKeypoint)
+};
+
+std::shared_ptr<BoxMembership> buildBoxMembership(const std::vector<cv::KeyPoint> &keypoints,
+												  const std::vector<BoundingBox> &boxes, int cellSize = 32);
+
+// Membership of the frame, built if the frame has none or it is not up to date
+const BoxMembership &updateBoxMembership(DataFrame &frame);
+
+// Membership of the frame if it is up to date, nullptr otherwise
+const BoxMembership *validBoxMembership(const DataFrame &frame);
+
+inline const uint64_t *enclosingBoxes(const BoxMembership &membership, int keypointIdx) {
+	return membership.bits.data() + static_cast<size_t>(keypointIdx) * membership.wordsPerKeypoint;
+}
+
+inline bool isInBox(const BoxMembership &membership, int keypointIdx, int boxIdx) {
+	return (enclosingBoxes(membership, keypointIdx)[boxIdx >> 6] >> (boxIdx & 63)) & 1;
+}
+
+/* Time the membership of the keypoints for numBoxes random boxes in the image against testing every keypoint against
+ * every box, check both agree and print the timings
+ */
+void benchmarkBoxMembership(const std::vector<cv::KeyPoint> &keypoints, const cv::Size &imageSize, int numBoxes);
+
+#endif /* BOX_MEMBERSHIP_H_ */
@@ -1,16 +1,67 @@
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <numeric>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "boxAssignment.h"
+#include "boxMembership.h"
 #include "cameraFusion.h"
 #include "dataStructures.h"
 #include "utils.h"
 
 using namespace std;
 
+namespace {
+
+// Index of the box in frame.boundingBoxes, -1 if it is not one of them
+int boxIndexInFrame(const DataFrame &frame, const BoundingBox &box) {
+	const BoundingBox *first = frame.boundingBoxes.data();
+	std::less<const BoundingBox *> before;
+	if (before(&box, first) || !before(&box, first + frame.boundingBoxes.size())) {
+		return -1;
+	}
+	return static_cast<int>(&box - first);
+}
+
+/* Enclosure of a keypoint match in a pair of boxes: O(1) lookup in the box memberships of both frames if they are up
+ * to date (see boxMembership.h), cv::Rect::contains otherwise
+ */
+struct EnclosedMatchTest {
+	const DataFrame &prevFrame, &currFrame;
+	const BoundingBox &prevBox, &currBox;
+	const BoxMembership *prevMembership, *currMembership;
+	int prevIdx, currIdx;
+
+	EnclosedMatchTest(const DataFrame &prevFrame, const DataFrame &currFrame, const BoundingBox &prevBox,
+					  const BoundingBox &currBox)
+		: prevFrame(prevFrame),
+		  currFrame(currFrame),
+		  prevBox(prevBox),
+		  currBox(currBox),
+		  prevMembership(validBoxMembership(prevFrame)),
+		  currMembership(validBoxMembership(currFrame)),
+		  prevIdx(boxIndexInFrame(prevFrame, prevBox)),
+		  currIdx(boxIndexInFrame(currFrame, currBox)) {
+		if (!prevMembership || !currMembership || prevIdx < 0 || currIdx < 0) {
+			prevMembership = currMembership = nullptr;
+		}
+	}
+
+	bool operator()(const cv::DMatch &match) const {
+		if (currMembership) {
+			return isInBox(*currMembership, match.trainIdx, currIdx) &&
+				   isInBox(*prevMembership, match.queryIdx, prevIdx);
+		}
+		return currBox.roi.contains(currFrame.keypoints[match.trainIdx].pt) &&
+			   prevBox.roi.contains(prevFrame.keypoints[match.queryIdx].pt);
+	}
+};
+
+}  // namespace
+
 BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, int boxId) {
 	for (auto it = boundingBoxes.begin(); it != boundingBoxes.end(); ++it) {
 		if (boxId == it->boxID)  // check wether current match partner corresponds to this BB
@@ -18,6 +69,29 @@ BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, int bo
 			return &(*it);
 		}
 	}
+	return nullptr;
+}
+
+std::vector<int> indexBoundingBoxesByID(const std::vector<BoundingBox> &boundingBoxes) {
+	int maxID = -1;
+	for (const auto &box : boundingBoxes) {
+		maxID = std::max(maxID, box.boxID);
+	}
+	std::vector<int> indexByID(maxID + 1, -1);
+	for (size_t i = 0; i < boundingBoxes.size(); ++i) {
+		if (boundingBoxes[i].boxID >= 0) {
+			indexByID[boundingBoxes[i].boxID] = static_cast<int>(i);
+		}
+	}
+	return indexByID;
+}
+
+BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, const std::vector<int> &indexByID,
+								 int boxId) {
+	if (boxId < 0 || boxId >= static_cast<int>(indexByID.size()) || indexByID[boxId] < 0) {
+		return nullptr;
+	}
+	return &boundingBoxes[indexByID[boxId]];
 }
 
 // Create groups of Lidar points whose projection into the camera falls into the same bounding box
@@ -145,97 +219,76 @@ void show3DObjects(std::vector<BoundingBox> &boundingBoxes, cv::Size worldSize,
 	}  // wait for keyboard input before continuing
 }
 
-void matchBoundingBoxes(DataFrame &currFrame, DataFrame &prevFrame) {
+void matchBoundingBoxes(DataFrame &currFrame, DataFrame &prevFrame, const BoxMatchingConf &conf) {
 	/* NOTE
 	 * A DMatch contains a query-index element and a train-index element, where
 	 *  - the keypoints in the initial (previous) frame are indexed by queryIdx
 	 *  - the keypoints in the current frame are indexed by trainIdx
 	 */
-	std::map<int, int> bbBestMatches{};
-	// Multimap to store associated bounding boxes between current and previous frame based on keypoint matches
-	std::multimap<int, int> bboxesMatchIds{};
+	/* Dense vote matrix in one pass over the keypoint matches: votes[prev * numCurr + curr] is the no. of matches with
+	 * the previous keypoint in the previous box and the current keypoint in the current box. Boxes are counted by
+	 * index, their IDs need not be dense. The boxes enclosing a keypoint are read from the box membership of its
+	 * frame, built here for the current frame and reused from the last frame pair for the previous frame.
+	 */
+	const BoxMembership &prevMembership = updateBoxMembership(prevFrame);
+	const BoxMembership &currMembership = updateBoxMembership(currFrame);
+	int numPrev = static_cast<int>(prevFrame.boundingBoxes.size());
+	int numCurr = static_cast<int>(currFrame.boundingBoxes.size());
+	std::vector<int> votes(static_cast<size_t>(numPrev) * numCurr, 0);
+	std::vector<int> prevEnclosing, currEnclosing;  // boxes enclosing the keypoints of a match
+	auto enclosingBoxIndices = [](const BoxMembership &membership, int keypointIdx, std::vector<int> &indices) {
+		indices.clear();
+		const uint64_t *bits = enclosingBoxes(membership, keypointIdx);
+		for (int word = 0; word < membership.wordsPerKeypoint; ++word) {
+			for (uint64_t w = bits[word]; w != 0; w &= w - 1) {
+				indices.push_back(word * 64 + __builtin_ctzll(w));
+			}
+		}
+	};
 	for (const auto &match : currFrame.kptMatches) {
-		cv::KeyPoint prevKeypoint = prevFrame.keypoints[match.queryIdx];
-		cv::KeyPoint curKeypoint = currFrame.keypoints[match.trainIdx];
-
-		for (const auto &currBox : currFrame.boundingBoxes) {
-			if (currBox.roi.contains(curKeypoint.pt)) {
-				for (const auto &prevBox : prevFrame.boundingBoxes) {
-					if (prevBox.roi.contains(prevKeypoint.pt)) {
-						bboxesMatchIds.insert({currBox.boxID, prevBox.boxID});
-						// std::cout << "Found association between currFrame box: " << currBox.boxID
-						//           << " and prevFrame box: " << prevBox.boxID << std::endl;
-					}
-				}
+		enclosingBoxIndices(currMembership, match.trainIdx, currEnclosing);
+		if (currEnclosing.empty()) {
+			continue;
+		}
+		enclosingBoxIndices(prevMembership, match.queryIdx, prevEnclosing);
+		for (int prev : prevEnclosing) {
+			for (int curr : currEnclosing) {
+				++votes[prev * numCurr + curr];
 			}
 		}
 	}
 
-	// Print multimap content
-	// showMultimapContent(bboxesMatchIds);
-
-	bool debugPrintBoxAssociations = false;
-	std::vector<std::vector<int>> boxMatchCounts;  // for debugging
-	size_t prevFrameNumBoxes = prevFrame.boundingBoxes.size();
-
-	// Iterate over current frame boxes and count for each box the most associated box from the previous frame
-	for (auto currBox : currFrame.boundingBoxes) {
-		// Get all previous frame boxIDs which are associated to this current frame boxID
-		auto prevFrameMatchedBoxes = bboxesMatchIds.equal_range(currBox.boxID);
-
-		// Count the number of times each box of previous frame is matched against this box of the current frame
-		std::vector<int> prevFrameBoxMatchesIndex(prevFrameNumBoxes, 0);
-		for (std::multimap<int, int>::iterator it = prevFrameMatchedBoxes.first; it != prevFrameMatchedBoxes.second;
-			 ++it) {
-			prevFrameBoxMatchesIndex[it->second] += 1;
+	// one-to-one assignment of previous to current boxes, maximizing the votes (see boxAssignment.h)
+	std::vector<int> currOfPrev = assignBoxes(votes, numPrev, numCurr, conf.assignment, conf.minVotes);
+	std::vector<int> prevOfCurr(numCurr, -1);
+	for (int prev = 0; prev < numPrev; ++prev) {
+		if (currOfPrev[prev] >= 0) {
+			prevOfCurr[currOfPrev[prev]] = prev;
 		}
-		boxMatchCounts.push_back(prevFrameBoxMatchesIndex);
-
-		// Get the index of the box from the previous frame that is associated the most with this current boxID
-		int boxIndex =
-			std::distance(prevFrameBoxMatchesIndex.begin(),
-						  std::max_element(prevFrameBoxMatchesIndex.begin(), prevFrameBoxMatchesIndex.end()));
-		if (prevFrameBoxMatchesIndex[boxIndex] != 0) {
-			// Insert only if element doesn't exist, hence don't overwrite.
-			// If operator[] is used, the element is overwritten!
-			// https://stackoverflow.com/questions/6952486/recommended-way-to-insert-elements-into-map
-
-			// If/else just for debugging
-			if (bbBestMatches.find(prevFrame.boundingBoxes[boxIndex].boxID) != bbBestMatches.end()) {
-				std::cout << " >>> Skipping ... currentBoxID (" << currBox.boxID
-						  << ") already associated with previousBoxID: " << prevFrame.boundingBoxes[boxIndex].boxID
-						  << std::endl;
-			} else {
-				std::cout << " >>> previousBoxID -> currentBoxID: " << prevFrame.boundingBoxes[boxIndex].boxID << " => "
-						  << currBox.boxID << std::endl;
-			}
-
-			bbBestMatches.insert({prevFrame.boundingBoxes[boxIndex].boxID, currBox.boxID});
+	}
 
+	bool debugPrintBoxAssociations = false;
+	std::map<int, int> bbBestMatches{};
+	for (int curr = 0; curr < numCurr; ++curr) {
+		const BoundingBox &currBox = currFrame.boundingBoxes[curr];
+		int prev = prevOfCurr[curr];
+		if (prev >= 0) {
+			const BoundingBox &prevBox = prevFrame.boundingBoxes[prev];
+			std::cout << " >>> previousBoxID -> currentBoxID: " << prevBox.boxID << " => " << currBox.boxID << " ("
+					  << votes[prev * numCurr + curr] << " matches)" << std::endl;
+			bbBestMatches.insert({prevBox.boxID, currBox.boxID});
 		} else {
 			std::cout << " >>> previousBoxID -> currentBoxID: "
 					  << " NONE => " << currBox.boxID << std::endl;
 		}
-
-		if (debugPrintBoxAssociations) {
-			std::cout << currBox.boxID << " =>";
-			for (std::multimap<int, int>::iterator it = prevFrameMatchedBoxes.first; it != prevFrameMatchedBoxes.second;
-				 ++it) {
-				std::cout << ' ' << it->second;
-			}
-			std::cout << '\n';
-			for (size_t i = 0; i < prevFrameBoxMatchesIndex.size(); i++) {
-				std::cout << prevFrameBoxMatchesIndex[i] << ", ";
-			}
-			std::cout << '\n';
-		}
 	}
 
-	// Print overall mapped bounding box counts
+	// Print the vote matrix, a row per current box
 	if (debugPrintBoxAssociations) {
-		for (int i = 0; i < boxMatchCounts.size(); i++) {
-			for (int j = 0; j < prevFrameNumBoxes; j++) {
-				std::cout << boxMatchCounts[i][j] << ", ";
+		for (int curr = 0; curr < numCurr; ++curr) {
+			std::cout << currFrame.boundingBoxes[curr].boxID << " =>";
+			for (int prev = 0; prev < numPrev; ++prev) {
+				std::cout << ' ' << votes[prev * numCurr + curr] << ',';
 			}
 			std::cout << '\n';
 		}
@@ -246,98 +299,74 @@ void matchBoundingBoxes(DataFrame &currFrame, DataFrame &prevFrame) {
 	std::cout << "#8 : TRACK 3D OBJECT BOUNDING BOXES done" << std::endl;
 }
 
-std::vector<cv::DMatch> getValidEnclosedMatches(std::vector<cv::DMatch> &kptMatches,
-												std::vector<cv::KeyPoint> &kptsPrev,
-												std::vector<cv::KeyPoint> &kptsCurr, BoundingBox &prevBox,
-												BoundingBox &currBox) {
-	/* NOTE
-	 * A DMatch contains a query-index element and a train-index element, where
-	 *  - the keypoints in the initial (previous) frame are indexed by queryIdx
-	 *  - the keypoints in the current frame are indexed by trainIdx
-	 *
-	 * A keypoint match is consider valid enclosed if the current keypoint is inside the current
-	 * Bounding Box ROI and it's associated keypoint match is in the previous frame's Bounding Box ROI
+// associate a given bounding box with the keypoints it contains
+void clusterKptMatchesWithROI(KptMatchesClusterConf clusterConf, std::vector<cv::DMatch> &kptMatches,
+							  DataFrame &prevFrame, DataFrame &currFrame, BoundingBox &prevBox, BoundingBox &currBox,
+							  bool visualize, std::ostream &log) {
+	log << "#9 : Cluster keypoint matches with current bounding box" << std::endl;
+	/* Pass 1 over all matches: containment in both boxes, distance between the matched keypoints and their online
+	 * mean / variance (Welford). The enclosed matches and their distances are kept in two compact arrays.
 	 */
 	std::vector<cv::DMatch> enclosedMatches;
+	std::vector<float> distances;
 	enclosedMatches.reserve(kptMatches.size());
-	for (auto &kptMatch : kptMatches) {
-		cv::KeyPoint currKeypoint = kptsCurr[kptMatch.trainIdx];
-		cv::KeyPoint prevKeypoint = kptsPrev[kptMatch.queryIdx];
-		if (currBox.roi.contains(currKeypoint.pt) && prevBox.roi.contains(prevKeypoint.pt)) {
+	distances.reserve(kptMatches.size());
+	RunningStats before;
+	EnclosedMatchTest enclosed(prevFrame, currFrame, prevBox, currBox);
+	for (const auto &kptMatch : kptMatches) {
+		if (enclosed(kptMatch)) {
+			const cv::Point2f &prevPt = prevFrame.keypoints[kptMatch.queryIdx].pt;
+			const cv::Point2f &currPt = currFrame.keypoints[kptMatch.trainIdx].pt;
+			double dist = cv::norm(currPt - prevPt);
 			enclosedMatches.push_back(kptMatch);
+			distances.push_back(static_cast<float>(dist));
+			updateRunningStats(before, dist);
 		}
 	}
-	return enclosedMatches;
-}
-
-std::vector<double> evalDistanceOfKptMatches(std::vector<cv::KeyPoint> &kptsPrev, std::vector<cv::KeyPoint> &kptsCurr,
-											 std::vector<cv::DMatch> &kptMatches) {
-	/* NOTE
-	 * A DMatch contains a query-index element and a train-index element, where
-	 *  - the keypoints in the initial (previous) frame are indexed by queryIdx
-	 *  - the keypoints in the current frame are indexed by trainIdx
-	 */
-	std::vector<double> distances(kptMatches.size(), 0.0);
-	for (auto kptMatch : kptMatches) {
-		cv::KeyPoint prevKeypoint = kptsPrev[kptMatch.queryIdx];
-		cv::KeyPoint curKeypoint = kptsCurr[kptMatch.trainIdx];
-		distances.push_back(cv::norm(curKeypoint.pt - prevKeypoint.pt));
-	}
-	return distances;
-}
-
-// associate a given bounding box with the keypoints it contains
-void clusterKptMatchesWithROI(KptMatchesClusterConf clusterConf, std::vector<cv::DMatch> &kptMatches,
-							  DataFrame &prevFrame, DataFrame &currFrame, BoundingBox &prevBox, BoundingBox &currBox,
-							  bool visualize) {
-	std::cout << "#9 : Cluster keypoint matches with current bounding box" << std::endl;
-	std::vector<cv::DMatch> enclosedMatches =
-		getValidEnclosedMatches(kptMatches, prevFrame.keypoints, currFrame.keypoints, prevBox, currBox);
-
-	std::vector<double> distances = evalDistanceOfKptMatches(prevFrame.keypoints, currFrame.keypoints, enclosedMatches);
-	NormalDistribution normDist = evalNormalDistributionParams(distances);
-	// Select those matches that fall within a desired distance threshold
-	for (auto kptMatch : enclosedMatches) {
-		cv::KeyPoint prevKeypoint = prevFrame.keypoints[kptMatch.queryIdx];
-		cv::KeyPoint curKeypoint = currFrame.keypoints[kptMatch.trainIdx];
-		double dist = cv::norm(curKeypoint.pt - prevKeypoint.pt);
+	NormalDistribution normDist = evalNormalDistributionParams(before);
+
+	// Pass 2 over the enclosed distances: select those matches that fall within a desired distance threshold
+	double maxDist = normDist.mean * clusterConf.threshold;
+	double maxDeviation = clusterConf.numStddev * normDist.stddev;
+	RunningStats after;
+	for (size_t i = 0; i < distances.size(); ++i) {
+		bool selected;
 		switch (clusterConf.method) {
 			case KptMatchesClusterDistanceMethod::THRESHOLD:
-				if (dist < normDist.mean * clusterConf.threshold) {
-					currBox.kptMatches.emplace_back(kptMatch);
-				}
+				selected = distances[i] < maxDist;
 				break;
 			case KptMatchesClusterDistanceMethod::STDEV:
 			default:
 				// In this scenario the data is selected based on the interval of standard-deviations, 1sigma, 2sigma, 3
 				// sigmas a value has to be within in order to be selected;
-				if (std::abs(dist - normDist.mean) < clusterConf.numStddev * normDist.stddev) {
-					currBox.kptMatches.emplace_back(kptMatch);
-				}
+				selected = std::abs(distances[i] - normDist.mean) < maxDeviation;
+		}
+		if (selected) {
+			currBox.kptMatches.push_back(enclosedMatches[i]);
+			if (clusterConf.logStats) {
+				updateRunningStats(after, distances[i]);
+			}
 		}
 	}
 
 	// Debug Messages....
+	if (clusterConf.logStats) {
+		NormalDistribution normDistAfter = evalNormalDistributionParams(after);
+		log << " >>> Before filtering:" << std::endl;
+		log << " >>> Mean distance between kptMatches (in current box): " << normDist.mean << std::endl;
+		log << " >>> Max distance : " << before.max << std::endl;
+		log << " >>> Min distance : " << before.min << std::endl;
+		log << " >>> Stddev between kptMatches (in current box): " << normDist.stddev << std::endl;
+
+		log << " >>> After filtering:" << std::endl;
+		log << " >>> Mean distance between kptMatches (in current box): " << normDistAfter.mean << std::endl;
+		log << " >>> Max distance : " << after.max << std::endl;
+		log << " >>> Min distance : " << after.min << std::endl;
+		log << " >>> Stddev between kptMatches (in current box): " << normDistAfter.stddev << std::endl;
+	}
 
-	std::cout << " >>> Before filtering:" << std::endl;
-	std::cout << " >>> Mean distance between kptMatches (in current box): " << normDist.mean << std::endl;
-	std::cout << " >>> Max distance : " << *(std::max_element(std::begin(distances), std::end(distances))) << std::endl;
-	std::cout << " >>> Min distance : " << *(std::min_element(std::begin(distances), std::end(distances))) << std::endl;
-	std::cout << " >>> Stddev between kptMatches (in current box): " << normDist.stddev << std::endl;
-
-	distances = evalDistanceOfKptMatches(prevFrame.keypoints, currFrame.keypoints, currBox.kptMatches);
-	normDist = evalNormalDistributionParams(distances);
-
-	std::cout << " >>> After filtering:" << std::endl;
-	std::cout << " >>> Mean distance between kptMatches (in current box): " << normDist.mean << std::endl;
-	std::cout << " >>> Max distance : " << *(std::max_element(std::begin(distances), std::end(distances))) << std::endl;
-	std::cout << " >>> Min distance : " << *(std::min_element(std::begin(distances), std::end(distances))) << std::endl;
-	std::cout << " >>> Stddev between kptMatches (in current box): " << normDist.stddev << std::endl;
-
-	std::cout << " >>> "
-			  << " From total number of kpt matches: " << kptMatches.size() << ", #enclosed: " << enclosedMatches.size()
-			  << ", and "
-			  << " #selected: " << currBox.kptMatches.size() << std::endl;
+	log << " >>> " << " From total number of kpt matches: " << kptMatches.size() << ", #enclosed: "
+		<< enclosedMatches.size() << ", and " << " #selected: " << currBox.kptMatches.size() << std::endl;
 
 	if (visualize) {
 		drawMatches(enclosedMatches, currFrame, prevFrame, "matches beforeFiltering");
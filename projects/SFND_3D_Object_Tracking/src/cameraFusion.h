@@ -3,6 +3,7 @@
 #define CAMERA_FUSION_H_
 
 #include <stdio.h>
+#include <iostream>
 #include <opencv2/core.hpp>
 #include <vector>
 
@@ -13,19 +14,22 @@ void clusterLidarWithROI(std::vector<BoundingBox> &boundingBoxes, std::vector<Li
 
 void clusterKptMatchesWithROI(KptMatchesClusterConf clusterConf, std::vector<cv::DMatch> &kptMatches,
 							  DataFrame &prevFrame, DataFrame &currFrame, BoundingBox &prevBox, BoundingBox &currBox,
-							  bool visualize);
+							  bool visualize, std::ostream &log = std::cout);
 
-std::vector<cv::DMatch> getValidEnclosedMatches(std::vector<cv::DMatch> &kptMatches,
-												std::vector<cv::KeyPoint> &kptsPrev,
-												std::vector<cv::KeyPoint> &kptsCurr, BoundingBox &prevBox,
-												BoundingBox &currBox);
+/* Associate the boxes of the previous and the current frame (currFrame.bbMatches, previous => current box ID) by the
+ * keypoint matches they share, one-to-one (see boxAssignment.h)
+ */
+void matchBoundingBoxes(DataFrame &currFrame, DataFrame &prevFrame, const BoxMatchingConf &conf = BoxMatchingConf());
 
-std::vector<double> evalDistanceOfKptMatches(std::vector<cv::KeyPoint> &kptsPrev, std::vector<cv::KeyPoint> &kptsCurr,
-											 std::vector<cv::DMatch> &kptMatches);
+// Box with the given ID by linear search, nullptr if there is none
+BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, int boxId);
 
-void matchBoundingBoxes(DataFrame &currFrame, DataFrame &prevFrame);
+// Dense table of the index into boundingBoxes of each box ID (-1: no box), for O(1) lookup by ID
+std::vector<int> indexBoundingBoxesByID(const std::vector<BoundingBox> &boundingBoxes);
 
-BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, int boxId);
+// Box with the given ID from the table of indexBoundingBoxesByID, nullptr if there is none
+BoundingBox *findBoundingBoxByID(std::vector<BoundingBox> &boundingBoxes, const std::vector<int> &indexByID,
+								 int boxId);
 
 void show3DObjects(std::vector<BoundingBox> &boundingBoxes, cv::Size worldSize, cv::Size imageSize, bool bWait = true);
 
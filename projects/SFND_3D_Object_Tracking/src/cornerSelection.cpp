@@ -0,0 +1,132 @@
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include "cornerSelection.h"
+#include "keypointNms.h"
+
+namespace {
+
+const int kStripeHeight = 64;  // rows per parallel work item of the response computation
+
+bool isStronger(const cv::KeyPoint &kpt1, const cv::KeyPoint &kpt2) { return kpt1.response > kpt2.response; }
+
+}  // namespace
+
+CornerSelectionStats selectCornersBounded(std::vector<cv::KeyPoint> &keypoints, const cv::Mat &img, bool useHarris,
+										  const CornerSelectionConf &conf) {
+	CornerSelectionStats stats;
+	auto tick = cv::getTickCount();
+	cv::Mat response;
+	computeCornerResponse(img, response, useHarris, conf);
+	double maxResponse = 0;
+	cv::minMaxLoc(response, nullptr, &maxResponse);
+	stats.responseTimeSec = static_cast<double>(cv::getTickCount() - tick) / cv::getTickFrequency();
+
+	tick = cv::getTickCount();
+	std::vector<cv::KeyPoint> candidates;
+	selectCornersOnGrid(response, static_cast<float>(conf.qualityLevel * maxResponse), conf, candidates);
+	stats.numCandidates = static_cast<int>(candidates.size());
+	if (conf.maxOverlap < 1.0) {
+		nonMaximumSuppression(candidates, conf.maxOverlap);
+	}
+	retainStrongest(candidates, conf.maxCorners);
+	stats.numSelected = static_cast<int>(candidates.size());
+	keypoints.insert(keypoints.end(), candidates.begin(), candidates.end());
+	stats.selectionTimeSec = static_cast<double>(cv::getTickCount() - tick) / cv::getTickFrequency();
+	return stats;
+}
+
+/* The stripes are processed in parallel. Each stripe is extended by blockSize rows on both sides, so the box filter
+ * over the covariation matrix sees the same neighbourhood as for the full image and the result is identical.
+ */
+void computeCornerResponse(const cv::Mat &img, cv::Mat &response, bool useHarris, const CornerSelectionConf &conf) {
+	response.create(img.size(), CV_32FC1);
+	int numStripes = (img.rows + kStripeHeight - 1) / kStripeHeight;
+	cv::parallel_for_(cv::Range(0, numStripes), [&](const cv::Range &range) {
+		for (int s = range.start; s < range.end; ++s) {
+			int row0 = s * kStripeHeight;
+			int row1 = std::min(row0 + kStripeHeight, img.rows);
+			int padded0 = std::max(row0 - conf.blockSize, 0);
+			int padded1 = std::min(row1 + conf.blockSize, img.rows);
+
+			cv::Mat stripeResponse;
+			if (useHarris) {
+				cv::cornerHarris(img.rowRange(padded0, padded1), stripeResponse, conf.blockSize, conf.apertureSize,
+								 conf.k);
+			} else {
+				cv::cornerMinEigenVal(img.rowRange(padded0, padded1), stripeResponse, conf.blockSize,
+									  conf.apertureSize);
+			}
+			stripeResponse.rowRange(row0 - padded0, row1 - padded0).copyTo(response.rowRange(row0, row1));
+		}
+	});
+}
+
+// Local 3x3 maxima above minResponse, at most maxPerCell (the strongest) per grid cell; grid rows run in parallel
+void selectCornersOnGrid(const cv::Mat &response, float minResponse, const CornerSelectionConf &conf,
+						 std::vector<cv::KeyPoint> &candidates) {
+	int gridRows = (response.rows + conf.cellSize - 1) / conf.cellSize;
+	int gridCols = (response.cols + conf.cellSize - 1) / conf.cellSize;
+	size_t maxPerCell = static_cast<size_t>(std::max(conf.maxPerCell, 1));
+	float keypointSize = static_cast<float>(conf.blockSize);
+
+	std::vector<std::vector<cv::KeyPoint>> rowCandidates(gridRows);
+	cv::parallel_for_(cv::Range(0, gridRows), [&](const cv::Range &range) {
+		std::vector<cv::KeyPoint> cellCandidates;
+		for (int gr = range.start; gr < range.end; ++gr) {
+			// the outermost image rows/columns are skipped as they have an incomplete 3x3 neighbourhood
+			int y0 = std::max(gr * conf.cellSize, 1);
+			int y1 = std::min((gr + 1) * conf.cellSize, response.rows - 1);
+			for (int gc = 0; gc < gridCols; ++gc) {
+				int x0 = std::max(gc * conf.cellSize, 1);
+				int x1 = std::min((gc + 1) * conf.cellSize, response.cols - 1);
+				cellCandidates.clear();
+				for (int y = y0; y < y1; ++y) {
+					const float *prev = response.ptr<float>(y - 1);
+					const float *curr = response.ptr<float>(y);
+					const float *next = response.ptr<float>(y + 1);
+					for (int x = x0; x < x1; ++x) {
+						float v = curr[x];
+						if (v > minResponse && v >= curr[x - 1] && v >= curr[x + 1] && v >= prev[x - 1] &&
+							v >= prev[x] && v >= prev[x + 1] && v >= next[x - 1] && v >= next[x] && v >= next[x + 1]) {
+							cellCandidates.push_back(cv::KeyPoint(static_cast<float>(x), static_cast<float>(y),
+																  keypointSize, -1, v));
+						}
+					}
+				}
+				if (cellCandidates.size() > maxPerCell) {
+					std::partial_sort(cellCandidates.begin(), cellCandidates.begin() + maxPerCell,
+									  cellCandidates.end(), isStronger);
+					cellCandidates.resize(maxPerCell);
+				}
+				rowCandidates[gr].insert(rowCandidates[gr].end(), cellCandidates.begin(), cellCandidates.end());
+			}
+		}
+	});
+
+	// merge in grid order so that the result does not depend on thread scheduling
+	for (const auto &kpts : rowCandidates) {
+		candidates.insert(candidates.end(), kpts.begin(), kpts.end());
+	}
+}
+
+// Keep the maxCorners strongest keypoints using a bounded min-heap (O(n log maxCorners)), sorted by response
+void retainStrongest(std::vector<cv::KeyPoint> &keypoints, int maxCorners) {
+	if (maxCorners <= 0 || keypoints.size() <= static_cast<size_t>(maxCorners)) {
+		std::stable_sort(keypoints.begin(), keypoints.end(), isStronger);
+		return;
+	}
+	// with isStronger as ordering the heap front is the weakest of the retained keypoints
+	std::vector<cv::KeyPoint> heap(keypoints.begin(), keypoints.begin() + maxCorners);
+	std::make_heap(heap.begin(), heap.end(), isStronger);
+	for (auto it = keypoints.begin() + maxCorners; it != keypoints.end(); ++it) {
+		if (it->response > heap.front().response) {
+			std::pop_heap(heap.begin(), heap.end(), isStronger);
+			heap.back() = *it;
+			std::push_heap(heap.begin(), heap.end(), isStronger);
+		}
+	}
+	std::sort_heap(heap.begin(), heap.end(), isStronger);
+	keypoints.swap(heap);
+}
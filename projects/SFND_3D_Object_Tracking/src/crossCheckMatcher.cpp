@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#include "crossCheckMatcher.h"
+
+namespace {
+
+const int kQueryTileSize = 64;  // query rows per distance tile (64 x train rows distances, fits into L2 cache)
+
+}  // namespace
+
+void matchKnnCrossCheck(const cv::Mat &descQuery, const cv::Mat &descTrain, int normType,
+						std::vector<cv::DMatch> &matches, double maxRatio) {
+	CV_Assert(descQuery.type() == descTrain.type() && descQuery.cols == descTrain.cols);
+	if (descQuery.empty() || descTrain.empty()) {
+		return;
+	}
+	const float maxDistance = std::numeric_limits<float>::max();
+	int numTrain = descTrain.rows;
+	std::vector<int> bestIdx(descQuery.rows, -1);
+	std::vector<float> bestDistance(descQuery.rows, maxDistance), secondDistance(descQuery.rows, maxDistance);
+	std::vector<int> reverseIdx(numTrain, -1);
+	std::vector<float> reverseDistance(numTrain, maxDistance);
+	std::mutex reverseMutex;
+	// Hamming distances are counted as integers, all other norms as float
+	bool hamming = normType == cv::NORM_HAMMING || normType == cv::NORM_HAMMING2;
+	int distanceType = hamming ? CV_32S : CV_32F;
+
+	int numTiles = (descQuery.rows + kQueryTileSize - 1) / kQueryTileSize;
+	cv::parallel_for_(cv::Range(0, numTiles), [&](const cv::Range &tiles) {
+		std::vector<int> tileReverseIdx(numTrain, -1);
+		std::vector<float> tileReverseDistance(numTrain, maxDistance);
+		cv::Mat distances, distancesFloat;
+		for (int tile = tiles.start; tile < tiles.end; ++tile) {
+			int first = tile * kQueryTileSize;
+			int last = std::min(first + kQueryTileSize, descQuery.rows);
+			cv::batchDistance(descQuery.rowRange(first, last), descTrain, distances, distanceType, cv::noArray(),
+							  normType);
+			if (hamming) {
+				distances.convertTo(distancesFloat, CV_32F);
+			} else {
+				distancesFloat = distances;
+			}
+			for (int q = first; q < last; ++q) {
+				const float *row = distancesFloat.ptr<float>(q - first);
+				float best = maxDistance, second = maxDistance;
+				int idx = -1;
+				for (int t = 0; t < numTrain; ++t) {
+					float distance = row[t];
+					if (distance < best) {
+						second = best;
+						best = distance;
+						idx = t;
+					} else if (distance < second) {
+						second = distance;
+					}
+					// the query rows are visited in ascending order, ties keep the lower query index
+					if (distance < tileReverseDistance[t]) {
+						tileReverseDistance[t] = distance;
+						tileReverseIdx[t] = q;
+					}
+				}
+				bestIdx[q] = idx;
+				bestDistance[q] = best;
+				secondDistance[q] = second;
+			}
+		}
+		// ties in favour of the lower query index, independent of the order the tiles finish in
+		std::lock_guard<std::mutex> lock(reverseMutex);
+		for (int t = 0; t < numTrain; ++t) {
+			if (tileReverseIdx[t] >= 0 &&
+				(reverseIdx[t] < 0 || tileReverseDistance[t] < reverseDistance[t] ||
+				 (tileReverseDistance[t] == reverseDistance[t] && tileReverseIdx[t] < reverseIdx[t]))) {
+				reverseDistance[t] = tileReverseDistance[t];
+				reverseIdx[t] = tileReverseIdx[t];
+			}
+		}
+	});
+
+	// the ratio test needs a second neighbour, as in runKNN
+	for (int q = 0; q < descQuery.rows; ++q) {
+		if (bestIdx[q] < 0 || reverseIdx[bestIdx[q]] != q) {
+			continue;
+		}
+		if (maxRatio <= 0 || (secondDistance[q] != maxDistance && bestDistance[q] < maxRatio * secondDistance[q])) {
+			matches.push_back(cv::DMatch(q, bestIdx[q], 0, bestDistance[q]));
+		}
+	}
+}
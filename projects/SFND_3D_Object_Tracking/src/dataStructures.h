@@ -2,35 +2,137 @@
 #ifndef DATA_STRUCTURES_H_
 #define DATA_STRUCTURES_H_
 
+#include <limits>
 #include <map>
+#include <memory>
 #include <opencv2/core.hpp>
 #include <vector>
 
-enum class DetectorMethod { SHITOMASI = 0, HARRIS, AKAZE, BRISK, FAST, ORB, SIFT };
+enum class DetectorMethod { SHITOMASI = 0, HARRIS, AKAZE, BRISK, FAST, ORB, SIFT, FAST_SIMD, SHITOMASI_GRID, HARRIS_GRID };
 
 enum class DescriptorMethod { BRISK = 0, AKAZE, BRIEF, FREAK, ORB, SIFT };
 
 enum class DescriptorMetric { BINARY = 0, HOG };
 
-enum class MatcherMethod { BRUTE_FORCE = 0, FLANN };
+enum class MatcherMethod { BRUTE_FORCE = 0, FLANN, FLANN_LSH, BRUTE_FORCE_SIMD, MULTI_INDEX_HASH };
 
 enum class NeighborSelectorMethod { NN = 0, kNN };  // NearestNeighbor, kNearestNeighbor
 
+enum class MotionModel { MEDIAN_FLOW = 0, HOMOGRAPHY };  // keypoint motion between two frames
+
 enum class LidarTtcMethod { MEDIAN = 0, MEAN, CLUSTER_EUCLID };
 
 enum class KptMatchesClusterDistanceMethod {THRESHOLD=0, STDEV};
 
+enum class CameraTtcPairs { ALL = 0, SAMPLED };  // keypoint pairs whose distance ratios give the camera TTC
+enum class CameraTtcMedian { EXACT = 0, HISTOGRAM };  // median of the distance ratios: stored ratios or streamed
+enum class CameraTtcMethod { DISTANCE_RATIOS = 0, RANSAC, LMEDS };  // scale change of the keypoints for the camera TTC
+
+enum class BoxAssignment { GREEDY = 0, HUNGARIAN };  // one-to-one assignment of previous to current frame boxes
+
 struct NormalDistribution {
   float mean;
   float stddev;
 };
 
+struct RunningStats {  // online mean and variance (Welford), see updateRunningStats
+  size_t count = 0;
+  double mean = 0;
+  double m2 = 0;  // sum of the squared deviations from the mean
+  double min = std::numeric_limits<double>::max();
+  double max = std::numeric_limits<double>::lowest();
+};
+
 struct KptMatchesClusterConf {
   KptMatchesClusterDistanceMethod method;
   union {
     double threshold;
     double numStddev;
   };
+  bool logStats = false;  // print the keypoint distance statistics before and after filtering
+};
+
+struct CameraTtcConf {                        // camera TTC from keypoint distance ratios, see distanceRatios.h
+  CameraTtcPairs pairs = CameraTtcPairs::ALL;
+  int pairBudget = 20000;                     // max. no. of pairs evaluated with CameraTtcPairs::SAMPLED
+  float minDist = 100;                        // min. distance of the keypoints of a pair in the current frame [px]
+  CameraTtcMedian median = CameraTtcMedian::EXACT;
+  int histogramBins = 1024;                   // bins per pass of CameraTtcMedian::HISTOGRAM
+  double maxMedianError = 1e-5;               // max. relative error of the median ratio with CameraTtcMedian::HISTOGRAM
+  // similarity transform fit (CameraTtcMethod::RANSAC / LMEDS), see scaleEstimation.h
+  CameraTtcMethod method = CameraTtcMethod::DISTANCE_RATIOS;
+  float inlierThreshold = 2.0;                // max. residual of a RANSAC inlier [px]
+  double confidence = 0.99;                   // probability of an outlier free sample at which the search stops
+  int maxIterations = 1000;
+  bool refineScale = true;                    // least squares refit of the scale on the inliers
+  bool evalAccuracy = false;                  // also estimate from all pairs / exact median and report the deviation
+};
+
+struct BoxMatchingConf {                              // bounding box association, see boxAssignment.h
+  BoxAssignment assignment = BoxAssignment::GREEDY;
+  int minVotes = 1;                                   // min. no. of keypoint matches shared by an associated box pair
+};
+
+struct TiledDetectionConf {
+  int gridRows = 0;             // no. of tile rows the image is split into (0 disables tiled detection)
+  int gridCols = 0;             // no. of tile columns the image is split into
+  int maxKeypointsPerTile = 0;  // keep only the top-K keypoints (by response) of each tile; 0 keeps all
+  int tileBorder = -1;          // padding around each tile [px], -1: the detector's edge margin (detectorTileBorder)
+};
+
+struct LshIndexConf {       // FLANN LSH index over binary descriptors (MatcherMethod::FLANN_LSH)
+  int tableNumber = 12;     // no. of hash tables
+  int keySize = 20;         // no. of descriptor bits hashed per table
+  int multiProbeLevel = 2;  // neighbouring buckets probed per table, 0 = exact bucket only
+};
+
+struct MihIndexConf {      // multi-index hashing over binary descriptors (MatcherMethod::MULTI_INDEX_HASH)
+  int substringBits = 16;  // bits per hashed descriptor substring (8 or 16)
+  int maxRadius = 0;       // max. Hamming distance of a match, 0 = exact nearest neighbours
+};
+
+struct GuidedMatchingConf {                           // motion-guided descriptor matching, see guidedMatching.h
+  bool enabled = false;
+  float searchRadius = 40;                            // half size of the search window around the prediction [px]
+  MotionModel motionModel = MotionModel::HOMOGRAPHY;  // motion model used to predict the keypoint positions
+  double ransacReprojThreshold = 3.0;                 // max. reprojection error of a homography inlier [px]
+  int minMatches = 8;                                 // min. no. of matches to estimate the motion of a frame pair
+};
+
+struct KltTrackingConf {                 // keypoint tracking with pyramidal Lucas-Kanade, see kltTracking.h
+  bool enabled = false;
+  int windowSize = 21;                  // search window on each pyramid level [px]
+  int pyramidLevels = 3;                // max. pyramid level, 0 = full resolution only
+  float maxForwardBackwardError = 1.0;  // max. distance between a keypoint and its forward-backward track [px]
+  int minTracks = 1000;                 // re-detect keypoints if fewer keypoints are tracked into a frame
+  float minKeypointDistance = 10;       // min. distance of a re-detected keypoint from the tracked keypoints [px]
+};
+
+struct TrackStoreConf {    // multi-frame keypoint tracks, see keypointTracks.h
+  bool enabled = false;
+  int historyLength = 8;   // positions kept per track (frames)
+  int maxTracks = 4000;    // max. no. of tracks at the same time
+  int ttcBaseline = 0;     // frames back of the camera TTC from the tracks of a box (0: off), below historyLength
+};
+
+struct TtcFilterConf {              // Kalman filtered TTC per tracked object, see ttcFilter.h
+  bool enabled = false;
+  bool acceleration = false;        // constant acceleration model (state d, v, a) instead of constant velocity
+  double processNoise = 1.0;        // std. of the unmodelled acceleration [m/s^2] (jerk [m/s^3] with acceleration)
+  double lidarDistanceStd = 0.05;   // std. of the median Lidar distance [m]
+  double cameraInvTtcStd = 0.03;    // std. of the camera 1 / TTC [1/s]
+  double maxInvTtcStd = 0.02;       // converged: predicted std. of 1 / TTC below this [1/s]
+  int minTrackAge = 3;              // min. no. of updates before a track counts as converged
+  int maxSkippedFrames = 0;         // skip the estimators for at most this many frames in a row (0: never skip)
+};
+
+struct TtcScheduleConf {          // priority ordered TTC evaluation within a time budget, see ttcScheduler.h
+  bool enabled = false;
+  double timeBudget = 0.03;       // time for the TTC of all objects of a frame [s]
+  double egoLaneHalfWidth = 1.5;  // max. lateral offset of an object in the ego lane [m]
+  double lateralWeight = 5;       // weight of the lateral offset beyond the ego lane against the distance
+  double criticalTtc = 10;        // objects closing in with a lower TTC are ranked by TTC [s]
+  int maxDeferredFrames = 4;      // evaluate every object at least every maxDeferredFrames + 1 frames
 };
 
 struct DataSetConfig {
@@ -68,8 +170,8 @@ struct LidarROI {
 
 struct BoundingBox {  // bounding box around a classified object (contains both 2D and 3D data)
 
-  int boxID;    // unique identifier for this bounding box
-  int trackID;  // unique identifier for the track to which this bounding box belongs
+  int boxID;         // unique identifier for this bounding box
+  int trackID = -1;  // unique identifier for the track to which this bounding box belongs, see objectTracks.h
 
   cv::Rect roi;       // 2D region-of-interest in image coordinates
   int classID;        // ID based on class file provided to YOLO framework
@@ -80,16 +182,29 @@ struct BoundingBox {  // bounding box around a classified object (contains both
   std::vector<cv::DMatch> kptMatches;   // keypoint matches enclosed by 2D roi
 };
 
+struct DescriptorIndex;  // see descriptorIndex.h
+struct DescriptorArena;  // see descriptorArena.h
+struct BoxMembership;    // see boxMembership.h
+
 struct DataFrame {  // represents the available sensor information at the same time instance
 
   cv::Mat cameraImg;  // camera image
 
   std::vector<cv::KeyPoint> keypoints;  // 2D keypoints within camera image
-  cv::Mat descriptors;                  // keypoint descriptors
+  cv::Mat descriptors;                  // keypoint descriptors (rows in descriptorArena)
+  // aligned, padded storage of the descriptors, handed on to the next frame when the frame leaves the ring buffer
+  std::shared_ptr<DescriptorArena> descriptorArena;
+  // matcher trained on the descriptors, built once when the frame is first matched as the previous frame (or as the
+  // current frame by the fallback of guided matching)
+  std::shared_ptr<DescriptorIndex> descriptorIndex;
   std::vector<cv::DMatch> kptMatches;   // keypoint matches between previous and current frame
+  cv::Mat keypointMotion;               // 3x3 homography from previous to current frame keypoints, empty if unknown
+  std::vector<cv::Mat> imagePyramid;    // grayscale pyramid for KLT tracking, built once and reused by the next frame
   std::vector<LidarPoint> lidarPoints;
 
   std::vector<BoundingBox> boundingBoxes;  // ROI around detected objects in 2D image coordinates
+  // boxes enclosing each keypoint, built once when the frame is first matched as the current frame
+  std::shared_ptr<BoxMembership> boxMembership;
   std::map<int, int> bbMatches;            // bounding box matches between previous and current frame
 };
 
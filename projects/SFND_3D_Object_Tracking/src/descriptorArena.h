@@ -0,0 +1,54 @@
+#ifndef DESCRIPTOR_ARENA_H_
+#define DESCRIPTOR_ARENA_H_
+
+#include <memory>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+
+/* Aligned storage of the descriptors of a frame.
+ *
+ * The extractors return matrices with whatever row stride and alignment OpenCV chose, and the binary descriptor widths
+ * differ (ORB 32 bytes, BRISK / BRIEF / FREAK 64 bytes, AKAZE 61 bytes). The descriptors of a frame are therefore
+ * copied into an arena whose memory is aligned to kDescriptorAlignment (64 bytes, a cache line) and whose rows are
+ * zero padded to a multiple of kDescriptorRowPadding (32 bytes, an AVX2 register; DescriptorTraits::paddedRowBytes).
+ * Every row therefore starts at least 32 byte aligned. DataFrame::descriptors is a header on the arena, so matching
+ * kernels may read full padded rows: the zero padding does not change Hamming or L2 distances, hence no kernel needs a
+ * tail loop (AKAZE is matched with the 64 byte kernel).
+ * The arena of the frame dropped from the ring buffer is handed to the next frame (pushToBuffer), memory is only
+ * allocated while the arena grows to the largest descriptor set of the sequence.
+ */
+const int kDescriptorAlignment = 64;   // alignment of the arena memory
+const int kDescriptorRowPadding = 32;  // rows are padded to a multiple of the SIMD width
+
+struct DescriptorTraits {
+	int type = CV_8U;		  // element type of the descriptor rows
+	int cols = 0;			  // elements per descriptor
+	int rowBytes = 0;		  // bytes per descriptor
+	int paddedRowBytes = 0;	  // row stride in the arena, rowBytes rounded up to kDescriptorRowPadding
+};
+
+struct DescriptorArena {
+	std::unique_ptr<uchar[]> memory;  // capacity + kDescriptorAlignment bytes
+	uchar *data = nullptr;			  // first aligned byte of memory
+	size_t capacity = 0;
+	int numAllocations = 0;			  // no. of times the arena had to grow
+	DescriptorTraits traits;		  // layout of the stored descriptors
+	int numRows = 0;
+};
+
+// Expected descriptor layout of an extractor, as configured in descKeypoints
+DescriptorTraits getDescriptorTraits(DescriptorMethod descriptorMethod);
+
+/* Copy the descriptors into the arena of the frame (created on first use, grown if too small) and point
+ * frame.descriptors to the aligned, zero padded rows. If the descriptors do not have the layout of the traits (e.g. an
+ * extractor configured differently), the layout is derived from the descriptors. Returns the copy time in seconds.
+ */
+double storeDescriptors(DataFrame &frame, const cv::Mat &descriptors, const DescriptorTraits &traits);
+
+/* Bytes per row the matching kernels may compare if both frames keep their descriptors in an arena with the same
+ * layout (the rows are zero padded to this width), 0 otherwise.
+ */
+int paddedRowBytes(const DataFrame &previousFrame, const DataFrame &currentFrame);
+
+#endif /* DESCRIPTOR_ARENA_H_ */
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "distanceRatios.h"
+
+namespace {
+
+const unsigned kSamplingSeed = 42;
+
+struct Anchor {
+	float xPrev, yPrev, xCurr, yCurr;
+};
+
+Anchor anchorOf(const MatchedKeypoints &points, int idx) {
+	return Anchor{points.xPrev[idx], points.yPrev[idx], points.xCurr[idx], points.yCurr[idx]};
+}
+
+inline float pairRatio(const Anchor &a, float xPrev, float yPrev, float xCurr, float yCurr, float minDistSq) {
+	float dxPrev = xPrev - a.xPrev, dyPrev = yPrev - a.yPrev;
+	float dxCurr = xCurr - a.xCurr, dyCurr = yCurr - a.yCurr;
+	float prevSq = dxPrev * dxPrev + dyPrev * dyPrev;
+	float currSq = dxCurr * dxCurr + dyCurr * dyCurr;
+	return currSq >= minDistSq && prevSq > 0 ? std::sqrt(currSq / prevSq) : 0.f;
+}
+
+#if defined(__AVX2__)
+// ratios[k] = distance ratio of the anchor and partner k, 0 for a rejected pair; 8 pairs per iteration
+void partnerRatios(const Anchor &a, const float *xPrev, const float *yPrev, const float *xCurr, const float *yCurr,
+				   int n, float minDistSq, float *ratios) {
+	__m256 axPrev = _mm256_set1_ps(a.xPrev), ayPrev = _mm256_set1_ps(a.yPrev);
+	__m256 axCurr = _mm256_set1_ps(a.xCurr), ayCurr = _mm256_set1_ps(a.yCurr);
+	__m256 minSq = _mm256_set1_ps(minDistSq), zero = _mm256_setzero_ps();
+	int k = 0;
+	for (; k + 8 <= n; k += 8) {
+		__m256 dxPrev = _mm256_sub_ps(_mm256_loadu_ps(xPrev + k), axPrev);
+		__m256 dyPrev = _mm256_sub_ps(_mm256_loadu_ps(yPrev + k), ayPrev);
+		__m256 dxCurr = _mm256_sub_ps(_mm256_loadu_ps(xCurr + k), axCurr);
+		__m256 dyCurr = _mm256_sub_ps(_mm256_loadu_ps(yCurr + k), ayCurr);
+		__m256 prevSq = _mm256_add_ps(_mm256_mul_ps(dxPrev, dxPrev), _mm256_mul_ps(dyPrev, dyPrev));
+		__m256 currSq = _mm256_add_ps(_mm256_mul_ps(dxCurr, dxCurr), _mm256_mul_ps(dyCurr, dyCurr));
+		__m256 valid =
+			_mm256_and_ps(_mm256_cmp_ps(currSq, minSq, _CMP_GE_OQ), _mm256_cmp_ps(prevSq, zero, _CMP_GT_OQ));
+		// rejected lanes may divide by zero, the mask clears them
+		__m256 ratio = _mm256_sqrt_ps(_mm256_div_ps(currSq, prevSq));
+		_mm256_storeu_ps(ratios + k, _mm256_and_ps(ratio, valid));
+	}
+	for (; k < n; ++k) {
+		ratios[k] = pairRatio(a, xPrev[k], yPrev[k], xCurr[k], yCurr[k], minDistSq);
+	}
+}
+#else
+// ratios[k] = distance ratio of the anchor and partner k, 0 for a rejected pair; vectorized by the compiler
+void partnerRatios(const Anchor &a, const float *xPrev, const float *yPrev, const float *xCurr, const float *yCurr,
+				   int n, float minDistSq, float *ratios) {
+	for (int k = 0; k < n; ++k) {
+		ratios[k] = pairRatio(a, xPrev[k], yPrev[k], xCurr[k], yCurr[k], minDistSq);
+	}
+}
+#endif
+
+// Uniform sample from stratum s of numStrata equally sized strata of [0, n), numStrata <= n
+int sampleStratum(std::mt19937 &rng, int s, int numStrata, int n) {
+	int first = static_cast<int>(static_cast<int64_t>(s) * n / numStrata);
+	int last = static_cast<int>(static_cast<int64_t>(s + 1) * n / numStrata);
+	return std::uniform_int_distribution<int>(first, last - 1)(rng);
+}
+
+size_t numUniquePairs(int n) {
+	return n < 2 ? 0 : static_cast<size_t>(n) * (n - 1) / 2;
+}
+
+/* The pair enumerations pass the ratios of one anchor and its partners to consume(ratios, n) in blocks, rejected pairs
+ * as 0. Both return the no. of evaluated pairs.
+ */
+template <typename Consume>
+size_t forAllPairs(const MatchedKeypoints &points, float minDist, Consume consume) {
+	int n = static_cast<int>(points.xPrev.size());
+	std::vector<float> buffer(std::max(n, 1));
+	// the partners of anchor a are the matches a + 1 .. n - 1, contiguous in the arrays
+	for (int a = 0; a + 1 < n; ++a) {
+		int first = a + 1;
+		partnerRatios(anchorOf(points, a), &points.xPrev[first], &points.yPrev[first], &points.xCurr[first],
+					  &points.yCurr[first], n - first, minDist * minDist, buffer.data());
+		consume(buffer.data(), n - first);
+	}
+	return numUniquePairs(n);
+}
+
+template <typename Consume>
+size_t forSampledPairs(const MatchedKeypoints &points, float minDist, int pairBudget, Consume consume) {
+	int n = static_cast<int>(points.xPrev.size());
+	if (pairBudget <= 0 || numUniquePairs(n) <= static_cast<size_t>(pairBudget)) {
+		return forAllPairs(points, minDist, consume);
+	}
+	int numAnchors = std::min(n, pairBudget);
+	int numPartners = std::min(n - 1, std::max(1, pairBudget / numAnchors));
+
+	std::mt19937 rng(kSamplingSeed);
+	// the sampled partners are gathered into contiguous arrays for the vectorized distances
+	std::vector<float> xPrev(numPartners), yPrev(numPartners), xCurr(numPartners), yCurr(numPartners);
+	std::vector<float> buffer(numPartners);
+	for (int s = 0; s < numAnchors; ++s) {
+		int a = sampleStratum(rng, s, numAnchors, n);
+		for (int p = 0; p < numPartners; ++p) {
+			int b = sampleStratum(rng, p, numPartners, n - 1);
+			b += b >= a ? 1 : 0;  // strata over the matches other than the anchor
+			xPrev[p] = points.xPrev[b];
+			yPrev[p] = points.yPrev[b];
+			xCurr[p] = points.xCurr[b];
+			yCurr[p] = points.yCurr[b];
+		}
+		partnerRatios(anchorOf(points, a), xPrev.data(), yPrev.data(), xCurr.data(), yCurr.data(), numPartners,
+					  minDist * minDist, buffer.data());
+		consume(buffer.data(), numPartners);
+	}
+	return static_cast<size_t>(numAnchors) * numPartners;
+}
+
+// Appends the accepted ratios of a block to a vector
+struct AppendAccepted {
+	std::vector<float> &ratios;
+
+	void operator()(const float *block, int n) const {
+		for (int k = 0; k < n; ++k) {
+			if (block[k] > 0) {
+				ratios.push_back(block[k]);
+			}
+		}
+	}
+};
+
+uint32_t bitsOf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+float floatOf(uint32_t bits) {
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/* Histogram of the accepted ratios over a window of bit patterns [first, first + numBins << shift). The bit pattern of
+ * a positive float increases with its value and is a piecewise linear approximation of its base 2 logarithm, hence
+ * the bins have a width of 2^shift units in the last place, i.e. a relative width of at most 2^(shift - 23).
+ */
+struct BitHistogram {
+	uint32_t first;
+	int shift;
+	std::vector<uint32_t> counts;
+	size_t below = 0, above = 0;  // accepted ratios outside the window
+
+	BitHistogram(uint32_t first, int shift, int numBins) : first(first), shift(shift), counts(numBins, 0) {}
+
+	void operator()(const float *block, int n) {
+		uint32_t span = static_cast<uint32_t>(counts.size()) << shift;
+		for (int k = 0; k < n; ++k) {
+			if (block[k] > 0) {
+				uint32_t bits = bitsOf(block[k]);
+				if (bits < first) {
+					++below;
+				} else if (bits - first >= span) {
+					++above;
+				} else {
+					++counts[(bits - first) >> shift];
+				}
+			}
+		}
+	}
+
+	// Bin of the ratio of the given rank, -1 if it is below the window, counts.size() if above
+	int binOfRank(size_t rank) const {
+		if (rank < below) {
+			return -1;
+		}
+		size_t cumulative = below;
+		for (size_t bin = 0; bin < counts.size(); ++bin) {
+			cumulative += counts[bin];
+			if (rank < cumulative) {
+				return static_cast<int>(bin);
+			}
+		}
+		return static_cast<int>(counts.size());
+	}
+};
+
+// Largest accepted ratio below and smallest accepted ratio from a bit pattern on
+struct MiddleRatios {
+	uint32_t boundary;
+	float lower = 0;
+	float upper = std::numeric_limits<float>::infinity();
+
+	explicit MiddleRatios(uint32_t boundary) : boundary(boundary) {}
+
+	void operator()(const float *block, int n) {
+		for (int k = 0; k < n; ++k) {
+			if (block[k] > 0) {
+				if (bitsOf(block[k]) < boundary) {
+					lower = std::max(lower, block[k]);
+				} else {
+					upper = std::min(upper, block[k]);
+				}
+			}
+		}
+	}
+};
+
+}  // namespace
+
+void gatherMatchedKeypoints(const std::vector<cv::KeyPoint> &kptsPrev, const std::vector<cv::KeyPoint> &kptsCurr,
+							const std::vector<cv::DMatch> &kptMatches, MatchedKeypoints &points) {
+	size_t n = kptMatches.size();
+	points.xPrev.resize(n);
+	points.yPrev.resize(n);
+	points.xCurr.resize(n);
+	points.yCurr.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		const cv::Point2f &prev = kptsPrev[kptMatches[i].queryIdx].pt;
+		const cv::Point2f &curr = kptsCurr[kptMatches[i].trainIdx].pt;
+		points.xPrev[i] = prev.x;
+		points.yPrev[i] = prev.y;
+		points.xCurr[i] = curr.x;
+		points.yCurr[i] = curr.y;
+	}
+}
+
+size_t allPairRatios(const MatchedKeypoints &points, float minDist, std::vector<float> &ratios) {
+	ratios.reserve(ratios.size() + numUniquePairs(static_cast<int>(points.xPrev.size())));
+	return forAllPairs(points, minDist, AppendAccepted{ratios});
+}
+
+size_t sampledPairRatios(const MatchedKeypoints &points, float minDist, int pairBudget, std::vector<float> &ratios) {
+	size_t numUnique = numUniquePairs(static_cast<int>(points.xPrev.size()));
+	size_t numPairs = pairBudget > 0 ? std::min(numUnique, static_cast<size_t>(pairBudget)) : numUnique;
+	ratios.reserve(ratios.size() + numPairs);
+	return forSampledPairs(points, minDist, pairBudget, AppendAccepted{ratios});
+}
+
+double histogramMedianRatio(const MatchedKeypoints &points, float minDist, int pairBudget, int numBins,
+							double maxRelError, HistogramMedianStats *stats) {
+	numBins = std::max(numBins, 2);
+	int binBits = 0;  // the bins per pass are rounded down to a power of two: each pass splits one bin of the last
+	while ((2 << binBits) <= numBins) {
+		++binBits;
+	}
+	// the first pass covers the ratios 1/256 .. 256, ratios outside count as below / above
+	uint32_t first = bitsOf(1.f / 256), last = bitsOf(256.f);
+	int shift = 0;
+	while ((static_cast<uint64_t>(1) << (shift + binBits)) < static_cast<uint64_t>(last - first)) {
+		++shift;
+	}
+
+	size_t numPairs = 0, numRatios = 0, rank = 0;
+	int numPasses = 0;
+	double median = NAN;
+	while (true) {
+		BitHistogram histogram(first, shift, 1 << binBits);
+		numPairs = forSampledPairs(points, minDist, pairBudget, std::ref(histogram));
+		++numPasses;
+		if (numPasses == 1) {
+			numRatios = histogram.below + histogram.above;
+			for (uint32_t count : histogram.counts) {
+				numRatios += count;
+			}
+			if (numRatios == 0) {
+				break;
+			}
+			rank = (numRatios - 1) / 2;  // lower middle, the upper middle is rank + 1 for an even no. of ratios
+		}
+		// bins holding the middle ratios, -1: below the window, counts.size(): above
+		int bin = histogram.binOfRank(rank);
+		int upperBin = numRatios % 2 == 0 ? histogram.binOfRank(rank + 1) : bin;
+		if (upperBin != bin) {
+			/* the middle ratios are the largest ratio below the bin of the upper middle and the smallest ratio from
+			 * there on, one more pass finds them exactly
+			 */
+			MiddleRatios middle(first + (static_cast<uint32_t>(upperBin) << shift));
+			forSampledPairs(points, minDist, pairBudget, std::ref(middle));
+			++numPasses;
+			median = (static_cast<double>(middle.lower) + middle.upper) / 2;
+			break;
+		}
+		if (bin < 0 || bin == static_cast<int>(histogram.counts.size())) {
+			// the median is outside the ratios 1/256 .. 256, no meaningful TTC
+			median = bin < 0 ? 1.0 / 256 : 256.0;
+			break;
+		}
+		first += static_cast<uint32_t>(bin) << shift;
+		// half a bin is at most 2^(shift - 24) relative to the ratio
+		if (shift == 0 || std::ldexp(1.0, shift - 24) <= maxRelError) {
+			median = (static_cast<double>(floatOf(first)) + floatOf(first + ((1u << shift) - 1))) / 2;
+			break;
+		}
+		// refine: the next pass splits the median bin
+		shift = std::max(shift - binBits, 0);
+	}
+
+	if (stats) {
+		stats->numPairs = numPairs;
+		stats->numRatios = numRatios;
+		stats->numPasses = numPasses;
+		stats->numBins = 1 << binBits;
+	}
+	return median;
+}
+
+double medianRatio(std::vector<float> &ratios) {
+	if (ratios.empty()) {
+		return NAN;
+	}
+	size_t mid = ratios.size() / 2;
+	std::nth_element(ratios.begin(), ratios.begin() + mid, ratios.end());
+	double median = ratios[mid];
+	if (ratios.size() % 2 == 0) {
+		// the lower middle element is the largest of the lower half
+		median = (median + *std::max_element(ratios.begin(), ratios.begin() + mid)) / 2;
+	}
+	return median;
+}
+
+const char *distanceRatiosInstructionSet() {
+#if defined(__AVX2__)
+	return "AVX2";
+#else
+	return "compiler vectorized";
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef DISTANCE_RATIOS_H_
+#define DISTANCE_RATIOS_H_
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* Distance ratios of keypoint pairs for the camera TTC (computeTTCCamera).
+ *
+ * For a pair of matched keypoints a, b the ratio d_curr / d_prev of their distance in the current and in the previous
+ * frame measures the scale change of the object. The coordinates of the matched keypoints are gathered once into a
+ * structure of arrays (MatchedKeypoints), so the distances of one keypoint to a run of partners are computed with
+ * contiguous vector loads (AVX2 when enabled at build time, plain loops vectorized by the compiler otherwise).
+ * Pairs whose distance in the current frame is below minDist, or whose keypoints coincide in the previous frame, are
+ * rejected.
+ * allPairRatios evaluates every unique pair (a < b) once, N * (N - 1) / 2 pairs for N matches. sampledPairRatios
+ * bounds the cost by a pair budget: the anchors are spread evenly over the matches (one per stratum if there are more
+ * matches than budget) and every anchor draws its partners from equally sized strata of the other matches, so each
+ * match contributes about the same no. of pairs. The sampling uses a fixed seed, results are reproducible.
+ * histogramMedianRatio streams the ratios into a histogram instead of storing them (O(N^2) floats): the bins are
+ * logarithmic (float bit patterns, see distanceRatios.cpp), each pass recomputes the ratios of the same pairs and
+ * splits the bin holding the median of the last pass, until half a bin is below the requested relative error. Memory
+ * is O(bins), the cost one pass over the pairs per refinement (two with the defaults).
+ */
+struct MatchedKeypoints {
+	std::vector<float> xPrev, yPrev;  // previous frame keypoint of each match
+	std::vector<float> xCurr, yCurr;  // current frame keypoint of each match
+};
+
+void gatherMatchedKeypoints(const std::vector<cv::KeyPoint> &kptsPrev, const std::vector<cv::KeyPoint> &kptsCurr,
+							const std::vector<cv::DMatch> &kptMatches, MatchedKeypoints &points);
+
+// Ratios of all unique pairs appended to ratios, returns the no. of evaluated pairs
+size_t allPairRatios(const MatchedKeypoints &points, float minDist, std::vector<float> &ratios);
+
+// Ratios of at most pairBudget sampled pairs (all pairs if there are not more), returns the no. of evaluated pairs
+size_t sampledPairRatios(const MatchedKeypoints &points, float minDist, int pairBudget, std::vector<float> &ratios);
+
+struct HistogramMedianStats {
+	size_t numPairs = 0;   // evaluated pairs per pass
+	size_t numRatios = 0;  // accepted pairs
+	int numPasses = 0;
+	int numBins = 0;  // bins per pass
+};
+
+/* Median of the ratios of all pairs (pairBudget <= 0) or of the pairs sampledPairRatios would evaluate, within a
+ * relative error of maxRelError, without storing the ratios. numBins is rounded down to a power of two. NaN if no pair
+ * is accepted; a median outside 1/256 .. 256 is clamped.
+ */
+double histogramMedianRatio(const MatchedKeypoints &points, float minDist, int pairBudget, int numBins,
+							double maxRelError, HistogramMedianStats *stats = nullptr);
+
+// Median of the ratios (partially reorders them), NaN if there are none
+double medianRatio(std::vector<float> &ratios);
+
+// Name of the instruction set used for the distances (AVX2 or compiler vectorized)
+const char *distanceRatiosInstructionSet();
+
+#endif /* DISTANCE_RATIOS_H_ */
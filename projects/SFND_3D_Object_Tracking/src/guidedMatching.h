@@ -0,0 +1,46 @@
+#ifndef GUIDED_MATCHING_H_
+#define GUIDED_MATCHING_H_
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "dataStructures.h"
+
+/* Motion-guided descriptor matching between the previous and the current frame.
+ *
+ * The keypoint motion of the last frame pair (DataFrame::keypointMotion, a median flow translation or a homography)
+ * predicts where a previous frame keypoint appears in the current frame (constant velocity). The current frame
+ * keypoints are bucketed in a grid with cells of the search radius, hence each previous keypoint is only compared with
+ * the current keypoints of the (at most 3x3) cells overlapping its search window: O(N*k) descriptor distances instead
+ * of O(N*M) for N previous, M current keypoints and k keypoints per window.
+ * Previous keypoints whose window holds fewer candidates than the neighbour selection needs (1 for NN, 2 for the kNN
+ * ratio test) or whose predicted position is undefined are matched against all current frame descriptors with the
+ * selected matcher, its index over the current frame is kept in DataFrame::descriptorIndex.
+ * With crossCheck (brute force matchers only, as for global matching) a match is kept if its previous keypoint is also
+ * the nearest to the current keypoint among the previous keypoints competing for it: those whose window holds the
+ * current keypoint for a window match, all previous keypoints for a fallback match (ties to the lower index).
+ */
+struct GuidedMatchingStats {
+	int numQueries = 0;			// no. of previous frame keypoints
+	int numFallback = 0;		// no. of previous frame keypoints matched globally
+	long numComparisons = 0;	// no. of descriptor distances computed (windows, fallback and cross-check)
+	int numCrossCheckRejected = 0;
+	double timeSec = 0;
+};
+
+// Matches with queryIdx = previous, trainIdx = current frame keypoint; returns the matching time in seconds
+double matchDescriptorsGuided(const DataFrame &previousFrame, DataFrame &currentFrame, const cv::Mat &motion,
+							  std::vector<cv::DMatch> &matches, int normType, MatcherMethod matcherMethod,
+							  NeighborSelectorMethod nnSelector, bool crossCheck, const GuidedMatchingConf &conf,
+							  GuidedMatchingStats *stats = nullptr, const LshIndexConf &lshConf = LshIndexConf(),
+							  const MihIndexConf &mihConf = MihIndexConf());
+
+/* Keypoint motion (3x3 CV_64F homography mapping previous onto current frame positions) of a frame pair, estimated
+ * from its matches; the median flow is stored as a pure translation. The motion is left empty if there are fewer
+ * than conf.minMatches matches. Returns the estimation time in seconds.
+ */
+double estimateKeypointMotion(const std::vector<cv::KeyPoint> &kptsPrevious,
+							  const std::vector<cv::KeyPoint> &kptsCurrent, const std::vector<cv::DMatch> &matches,
+							  const GuidedMatchingConf &conf, cv::Mat &motion);
+
+#endif /* GUIDED_MATCHING_H_ */
@@ -0,0 +1,30 @@
+#ifndef HAMMING_MATCHER_H_
+#define HAMMING_MATCHER_H_
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* In-tree brute force Hamming matcher for binary descriptors (CV_8U, one descriptor per row).
+ *
+ * For each query descriptor the smallest and second smallest distance over all train descriptors are tracked while
+ * scanning, and the distance ratio test is applied right away. Matches are emitted directly, without the k-nearest
+ * neighbour lists of cv::DescriptorMatcher::knnMatch. The query rows are split in blocks processed in parallel, the
+ * matches are returned in query order.
+ * 32 and 64 byte descriptors (ORB, BRISK, BRIEF, FREAK) use AVX-512 VPOPCNTDQ or AVX2 (vpshufb nibble lookup) when
+ * enabled at build time, the popcnt instruction or SSE2 otherwise; other sizes (AKAZE: 61 bytes) use the popcount of
+ * 64 bit words and a byte tail.
+ * With maxRatio > 0 a match is kept if best < maxRatio * secondBest (as runKNN with k=2), with maxRatio <= 0 the
+ * nearest neighbour is returned for every query descriptor. Ties are resolved in favour of the lower train index.
+ * With crossCheck a match is only kept if the query descriptor is also the nearest neighbour of its train descriptor
+ * among all query descriptors (ties in favour of the lower query index). The reverse nearest neighbours are taken from
+ * the distances computed for the forward search, there is no second pass over the descriptors.
+ * With rowBytes > 0 the first rowBytes bytes of every row are compared: rows zero padded to a SIMD width (descriptor
+ * arena, descriptorArena.h) are matched with the kernel of the padded size, e.g. AKAZE (61 bytes) as 64 byte rows.
+ */
+void matchHamming(const cv::Mat &descQuery, const cv::Mat &descTrain, std::vector<cv::DMatch> &matches,
+				  double maxRatio = 0.8, bool crossCheck = false, int rowBytes = 0);
+
+// Name of the instruction set used by matchHamming for 32/64 byte descriptors (AVX-512, AVX2, POPCNT, SSE2 or scalar)
+const char *hammingMatcherInstructionSet();
+
+#endif /* HAMMING_MATCHER_H_ */
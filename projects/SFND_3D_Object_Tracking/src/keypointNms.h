@@ -0,0 +1,26 @@
+#ifndef KEYPOINT_NMS_H_
+#define KEYPOINT_NMS_H_
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* Non-maximum suppression (NMS) of keypoints using a spatial hash.
+ *
+ * Keypoints are visited in descending response order and kept if they do not overlap (cv::KeyPoint::overlap larger
+ * than maxOverlap) with an already kept keypoint. The kept keypoints are bucketed in a grid whose cells have the size
+ * of the largest keypoint diameter, hence only the 3x3 neighbouring cells have to be checked instead of every kept
+ * keypoint.
+ */
+struct NmsParams {
+	double maxOverlap = 0.0;  // max. permissible overlap between two keypoints (0..1)
+	float minResponse = 100;  // min. response for a pixel of a response map to become a candidate
+	float keypointSize = 6;	  // diameter of the keypoints created from a response map
+};
+
+// Keypoints from a raw response map (CV_32FC1) after NMS, appended in descending response order
+void nonMaximumSuppression(const cv::Mat &response, std::vector<cv::KeyPoint> &keypoints, const NmsParams &params);
+
+// NMS on existing keypoints, the remaining keypoints are sorted in descending response order
+void nonMaximumSuppression(std::vector<cv::KeyPoint> &keypoints, double maxOverlap);
+
+#endif /* KEYPOINT_NMS_H_ */
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "distanceRatios.h"
+#include "keypointTracks.h"
+
+namespace {
+
+void setPosition(KeypointTrackStore &store, int slot, int frame, const cv::Point2f &pt) {
+	size_t entry = static_cast<size_t>(slot) * store.historyLength + frame % store.historyLength;
+	store.x[entry] = pt.x;
+	store.y[entry] = pt.y;
+}
+
+void releaseSlot(KeypointTrackStore &store, int slot) {
+	store.trackId[slot] = -1;
+	store.freeSlots.push_back(slot);
+	--store.numTracks;
+}
+
+}  // namespace
+
+void initKeypointTracks(KeypointTrackStore &store, const TrackStoreConf &conf) {
+	store = KeypointTrackStore();
+	store.historyLength = std::max(conf.historyLength, 2);
+	store.maxTracks = std::max(conf.maxTracks, 1);
+	store.trackId.assign(store.maxTracks, -1);
+	store.lastFrame.assign(store.maxTracks, -1);
+	store.length.assign(store.maxTracks, 0);
+	store.keypointIdx.assign(store.maxTracks, -1);
+	store.x.assign(static_cast<size_t>(store.maxTracks) * store.historyLength, 0.f);
+	store.y.assign(static_cast<size_t>(store.maxTracks) * store.historyLength, 0.f);
+	// lowest slots first
+	for (int slot = store.maxTracks - 1; slot >= 0; --slot) {
+		store.freeSlots.push_back(slot);
+	}
+}
+
+void updateKeypointTracks(KeypointTrackStore &store, const DataFrame &previousFrame, const DataFrame &currentFrame) {
+	if (store.maxTracks == 0) {
+		return;
+	}
+	if (store.numFrames == 0) {
+		// the previous frame is the first frame, none of its keypoints is on a track
+		store.slotOfKeypoint.assign(previousFrame.keypoints.size(), -1);
+		store.numFrames = 1;
+	}
+	int frame = store.numFrames;
+	std::vector<int> slotOfKeypoint(currentFrame.keypoints.size(), -1);
+	int numExtended = 0, numStarted = 0;
+	for (const auto &match : currentFrame.kptMatches) {
+		int slot = match.queryIdx < static_cast<int>(store.slotOfKeypoint.size()) ? store.slotOfKeypoint[match.queryIdx]
+																				   : -1;
+		// a previous frame keypoint matched by several current frame keypoints extends its track only once
+		if (slot >= 0 && store.lastFrame[slot] < frame) {
+			++store.length[slot];
+			++numExtended;
+		} else {
+			if (store.freeSlots.empty()) {
+				++store.numDropped;
+				continue;
+			}
+			slot = store.freeSlots.back();
+			store.freeSlots.pop_back();
+			store.trackId[slot] = store.nextTrackId++;
+			store.length[slot] = 2;
+			setPosition(store, slot, frame - 1, previousFrame.keypoints[match.queryIdx].pt);
+			++store.numTracks;
+			++numStarted;
+		}
+		store.lastFrame[slot] = frame;
+		store.keypointIdx[slot] = match.trainIdx;
+		setPosition(store, slot, frame, currentFrame.keypoints[match.trainIdx].pt);
+		slotOfKeypoint[match.trainIdx] = slot;
+	}
+
+	// tracks not matched into the current frame have ended
+	int numEnded = 0;
+	long totalLength = 0;
+	for (int slot = 0; slot < store.maxTracks; ++slot) {
+		if (store.trackId[slot] < 0) {
+			continue;
+		}
+		if (store.lastFrame[slot] < frame) {
+			releaseSlot(store, slot);
+			++numEnded;
+		} else {
+			totalLength += store.length[slot];
+		}
+	}
+	store.slotOfKeypoint.swap(slotOfKeypoint);
+	store.numFrames = frame + 1;
+
+	std::cout << "  >>> Keypoint tracks: " << store.numTracks << " (" << numExtended << " extended, " << numStarted
+			  << " started, " << numEnded << " ended), mean length "
+			  << (store.numTracks > 0 ? static_cast<double>(totalLength) / store.numTracks : 0.0) << " frames"
+			  << std::endl;
+}
+
+int trackSlotOfKeypoint(const KeypointTrackStore &store, int keypointIdx) {
+	if (keypointIdx < 0 || keypointIdx >= static_cast<int>(store.slotOfKeypoint.size())) {
+		return -1;
+	}
+	return store.slotOfKeypoint[keypointIdx];
+}
+
+bool getTrackPosition(const KeypointTrackStore &store, int slot, int framesBack, cv::Point2f &position) {
+	if (slot < 0 || slot >= store.maxTracks || store.trackId[slot] < 0 || framesBack < 0) {
+		return false;
+	}
+	int kept = std::min(store.length[slot], store.historyLength);
+	if (framesBack >= kept) {
+		return false;
+	}
+	int frame = store.lastFrame[slot] - framesBack;
+	size_t entry = static_cast<size_t>(slot) * store.historyLength + frame % store.historyLength;
+	position = cv::Point2f(store.x[entry], store.y[entry]);
+	return true;
+}
+
+double computeTTCCameraTracks(const KeypointTrackStore &store, const std::vector<cv::DMatch> &kptMatches,
+							  int framesBack, double frameRate, const CameraTtcConf &conf, std::ostream &log) {
+	if (framesBack < 1) {
+		return NAN;
+	}
+	double t = (double)cv::getTickCount();
+	// positions of the tracks of the matches, framesBack frames before ("previous") and now ("current")
+	MatchedKeypoints points;
+	for (const auto &match : kptMatches) {
+		int slot = trackSlotOfKeypoint(store, match.trainIdx);
+		cv::Point2f back, now;
+		if (getTrackPosition(store, slot, framesBack, back) && getTrackPosition(store, slot, 0, now)) {
+			points.xPrev.push_back(back.x);
+			points.yPrev.push_back(back.y);
+			points.xCurr.push_back(now.x);
+			points.yCurr.push_back(now.y);
+		}
+	}
+	std::vector<float> distRatios;
+	int pairBudget = conf.pairs == CameraTtcPairs::SAMPLED ? conf.pairBudget : 0;
+	size_t numPairs = pairBudget > 0 ? sampledPairRatios(points, conf.minDist, pairBudget, distRatios)
+									 : allPairRatios(points, conf.minDist, distRatios);
+	if (distRatios.empty()) {
+		return NAN;
+	}
+	double ratio = medianRatio(distRatios);
+	double ttc = framesBack / (frameRate * (ratio - 1));
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+	log << "  >>> Camera TTC over " << framesBack << " frames: median ratio " << ratio << " (" << points.xPrev.size()
+		<< " of " << kptMatches.size() << " matches on tracks, " << distRatios.size() << " of " << numPairs
+		<< " pairs) in " << 1000 * t / 1.0 << " ms" << std::endl;
+	return ttc;
+}
@@ -0,0 +1,65 @@
+#ifndef KEYPOINT_TRACKS_H_
+#define KEYPOINT_TRACKS_H_
+
+#include <iostream>
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "dataStructures.h"
+
+/* Multi-frame keypoint tracks built from the keypoint matches of consecutive frame pairs.
+ *
+ * A track starts with a match whose previous frame keypoint is not on a track yet and is extended as long as its
+ * keypoint is matched into the next frame; it ends with the first frame its keypoint is not matched in. Every track
+ * occupies one of maxTracks slots. The store is a structure of arrays indexed by slot, the positions of a track are a
+ * ring of historyLength entries (slot * historyLength + frame % historyLength), hence the memory is allocated once and
+ * bounded by maxTracks x historyLength positions however long the sequence and the tracks are. New tracks are dropped
+ * while all slots are in use.
+ * The descriptor of a track is referenced by its keypoint index in the last frame it was seen in (lastFrame), i.e. the
+ * descriptor row of that frame while the frame is held in the ring buffer.
+ */
+struct KeypointTrackStore {
+	int historyLength = 0;
+	int maxTracks = 0;
+	int numFrames = 0;	 // frames added so far, the latest frame is numFrames - 1
+	int nextTrackId = 0;
+	int numTracks = 0;	 // slots in use
+
+	// per slot, trackId < 0 for a free slot
+	std::vector<int> trackId;
+	std::vector<int> lastFrame;		 // frame no. of the latest position
+	std::vector<int> length;		 // no. of frames the track has been seen in (positions kept: up to historyLength)
+	std::vector<int> keypointIdx;	 // keypoint index (= descriptor row) in lastFrame
+	// per slot and history entry
+	std::vector<float> x;
+	std::vector<float> y;
+
+	std::vector<int> freeSlots;
+	std::vector<int> slotOfKeypoint;  // slot of each keypoint of the latest frame, -1 if not on a track
+	int numDropped = 0;				  // tracks not started because all slots were in use
+};
+
+// Allocate the slots of the store; memory is bounded by conf.maxTracks x conf.historyLength positions
+void initKeypointTracks(KeypointTrackStore &store, const TrackStoreConf &conf);
+
+// Extend the tracks with the keypoint matches of the current frame (currentFrame.kptMatches, queryIdx: previous frame)
+void updateKeypointTracks(KeypointTrackStore &store, const DataFrame &previousFrame, const DataFrame &currentFrame);
+
+// Slot of the track of a keypoint of the latest frame, -1 if the keypoint is not on a track
+int trackSlotOfKeypoint(const KeypointTrackStore &store, int keypointIdx);
+
+/* Position of a track framesBack frames before the latest frame. Returns false if the track has not been seen then or
+ * the position has already been overwritten (framesBack >= historyLength).
+ */
+bool getTrackPosition(const KeypointTrackStore &store, int slot, int framesBack, cv::Point2f &position);
+
+/* Camera TTC over a baseline of framesBack frames from the tracks of the keypoint matches of a box (trainIdx: keypoint
+ * of the latest frame). The distance ratios of pairs of tracks between the latest frame and framesBack frames before
+ * are computed as for computeTTCCamera (distanceRatios.h, conf.minDist, conf.pairs), TTC = framesBack * delta_T /
+ * (median ratio - 1). Tracks not seen framesBack frames before are left out. Returns NAN without a valid pair.
+ */
+double computeTTCCameraTracks(const KeypointTrackStore &store, const std::vector<cv::DMatch> &kptMatches,
+							  int framesBack, double frameRate, const CameraTtcConf &conf,
+							  std::ostream &log = std::cout);
+
+#endif /* KEYPOINT_TRACKS_H_ */
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include "kltTracking.h"
+#include "matchingFeatures2D.h"
+#include "utils.h"
+
+namespace {
+
+void buildImagePyramid(DataFrame &frame, const KltTrackingConf &conf) {
+	cv::Mat imgGray;
+	cv::cvtColor(frame.cameraImg, imgGray, cv::COLOR_BGR2GRAY);
+	cv::buildOpticalFlowPyramid(imgGray, frame.imagePyramid, cv::Size(conf.windowSize, conf.windowSize),
+								conf.pyramidLevels);
+}
+
+/* Append the detected keypoints, strongest first, that have no keypoint in their own or a neighbouring cell of a grid
+ * with cells of cellSize pixels, i.e. are at least cellSize pixels away from all other keypoints. Returns the no. of
+ * appended keypoints.
+ */
+int addKeypoints(std::vector<cv::KeyPoint> &keypoints, std::vector<cv::KeyPoint> &detected, const cv::Size &imgSize,
+				 float cellSize) {
+	int gridCols = static_cast<int>(std::ceil(imgSize.width / cellSize));
+	int gridRows = static_cast<int>(std::ceil(imgSize.height / cellSize));
+	std::vector<uchar> occupied(gridRows * gridCols, 0);
+	auto cellOf = [&](const cv::Point2f &pt, int &row, int &col) {
+		col = std::min(std::max(static_cast<int>(pt.x / cellSize), 0), gridCols - 1);
+		row = std::min(std::max(static_cast<int>(pt.y / cellSize), 0), gridRows - 1);
+	};
+	int row, col;
+	for (const auto &keypoint : keypoints) {
+		cellOf(keypoint.pt, row, col);
+		occupied[row * gridCols + col] = 1;
+	}
+
+	std::sort(detected.begin(), detected.end(),
+			  [](const cv::KeyPoint &a, const cv::KeyPoint &b) { return a.response > b.response; });
+	int numAdded = 0;
+	for (const auto &keypoint : detected) {
+		cellOf(keypoint.pt, row, col);
+		bool isFree = true;
+		for (int r = std::max(row - 1, 0); r <= std::min(row + 1, gridRows - 1) && isFree; ++r) {
+			for (int c = std::max(col - 1, 0); c <= std::min(col + 1, gridCols - 1) && isFree; ++c) {
+				isFree = !occupied[r * gridCols + c];
+			}
+		}
+		if (isFree) {
+			occupied[row * gridCols + col] = 1;
+			keypoints.push_back(keypoint);
+			++numAdded;
+		}
+	}
+	return numAdded;
+}
+
+}  // namespace
+
+double detectKeypointsToTrack(DataFrame &frame, DetectorMethod detector, const TiledDetectionConf &tileConf,
+							  const KltTrackingConf &conf) {
+	double t = (double)cv::getTickCount();
+	buildImagePyramid(frame, conf);
+	cv::Mat imgGray = frame.imagePyramid[0];
+	std::vector<cv::KeyPoint> detected;
+	detectKeypoints(detector, detected, imgGray, tileConf);
+	frame.keypoints.clear();
+	addKeypoints(frame.keypoints, detected, imgGray.size(), conf.minKeypointDistance);
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+	std::cout << "  >>> KLT: " << frame.keypoints.size() << " keypoints to track in " << 1000 * t / 1.0 << " ms"
+			  << std::endl;
+	return t;
+}
+
+double trackKeypoints(DataFrame &previousFrame, DataFrame &currentFrame, DetectorMethod detector,
+					  const TiledDetectionConf &tileConf, const KltTrackingConf &conf, bool visualize) {
+	std::cout << "#5 : TRACK KEYPOINTS (KLT)" << std::endl;
+	double t = (double)cv::getTickCount();
+	if (previousFrame.imagePyramid.empty()) {
+		buildImagePyramid(previousFrame, conf);
+	}
+	buildImagePyramid(currentFrame, conf);
+	cv::Size window(conf.windowSize, conf.windowSize);
+	cv::TermCriteria criteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01);
+
+	std::vector<cv::Point2f> previousPoints, currentPoints;
+	cv::KeyPoint::convert(previousFrame.keypoints, previousPoints);
+	std::vector<uchar> status;
+	std::vector<float> error;
+	if (!previousPoints.empty()) {
+		cv::calcOpticalFlowPyrLK(previousFrame.imagePyramid, currentFrame.imagePyramid, previousPoints, currentPoints,
+								 status, error, window, conf.pyramidLevels, criteria);
+	}
+
+	// only the keypoints found in the current frame are tracked back, starting from their original position
+	std::vector<int> forwardIdx;
+	std::vector<cv::Point2f> forwardPoints, backwardPoints;
+	for (size_t i = 0; i < status.size(); ++i) {
+		if (status[i]) {
+			forwardIdx.push_back(static_cast<int>(i));
+			forwardPoints.push_back(currentPoints[i]);
+			backwardPoints.push_back(previousPoints[i]);
+		}
+	}
+	std::vector<uchar> backwardStatus;
+	if (!forwardPoints.empty()) {
+		cv::calcOpticalFlowPyrLK(currentFrame.imagePyramid, previousFrame.imagePyramid, forwardPoints, backwardPoints,
+								 backwardStatus, error, window, conf.pyramidLevels, criteria,
+								 cv::OPTFLOW_USE_INITIAL_FLOW);
+	}
+
+	std::vector<cv::KeyPoint> keypoints;
+	std::vector<cv::DMatch> matches;
+	keypoints.reserve(forwardIdx.size());
+	matches.reserve(forwardIdx.size());
+	int numRejected = 0;
+	for (size_t j = 0; j < forwardIdx.size(); ++j) {
+		int i = forwardIdx[j];
+		const cv::Point2f &pt = forwardPoints[j];
+		float forwardBackwardError = static_cast<float>(cv::norm(backwardPoints[j] - previousPoints[i]));
+		bool inside =
+			pt.x >= 0 && pt.y >= 0 && pt.x < currentFrame.cameraImg.cols && pt.y < currentFrame.cameraImg.rows;
+		if (!backwardStatus[j] || forwardBackwardError > conf.maxForwardBackwardError || !inside) {
+			++numRejected;
+			continue;
+		}
+		cv::KeyPoint keypoint = previousFrame.keypoints[i];
+		keypoint.pt = pt;
+		matches.push_back(cv::DMatch(i, static_cast<int>(keypoints.size()), forwardBackwardError));
+		keypoints.push_back(keypoint);
+	}
+	size_t numTracked = keypoints.size();
+
+	// the tracks thin out over time, refill them with new keypoints away from the tracked ones
+	int numAdded = 0;
+	if (static_cast<int>(numTracked) < conf.minTracks) {
+		cv::Mat imgGray = currentFrame.imagePyramid[0];
+		std::vector<cv::KeyPoint> detected;
+		detectKeypoints(detector, detected, imgGray, tileConf);
+		numAdded = addKeypoints(keypoints, detected, imgGray.size(), conf.minKeypointDistance);
+	}
+	currentFrame.keypoints = keypoints;
+	currentFrame.kptMatches = matches;
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+
+	std::cout << "  >>> KLT: " << numTracked << " of " << previousFrame.keypoints.size() << " keypoints tracked ("
+			  << numRejected << " rejected by the forward-backward check), " << numAdded << " keypoints re-detected in "
+			  << 1000 * t / 1.0 << " ms" << std::endl;
+
+	if (visualize) {
+		drawMatches(matches, currentFrame, previousFrame, "KLT keypoint tracks between two camera images");
+	}
+	return t;
+}
@@ -0,0 +1,29 @@
+#ifndef KLT_TRACKING_H_
+#define KLT_TRACKING_H_
+
+#include "dataStructures.h"
+
+/* Keypoint tracking with pyramidal Lucas-Kanade optical flow (KLT), an alternative to detecting, describing and
+ * matching keypoints in every frame.
+ *
+ * The keypoints of the previous frame are tracked into the current frame (cv::calcOpticalFlowPyrLK) and the tracked
+ * positions are tracked back into the previous frame. A track is kept only if the backward track ends within
+ * maxForwardBackwardError pixels of the keypoint it started from, which rejects keypoints lost to occlusion or drifted
+ * along an edge. The image pyramid of a frame is built once (DataFrame::imagePyramid) and reused when the frame
+ * becomes the previous frame.
+ * The tracked keypoints become the first keypoints of the current frame, kptMatches follows the convention of the
+ * descriptor matchers (queryIdx: previous frame keypoint, trainIdx: current frame keypoint), with the forward-backward
+ * error as match distance. If fewer than minTracks keypoints survive, the detector is run on the current frame and
+ * the new keypoints away from the tracked ones are appended; they have no match in this frame pair and are tracked
+ * from the next frame on. No descriptors are computed.
+ */
+
+// Build the image pyramid of the first frame and detect the keypoints to track, returns the time in seconds
+double detectKeypointsToTrack(DataFrame &frame, DetectorMethod detector, const TiledDetectionConf &tileConf,
+							  const KltTrackingConf &conf);
+
+// Track the keypoints of the previous frame into the current frame, returns the time in seconds
+double trackKeypoints(DataFrame &previousFrame, DataFrame &currentFrame, DetectorMethod detector,
+					  const TiledDetectionConf &tileConf, const KltTrackingConf &conf, bool visualize = false);
+
+#endif /* KLT_TRACKING_H_ */
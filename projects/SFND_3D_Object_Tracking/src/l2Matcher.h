@@ -0,0 +1,35 @@
+#ifndef L2_MATCHER_H_
+#define L2_MATCHER_H_
+
+#include <memory>
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* In-tree brute force L2 matcher for float descriptors (CV_32F, one descriptor per row, e.g. SIFT).
+ *
+ * The squared distances are computed as ||q||^2 + ||t||^2 - 2 * q.t, i.e. the distance matrix is a matrix product of
+ * the query and the train descriptors (SGEMM) plus the row norms. The product is cache blocked: the train descriptors
+ * are packed once per frame into panels of 16 rows stored dimension-major (L2MatcherIndex), a tile of train
+ * panels stays in the L2 cache while the rows of a query block are multiplied with it, and a register blocked
+ * micro-kernel computes 4 query x 16 train dot products at a time (AVX2 + FMA when enabled at build time,
+ * plain loops vectorized by the compiler otherwise). The nearest and second nearest train row of every query row are
+ * selected from each micro tile right away, the full distance matrix is never stored.
+ * Selection, ratio test, cross-check and tie handling are the same as for matchHamming (hammingMatcher.h); the
+ * distances are Euclidean (cv::NORM_L2), up to the rounding of the expanded form.
+ */
+struct L2MatcherIndex {
+	cv::Mat descriptors;		// indexed descriptors (shares the data of the frame descriptors)
+	int numPanels = 0;
+	std::vector<float> panels;	// numPanels x dims x 16 (panel width), rows beyond descriptors.rows are zero
+	std::vector<float> norms;	// squared L2 norm of each descriptor
+};
+
+std::shared_ptr<L2MatcherIndex> buildL2MatcherIndex(const cv::Mat &descriptors);
+
+void matchL2(const cv::Mat &descQuery, const L2MatcherIndex &index, std::vector<cv::DMatch> &matches,
+			 double maxRatio = 0.8, bool crossCheck = false);
+
+// Name of the instruction set used by the matchL2 micro-kernel (AVX2 + FMA or compiler vectorized)
+const char *l2MatcherInstructionSet();
+
+#endif /* L2_MATCHER_H_ */
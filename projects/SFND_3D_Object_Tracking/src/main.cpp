@@ -14,10 +14,14 @@
 #include <string>
 #include <vector>
 
+#include "boxMembership.h"
 #include "cameraFusion.h"
 #include "dataStructures.h"
+#include "keypointTracks.h"
+#include "kltTracking.h"
 #include "lidarData.h"
 #include "matchingFeatures2D.h"
+#include "objectTracks.h"
 #include "objectDetection2D.h"
 #include "tclap/CmdLine.h"
 #include "ttc.h"
@@ -30,8 +34,20 @@ int main(int argc, const char *argv[]) {
 	bool visualizeFusedData = false;
 	bool visualizeKeypoints = false;
 	bool visualizeKeypointMatch = false;
+	bool visualizeTTC = true;
+	bool logClusterStats = false;
 	bool crossCheckBruteForce = false;
 	int limitMaxKeypoints = 0;
+	TiledDetectionConf tileConf;
+	GuidedMatchingConf guidedConf;
+	KltTrackingConf kltConf;
+	TrackStoreConf trackConf;
+	CameraTtcConf cameraTtcConf;
+	TtcFilterConf ttcFilterConf;
+	TtcScheduleConf ttcScheduleConf;
+	BoxMatchingConf boxMatchingConf;
+	int benchmarkBoxes = 0;  // no. of random boxes of the box membership benchmark, 0: no benchmark
+	int dataBufferSize = 2;  // no. of images which are held in memory (ring buffer) at the same time
 	int detectorSelected = static_cast<int>(DetectorMethod::FAST);
 	int descriptorSelected = static_cast<int>(DescriptorMethod::BRISK);
 	int descriptorMetricSel = static_cast<int>(DescriptorMetric::BINARY);
@@ -73,17 +89,155 @@ int main(int argc, const char *argv[]) {
 									  "int");
 		cmdlineArg.add(lidarTTC);
 
+		TCLAP::ValueArg<int> cameraTtcMethod(
+			"", "camera-ttc-method",
+			"Scale change for the camera TTC (0: median distance ratio, 1: RANSAC similarity, 2: LMedS similarity)",
+			false, static_cast<int>(cameraTtcConf.method), "int");
+		cmdlineArg.add(cameraTtcMethod);
+		TCLAP::ValueArg<float> scaleThreshold("", "scale-threshold",
+											  "Max. residual of a RANSAC inlier of the camera TTC scale [px]", false,
+											  cameraTtcConf.inlierThreshold, "float");
+		cmdlineArg.add(scaleThreshold);
+		TCLAP::ValueArg<double> scaleConfidence("", "scale-confidence",
+												"Confidence at which the RANSAC / LMedS scale fit stops early", false,
+												cameraTtcConf.confidence, "double");
+		cmdlineArg.add(scaleConfidence);
+		TCLAP::ValueArg<bool> refineScale("", "refine-scale",
+										  "Refit the RANSAC / LMedS scale to the inliers by least squares", false,
+										  cameraTtcConf.refineScale, "bool");
+		cmdlineArg.add(refineScale);
+		TCLAP::ValueArg<int> boxAssignment(
+			"", "box-assignment",
+			"One-to-one assignment of the boxes of consecutive frames (0: greedy on sorted votes, 1: Hungarian)", false,
+			static_cast<int>(boxMatchingConf.assignment), "int");
+		cmdlineArg.add(boxAssignment);
+		TCLAP::ValueArg<int> evalBoxMembership(
+			"", "eval-box-membership",
+			"Time the keypoint-to-box membership for this many random boxes against testing all pairs (0: off)", false,
+			benchmarkBoxes, "int");
+		cmdlineArg.add(evalBoxMembership);
+		TCLAP::ValueArg<bool> filterTtc("", "ttc-filter",
+										"Kalman filter the TTC of each tracked object over Lidar and camera", false,
+										ttcFilterConf.enabled, "bool");
+		cmdlineArg.add(filterTtc);
+		TCLAP::ValueArg<bool> ttcFilterAccel("", "ttc-filter-accel",
+											 "Constant acceleration instead of constant velocity model of the filter",
+											 false, ttcFilterConf.acceleration, "bool");
+		cmdlineArg.add(ttcFilterAccel);
+		TCLAP::ValueArg<int> ttcSkipFrames(
+			"", "ttc-skip-frames",
+			"Skip the TTC estimators of a converged track for at most this many frames in a row (0: never skip)", false,
+			ttcFilterConf.maxSkippedFrames, "int");
+		cmdlineArg.add(ttcSkipFrames);
+		TCLAP::ValueArg<double> ttcConvergedStd("", "ttc-converged-std",
+												"Max. predicted std. of 1 / TTC of a converged track [1/s]", false,
+												ttcFilterConf.maxInvTtcStd, "double");
+		cmdlineArg.add(ttcConvergedStd);
+		TCLAP::ValueArg<bool> ttcSchedule("", "ttc-schedule",
+										  "Evaluate the TTC of the most critical objects first, within a time budget",
+										  false, ttcScheduleConf.enabled, "bool");
+		cmdlineArg.add(ttcSchedule);
+		TCLAP::ValueArg<double> ttcBudget("", "ttc-budget", "Time budget for the TTC of the objects of a frame [ms]",
+										  false, 1000 * ttcScheduleConf.timeBudget, "double");
+		cmdlineArg.add(ttcBudget);
+		TCLAP::ValueArg<int> ttcMaxDeferred("", "ttc-max-deferred",
+											"Max. no. of frames in a row the TTC of an object is deferred", false,
+											ttcScheduleConf.maxDeferredFrames, "int");
+		cmdlineArg.add(ttcMaxDeferred);
+		TCLAP::ValueArg<int> cameraTtcPairs("", "camera-ttc-pairs",
+											"Keypoint pairs used for the camera TTC (0: all, 1: sampled)", false,
+											static_cast<int>(cameraTtcConf.pairs), "int");
+		cmdlineArg.add(cameraTtcPairs);
+		TCLAP::ValueArg<int> cameraTtcPairBudget("", "camera-ttc-pair-budget",
+												 "Max. no. of keypoint pairs sampled for the camera TTC", false,
+												 cameraTtcConf.pairBudget, "int");
+		cmdlineArg.add(cameraTtcPairBudget);
+		TCLAP::ValueArg<int> cameraTtcMedian("", "camera-ttc-median",
+											 "Median of the camera TTC distance ratios (0: exact, 1: histogram)", false,
+											 static_cast<int>(cameraTtcConf.median), "int");
+		cmdlineArg.add(cameraTtcMedian);
+		TCLAP::ValueArg<double> medianError("", "median-error",
+											"Max. relative error of the histogram median of the distance ratios", false,
+											cameraTtcConf.maxMedianError, "double");
+		cmdlineArg.add(medianError);
+		TCLAP::ValueArg<bool> evalCameraTtc("", "eval-camera-ttc",
+											"Compare the sampled / histogram / RANSAC / LMedS camera TTC with the "
+											"camera TTC from the exact median distance ratio of all keypoint pairs",
+											false, cameraTtcConf.evalAccuracy, "bool");
+		cmdlineArg.add(evalCameraTtc);
+
 		TCLAP::ValueArg<bool> useCrossCheck(
 			"", "cross-check",
-			"Cross-Check matching between source and destination images. Used only for BRUTE_FORCE matcher.", false,
-			crossCheckBruteForce, "bool");
+			"Cross-Check matching between source and destination images (NN and kNN selection). Used only for the "
+			"BRUTE_FORCE and BRUTE_FORCE_SIMD matchers.",
+			false, crossCheckBruteForce, "bool");
 		cmdlineArg.add(useCrossCheck);
 
+		TCLAP::ValueArg<bool> guidedMatching(
+			"", "guided-matching",
+			"Match each keypoint only against keypoints near its position predicted by the last frame pair motion",
+			false, guidedConf.enabled, "bool");
+		cmdlineArg.add(guidedMatching);
+		TCLAP::ValueArg<float> searchRadius("", "search-radius", "Half size of the guided matching search window [px]",
+											false, guidedConf.searchRadius, "float");
+		cmdlineArg.add(searchRadius);
+		TCLAP::ValueArg<int> motionModel("", "motion-model",
+										 "Keypoint motion model for guided matching (0: median flow, 1: homography)",
+										 false, static_cast<int>(guidedConf.motionModel), "int");
+		cmdlineArg.add(motionModel);
+
+		TCLAP::ValueArg<bool> kltTracking(
+			"", "klt-tracking",
+			"Track the keypoints with pyramidal Lucas-Kanade optical flow instead of detecting, describing and "
+			"matching them in every frame",
+			false, kltConf.enabled, "bool");
+		cmdlineArg.add(kltTracking);
+		TCLAP::ValueArg<int> kltMinTracks("", "klt-min-tracks",
+										  "Re-detect keypoints when fewer keypoints are tracked into a frame", false,
+										  kltConf.minTracks, "int");
+		cmdlineArg.add(kltMinTracks);
+		TCLAP::ValueArg<float> kltMaxError("", "klt-fb-error",
+										   "Max. forward-backward tracking error of a keypoint [px]", false,
+										   kltConf.maxForwardBackwardError, "float");
+		cmdlineArg.add(kltMaxError);
+
+		TCLAP::ValueArg<int> bufferSize("", "buffer-size", "No. of frames held in the ring buffer (at least 2)", false,
+										dataBufferSize, "int");
+		cmdlineArg.add(bufferSize);
+		TCLAP::ValueArg<bool> keypointTracks("", "keypoint-tracks",
+											 "Link the keypoint matches of consecutive frames into multi-frame tracks",
+											 false, trackConf.enabled, "bool");
+		cmdlineArg.add(keypointTracks);
+		TCLAP::ValueArg<int> trackHistory("", "track-history", "Keypoint positions kept per track (frames)", false,
+										  trackConf.historyLength, "int");
+		cmdlineArg.add(trackHistory);
+		TCLAP::ValueArg<int> maxTracks("", "max-tracks", "Max. no. of keypoint tracks at the same time", false,
+									   trackConf.maxTracks, "int");
+		cmdlineArg.add(maxTracks);
+		TCLAP::ValueArg<int> trackTtcBaseline("", "track-ttc-baseline",
+											  "Camera TTC also from the keypoint tracks over N frames, N below "
+											  "--track-history (0: off)",
+											  false, trackConf.ttcBaseline, "int");
+		cmdlineArg.add(trackTtcBaseline);
+
 		TCLAP::ValueArg<int> maxNumKeypoints(
 			"", "limit-keypts", "Limit the number of keypoints on object (for debugging and visualization)", false,
 			limitMaxKeypoints, "int");
 		cmdlineArg.add(maxNumKeypoints);
 
+		TCLAP::ValueArg<int> tileRows("", "tile-rows",
+									  "Split the image into a grid with this many rows for tiled keypoint detection "
+									  "(0 disables tiling)",
+									  false, tileConf.gridRows, "int");
+		cmdlineArg.add(tileRows);
+		TCLAP::ValueArg<int> tileCols("", "tile-cols", "Number of grid columns for tiled keypoint detection", false,
+									  tileConf.gridCols, "int");
+		cmdlineArg.add(tileCols);
+		TCLAP::ValueArg<int> tileMaxKeypoints("", "tile-max-keypts",
+											  "Keep only the best N keypoints per tile (0 keeps all)", false,
+											  tileConf.maxKeypointsPerTile, "int");
+		cmdlineArg.add(tileMaxKeypoints);
+
 		TCLAP::ValueArg<bool> visYOLO("", "show-yolo", "Show results of Yolo detection for each frame", false,
 									  visualizeYolo, "bool");
 		cmdlineArg.add(visYOLO);
@@ -97,6 +251,14 @@ int main(int argc, const char *argv[]) {
 		TCLAP::ValueArg<bool> visKeypointMatch("", "show-keypoint-match", "Show keypoint matches between frames", false,
 											   visualizeKeypointMatch, "bool");
 		cmdlineArg.add(visKeypointMatch);
+		TCLAP::ValueArg<bool> visTTC("", "show-ttc", "Show the lidar and camera TTC of each frame (waits for ESC)",
+									 false, visualizeTTC, "bool");
+		cmdlineArg.add(visTTC);
+		TCLAP::ValueArg<bool> clusterStats("", "cluster-stats",
+										   "Print the keypoint match distance statistics of each box before and after "
+										   "filtering",
+										   false, logClusterStats, "bool");
+		cmdlineArg.add(clusterStats);
 
 		cmdlineArg.parse(argc, argv);
 
@@ -105,8 +267,13 @@ int main(int argc, const char *argv[]) {
 		visualizeFusedData = visFusion.getValue();
 		visualizeKeypoints = visKeypoints.getValue();
 		visualizeKeypointMatch = visKeypointMatch.getValue();
+		visualizeTTC = visTTC.getValue();
+		logClusterStats = clusterStats.getValue();
 
 		limitMaxKeypoints = maxNumKeypoints.getValue();
+		tileConf.gridRows = tileRows.getValue();
+		tileConf.gridCols = tileCols.getValue();
+		tileConf.maxKeypointsPerTile = tileMaxKeypoints.getValue();
 
 		detectorSelected = detType.getValue();
 		descriptorSelected = descType.getValue();
@@ -114,8 +281,37 @@ int main(int argc, const char *argv[]) {
 		matcherSelected = matcherType.getValue();
 		nnMatcherSelected = nnType.getValue();
 		crossCheckBruteForce = useCrossCheck.getValue();
+		guidedConf.enabled = guidedMatching.getValue();
+		guidedConf.searchRadius = searchRadius.getValue();
+		guidedConf.motionModel = static_cast<MotionModel>(motionModel.getValue());
+		kltConf.enabled = kltTracking.getValue();
+		kltConf.minTracks = kltMinTracks.getValue();
+		kltConf.maxForwardBackwardError = kltMaxError.getValue();
+		dataBufferSize = bufferSize.getValue();
+		trackConf.enabled = keypointTracks.getValue();
+		trackConf.historyLength = trackHistory.getValue();
+		trackConf.maxTracks = maxTracks.getValue();
+		trackConf.ttcBaseline = trackTtcBaseline.getValue();
 
 		lidarTtcMethodSel = lidarTTC.getValue();
+		cameraTtcConf.method = static_cast<CameraTtcMethod>(cameraTtcMethod.getValue());
+		cameraTtcConf.inlierThreshold = scaleThreshold.getValue();
+		cameraTtcConf.confidence = scaleConfidence.getValue();
+		cameraTtcConf.refineScale = refineScale.getValue();
+		boxMatchingConf.assignment = static_cast<BoxAssignment>(boxAssignment.getValue());
+		benchmarkBoxes = evalBoxMembership.getValue();
+		ttcFilterConf.enabled = filterTtc.getValue();
+		ttcFilterConf.acceleration = ttcFilterAccel.getValue();
+		ttcFilterConf.maxSkippedFrames = ttcSkipFrames.getValue();
+		ttcFilterConf.maxInvTtcStd = ttcConvergedStd.getValue();
+		ttcScheduleConf.enabled = ttcSchedule.getValue();
+		ttcScheduleConf.timeBudget = ttcBudget.getValue() / 1000;
+		ttcScheduleConf.maxDeferredFrames = ttcMaxDeferred.getValue();
+		cameraTtcConf.pairs = static_cast<CameraTtcPairs>(cameraTtcPairs.getValue());
+		cameraTtcConf.pairBudget = cameraTtcPairBudget.getValue();
+		cameraTtcConf.median = static_cast<CameraTtcMedian>(cameraTtcMedian.getValue());
+		cameraTtcConf.maxMedianError = medianError.getValue();
+		cameraTtcConf.evalAccuracy = evalCameraTtc.getValue();
 
 		// Check AKAZE descriptor/detector combination
 		if (descriptorSelected == static_cast<int>(DescriptorMethod::AKAZE) &&
@@ -123,6 +319,18 @@ int main(int argc, const char *argv[]) {
 			std::cerr << "AKAZE descriptor type is allowed only with AKAZE/KAZE keypoints. Exiting ..." << std::endl;
 			exit(EXIT_FAILURE);
 		}
+		// Positions are kept for historyLength frames (at least 2), the baseline must be shorter
+		if (trackConf.ttcBaseline > 0 &&
+			(!trackConf.enabled || trackConf.ttcBaseline >= std::max(trackConf.historyLength, 2))) {
+			std::cerr << "--track-ttc-baseline needs --keypoint-tracks 1 and a longer --track-history. Exiting ..."
+					  << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		// Tiled detection needs both grid dimensions
+		if ((tileConf.gridRows > 0) != (tileConf.gridCols > 0)) {
+			std::cerr << "Tiled detection needs both --tile-rows and --tile-cols. Exiting ..." << std::endl;
+			exit(EXIT_FAILURE);
+		}
 
 	} catch (TCLAP::ArgException &e) {
 		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
@@ -137,6 +345,7 @@ int main(int argc, const char *argv[]) {
 	KptMatchesClusterConf kptClusterConf;
 	kptClusterConf.method = KptMatchesClusterDistanceMethod::STDEV;
 	kptClusterConf.numStddev = 2;
+	kptClusterConf.logStats = logClusterStats;
 
 	// camera dataset config
 	DataSetConfig imgDataInfo;
@@ -169,8 +378,16 @@ int main(int argc, const char *argv[]) {
 
 	// Other misc settings
 	double sensorFrameRate = 10.0 / imgDataInfo.indexStepSize;  // frames per second for Lidar and camera
-	int dataBufferSize = 2;				// no. of images which are held in memory (ring buffer) at the same time
 	std::vector<DataFrame> dataBuffer;  // list of data frames which are held in memory at the same time
+	KeypointTrackStore trackStore;		// keypoint tracks over more than one frame pair
+	if (trackConf.enabled) {
+		initKeypointTracks(trackStore, trackConf);
+	}
+	TtcFilter ttcFilter;  // Kalman filtered TTC per tracked object
+	initTtcFilter(ttcFilter, ttcFilterConf);
+	TtcScheduler ttcScheduler;  // priority ordered TTC evaluation within a time budget
+	initTtcScheduler(ttcScheduler, ttcScheduleConf);
+	TrackManager trackManager;	// persistent object track IDs and per-track cached state
 
 	/* MAIN LOOP OVER ALL IMAGES */
 	for (size_t imgIndex = 0; imgIndex <= imgDataInfo.endIndex - imgDataInfo.startIndex;
@@ -184,7 +401,7 @@ int main(int argc, const char *argv[]) {
 		// Push image into data frame buffer
 		DataFrame frame;
 		frame.cameraImg = img;
-		pushToBuffer(dataBuffer, frame);
+		pushToBuffer(dataBuffer, frame, dataBufferSize);
 		auto currentFrameIter = dataBuffer.end() - 1;
 
 		// Detect and classify objectst with YOLO
@@ -235,20 +452,46 @@ int main(int argc, const char *argv[]) {
 						  visualizeFusedData);
 		}
 
-		// Perform features detection and run feature descriptor algorithms
-		runFeatureDetection(*currentFrameIter, detectorMethod, descriptorMethod, limitMaxKeypoints, visualizeKeypoints);
+		// Keypoint correspondences between the previous and the current frame
+		double timeCorrespondences = (double)cv::getTickCount();
+		if (kltConf.enabled) {
+			// track the keypoints of the previous frame, detect only in the first frame or when too few are tracked
+			if (dataBuffer.size() > 1) {
+				trackKeypoints(*(dataBuffer.end() - 2), *currentFrameIter, detectorMethod, tileConf, kltConf,
+							   visualizeKeypointMatch);
+			} else {
+				detectKeypointsToTrack(*currentFrameIter, detectorMethod, tileConf, kltConf);
+			}
+		} else {
+			// Perform features detection and run feature descriptor algorithms
+			runFeatureDetection(*currentFrameIter, detectorMethod, descriptorMethod, tileConf, limitMaxKeypoints,
+								visualizeKeypoints);
+
+			// Perform Keypoint matching
+			if (dataBuffer.size() > 1) {  // wait until at least two images have been processed
+				performFeatureMatching(*currentFrameIter, *(dataBuffer.end() - 2), descriptorMethod, descriptorMetric,
+									   matcherMethod, nnSelector, crossCheckBruteForce, guidedConf,
+									   visualizeKeypointMatch);
+			}
+		}
+		timeCorrespondences = ((double)cv::getTickCount() - timeCorrespondences) / cv::getTickFrequency();
+		std::cout << "  >>> Keypoint correspondences in " << 1000 * timeCorrespondences / 1.0 << " ms" << std::endl;
 
-		// Perform Keypoint matching
 		if (dataBuffer.size() > 1)  // wait until at least two images have been processed
 		{
 			auto previousFrameIter = dataBuffer.end() - 2;
-			performFeatureMatching(*currentFrameIter, *previousFrameIter, descriptorMethod, descriptorMetric,
-								   matcherMethod, nnSelector, crossCheckBruteForce, visualizeKeypointMatch);
+			if (trackConf.enabled) {
+				updateKeypointTracks(trackStore, *previousFrameIter, *currentFrameIter);
+			}
 
 			/* Track 3D object bounding boxes
 			 *  associate bounding boxes between current and previous frame using keypoint matches
 			 */
-			matchBoundingBoxes(*currentFrameIter, *previousFrameIter);
+			matchBoundingBoxes(*currentFrameIter, *previousFrameIter, boxMatchingConf);
+			if (benchmarkBoxes > 0) {
+				benchmarkBoxMembership(currentFrameIter->keypoints, currentFrameIter->cameraImg.size(), benchmarkBoxes);
+			}
+			updateObjectTracks(trackManager, *previousFrameIter, *currentFrameIter);
 
 			if (visualizeYolo) {
 				//
@@ -258,8 +501,10 @@ int main(int argc, const char *argv[]) {
 			}
 
 			// compute TTC for object in front
-			evalTTC(lidarTtcMethod, kptClusterConf, *currentFrameIter, *previousFrameIter, P_rect_00, R_rect_00, RT,
-					sensorFrameRate, false, true);
+			evalTTC(lidarTtcMethod, kptClusterConf, cameraTtcConf, *currentFrameIter, *previousFrameIter, P_rect_00,
+					R_rect_00, RT, sensorFrameRate, false, visualizeTTC, ttcFilterConf.enabled ? &ttcFilter : nullptr,
+					ttcScheduleConf.enabled ? &ttcScheduler : nullptr, &trackManager,
+					trackConf.ttcBaseline > 0 ? &trackStore : nullptr, trackConf.ttcBaseline);
 		}
 	}  // eof loop over all images
 
@@ -1,16 +1,26 @@
+#include <algorithm>
 #include <numeric>
 
+#include "cornerSelection.h"
+#include "crossCheckMatcher.h"
+#include "descriptorArena.h"
+#include "descriptorIndex.h"
+#include "fastCorners.h"
+#include "guidedMatching.h"
+#include "hammingMatcher.h"
+#include "l2Matcher.h"
 #include "matchingFeatures2D.h"
+#include "multiIndexHash.h"
 #include "utils.h"
 
 void runFeatureDetection(DataFrame &currentFrame, DetectorMethod detector, DescriptorMethod descriptor,
-						 int limitMaxKeypoints, bool visualize) {
+						 const TiledDetectionConf &tileConf, int limitMaxKeypoints, bool visualize) {
 	// Convert current image to grayscale; most algorithms work only with grayscale iamges
 	cv::Mat imgGray;
 	cv::cvtColor(currentFrame.cameraImg, imgGray, cv::COLOR_BGR2GRAY);
 	std::vector<cv::KeyPoint> keypoints;  // create empty feature list for current image
 										  // convert current image to grayscale
-	double timeKptDetection = detectKeypoints(detector, keypoints, imgGray, visualize);
+	double timeKptDetection = detectKeypoints(detector, keypoints, imgGray, tileConf, visualize);
 	// optional : limit number of keypoints (helpful for debugging and learning)
 	if (limitMaxKeypoints != 0) {
 		filterKeypointsNumber(detector, keypoints, limitMaxKeypoints);
@@ -20,18 +30,32 @@ void runFeatureDetection(DataFrame &currentFrame, DetectorMethod detector, Descr
 
 	cv::Mat descriptors;
 	double timeDescriptor = descKeypoints(descriptor, currentFrame.keypoints, currentFrame.cameraImg, descriptors);
-	// push descriptors for current frame to end of data buffer
-	currentFrame.descriptors = descriptors;
+	// push descriptors for current frame to end of data buffer (aligned, padded rows in the arena of the frame)
+	storeDescriptors(currentFrame, descriptors, getDescriptorTraits(descriptor));
 }
 
 void performFeatureMatching(DataFrame &currentFrame, DataFrame &previousFrame, DescriptorMethod descriptorMethod,
 							DescriptorMetric descriptorMetric, MatcherMethod matcherMethod,
-							NeighborSelectorMethod nnSelector, bool crossCheckBruteForce, bool visualize) {
+							NeighborSelectorMethod nnSelector, bool crossCheckBruteForce,
+							const GuidedMatchingConf &guidedConf, bool visualize) {
 	// wait until at least two images have been processed
 	std::vector<cv::DMatch> matches;
-	double timeMatcher =
-		matchDescriptors(previousFrame.descriptors, currentFrame.descriptors, matches, descriptorMethod,
-						 descriptorMetric, matcherMethod, nnSelector, crossCheckBruteForce);
+	if (guidedConf.enabled && !previousFrame.keypointMotion.empty()) {
+		std::cout << "#7 : PERFORM MOTION-GUIDED KEYPOINT DESCRIPTORS MATCHING" << std::endl;
+		int normType = selectNormTypeMatcher(descriptorMethod, descriptorMetric);
+		matchDescriptorsGuided(previousFrame, currentFrame, previousFrame.keypointMotion, matches, normType,
+							   matcherMethod, nnSelector, crossCheckBruteForce, guidedConf);
+	} else {
+		// first frame pair or no motion estimate: the motion is unknown, match against all descriptors
+		matchDescriptors(previousFrame, currentFrame, matches, descriptorMethod, descriptorMetric, matcherMethod,
+						 nnSelector, crossCheckBruteForce);
+	}
+	if (guidedConf.enabled) {
+		// constant velocity: the motion of this frame pair predicts the keypoint positions in the next frame
+		double timeMotion = estimateKeypointMotion(previousFrame.keypoints, currentFrame.keypoints, matches,
+												   guidedConf, currentFrame.keypointMotion);
+		std::cout << "  >>> Keypoint motion estimated in " << 1000 * timeMotion / 1.0 << " ms" << std::endl;
+	}
 	// store matches in current data frame
 	currentFrame.kptMatches = matches;
 
@@ -41,19 +65,14 @@ void performFeatureMatching(DataFrame &currentFrame, DataFrame &previousFrame, D
 	}
 }
 
-double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool visualize) {
+double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
+					   const TiledDetectionConf &tileConf, bool visualize) {
 	double timeDetector;
 	std::cout << "#5 : DETECT KEYPOINTS" << std::endl;
-	switch (detector) {
-		case DetectorMethod::SHITOMASI:
-			timeDetector = detKeypointsShiTomasi(keypoints, img);
-			break;
-		case DetectorMethod::HARRIS:
-			timeDetector = detKeypointsHarris(keypoints, img);
-			break;
-		default:
-			timeDetector = detKeypointsModern(detector, keypoints, img);
-			break;
+	if (tileConf.gridRows > 0 && tileConf.gridCols > 0) {
+		timeDetector = detKeypointsTiled(detector, keypoints, img, tileConf);
+	} else {
+		timeDetector = detectKeypointsFullImage(detector, keypoints, img);
 	}
 	// visualize results
 	if (visualize) {
@@ -69,6 +88,28 @@ double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypo
 	return timeDetector;
 }
 
+double detectKeypointsFullImage(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
+	double timeDetector;
+	switch (detector) {
+		case DetectorMethod::SHITOMASI:
+			timeDetector = detKeypointsShiTomasi(keypoints, img);
+			break;
+		case DetectorMethod::HARRIS:
+			timeDetector = detKeypointsHarris(keypoints, img);
+			break;
+		case DetectorMethod::SHITOMASI_GRID:
+			timeDetector = detKeypointsGrid(keypoints, img, false);
+			break;
+		case DetectorMethod::HARRIS_GRID:
+			timeDetector = detKeypointsGrid(keypoints, img, true);
+			break;
+		default:
+			timeDetector = detKeypointsModern(detector, keypoints, img);
+			break;
+	}
+	return timeDetector;
+}
+
 // Detect keypoints in image using the traditional Shi-Thomasi detector
 double detKeypointsShiTomasi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
 	return detectKeypointsClassic(keypoints, img, false);
@@ -78,7 +119,8 @@ double detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
 	return detectKeypointsClassic(keypoints, img, true);
 }
 
-double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris) {
+// Shi-Tomasi/Harris corners as keypoints, sorted in descending quality order
+void detectCornersClassic(std::vector<cv::KeyPoint> &keypoints, const cv::Mat &img, bool useHarris) {
 	//  size of an average block for computing a derivative covariation matrix over each pixel neighborhood
 	int blockSize = 4;
 	double maxOverlap = 0.0;  // max. permissible overlap between two features in %
@@ -88,8 +130,6 @@ double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img
 	double qualityLevel = 0.01;  // minimal accepted quality of image corners
 	double k = 0.04;
 
-	// Apply corner detection
-	double t = (double)cv::getTickCount();
 	std::vector<cv::Point2f> corners;
 	cv::goodFeaturesToTrack(img, corners, maxCorners, qualityLevel, minDistance, cv::Mat(), blockSize, useHarris, k);
 
@@ -100,6 +140,12 @@ double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img
 		newKeyPoint.size = blockSize;
 		keypoints.push_back(newKeyPoint);
 	}
+}
+
+double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris) {
+	// Apply corner detection
+	double t = (double)cv::getTickCount();
+	detectCornersClassic(keypoints, img, useHarris);
 	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
 	if (useHarris) {
 		std::cout << "  >>> Harris detection with n=" << keypoints.size() << " keypoints in " << 1000 * t / 1.0 << " ms"
@@ -111,9 +157,22 @@ double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img
 	return t;
 }
 
-double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
-	cv::Ptr<cv::FeatureDetector> detectorPtr = nullptr;
+// Shi-Tomasi/Harris corners with bounded selection cost (grid NMS with per-cell cap and global top-K)
+double detKeypointsGrid(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris) {
+	CornerSelectionConf conf;
 	auto tick = cv::getTickCount();
+	CornerSelectionStats stats = selectCornersBounded(keypoints, img, useHarris, conf);
+	double t = static_cast<double>((cv::getTickCount() - tick)) / cv::getTickFrequency();
+	std::cout << "  >>> " << (useHarris ? "Harris" : "Shi-Tomasi") << " grid detection with n=" << stats.numSelected
+			  << " (max " << conf.maxCorners << ", " << stats.numCandidates << " candidates) keypoints in " << 1000 * t
+			  << " ms (response " << 1000 * stats.responseTimeSec << " ms, selection "
+			  << 1000 * stats.selectionTimeSec << " ms)" << std::endl;
+	return t;
+}
+
+// maxFeatures: max. no. of keypoints of the detectors that cap them (ORB)
+cv::Ptr<cv::FeatureDetector> createModernDetector(DetectorMethod detector, int maxFeatures) {
+	cv::Ptr<cv::FeatureDetector> detectorPtr = nullptr;
 	switch (detector) {
 		case DetectorMethod::FAST: {
 			int threshold =
@@ -123,14 +182,18 @@ double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &ke
 			detectorPtr = cv::FastFeatureDetector::create(threshold, setNMS, type);
 			break;
 		}
+		case DetectorMethod::FAST_SIMD: {
+			// same parameters as FAST, but using the in-tree vectorized kernel
+			int threshold = 40;
+			detectorPtr = FastCornerDetector::create(threshold, true);
+			break;
+		}
 		case DetectorMethod::BRISK:
 			detectorPtr = cv::BRISK::create();
 			break;
-		case DetectorMethod::ORB: {
-			int maxNumberFeatures = 500;
-			detectorPtr = cv::ORB::create(maxNumberFeatures);
+		case DetectorMethod::ORB:
+			detectorPtr = cv::ORB::create(maxFeatures);
 			break;
-		}
 		case DetectorMethod::AKAZE:
 			detectorPtr = cv::AKAZE::create();
 			break;
@@ -138,8 +201,17 @@ double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &ke
 			detectorPtr = cv::xfeatures2d::SIFT::create();
 			break;
 		default:
-			std::cout << "Unknown detector method!" << std::endl;
-			return 0.0;
+			break;
+	}
+	return detectorPtr;
+}
+
+double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img) {
+	auto tick = cv::getTickCount();
+	cv::Ptr<cv::FeatureDetector> detectorPtr = createModernDetector(detector);
+	if (detectorPtr == nullptr) {
+		std::cout << "Unknown detector method!" << std::endl;
+		return 0.0;
 	}
 
 	detectorPtr->detect(img, keypoints);
@@ -150,6 +222,162 @@ double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &ke
 	return t;
 }
 
+/* Margin [px] along the image edge in which a detector (as created by createModernDetector) finds no keypoints, at
+ * the coarsest scale it finds keypoints at in an image of imageSize. A tile padded by this margin yields keypoints up
+ * to its own edge, so the tile seams get no empty band. The margin of the scale space detectors grows with the octave,
+ * hence their padding is large.
+ */
+int detectorTileBorder(DetectorMethod detector, const cv::Size &imageSize) {
+	// the coarse octaves of the scale space detectors are only searched as long as a keypoint fits into them
+	int minSide = std::min(imageSize.width, imageSize.height);
+	switch (detector) {
+		case DetectorMethod::FAST:
+		case DetectorMethod::FAST_SIMD:
+			// Bresenham circle of radius 3 and the 3x3 non-maximum suppression
+			return 4;
+		case DetectorMethod::SHITOMASI:
+		case DetectorMethod::HARRIS:
+		case DetectorMethod::SHITOMASI_GRID:
+		case DetectorMethod::HARRIS_GRID:
+			// block size 4, 3x3 Sobel, 3x3 non-maximum suppression and the min. distance of 4 between corners
+			return 8;
+		case DetectorMethod::ORB: {
+			// edgeThreshold 31 at the top of 8 pyramid levels with scale factor 1.2 (cv::ORB defaults)
+			int edgeThreshold = 31, numLevels = 8;
+			double scaleFactor = 1.2;
+			return static_cast<int>(std::ceil(edgeThreshold * std::pow(scaleFactor, numLevels - 1)));
+		}
+		case DetectorMethod::BRISK: {
+			// keypoints whose sampling pattern (about the keypoint size, 12 px x scale) leaves the image are dropped;
+			// the scale of 3 octaves reaches 2^3
+			int basicSize = 12, numOctaves = 3;
+			return basicSize << numOctaves;
+		}
+		case DetectorMethod::AKAZE: {
+			/* keypoints closer than 10 sqrt(2) x the derivative scale 1.5 sigma to the edge of their octave are
+			 * dropped (descriptor support); the 4 octaves have 4 sublevels each, sigma = 1.6 x 2^(octave + 3/4) at the
+			 * last sublevel
+			 */
+			int numOctaves = 4, numSublevels = 4;
+			int border = 0;
+			for (int octave = 0; octave < numOctaves; ++octave) {
+				double sigma = 1.6 * std::pow(2.0, octave + (numSublevels - 1.0) / numSublevels);
+				int sigmaSize = cvRound(1.5 * sigma / (1 << octave));
+				int margin = static_cast<int>(std::ceil(10 * std::sqrt(2.0) * sigmaSize)) + 1;
+				if (minSide >> octave <= 2 * margin) {
+					break;  // no keypoint fits into this octave
+				}
+				border = margin << octave;
+			}
+			return border;
+		}
+		case DetectorMethod::SIFT: {
+			// extrema within 5 px of the edge of their octave are dropped; octave -1 is the 2x upsampled image
+			int imgBorder = 5;
+			int border = imgBorder / 2 + 1;
+			for (int octave = 0; (minSide >> octave) > 2 * imgBorder + 2; ++octave) {
+				border = imgBorder << octave;
+			}
+			return border;
+		}
+		default:
+			return 16;
+	}
+}
+
+/* Split the image into a gridRows x gridCols grid and run the detector on each tile in parallel (OpenCV thread pool).
+ * Each tile is padded by tileBorder pixels (by default the edge margin of the detector, see detectorTileBorder) so
+ * that keypoints are found up to the tile edges; only keypoints whose position falls inside the un-padded tile are
+ * kept, hence no duplicates between adjacent tiles. ORB caps its keypoints per detection, the cap of a tile is the
+ * full image cap scaled by the area of the padded tile (and at least maxKeypointsPerTile scaled to the padded tile).
+ * If maxKeypointsPerTile is set, only the strongest keypoints of each tile are retained which spreads the keypoints
+ * evenly over the image instead of clustering them on highly textured areas.
+ */
+double detKeypointsTiled(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
+						 const TiledDetectionConf &tileConf) {
+	bool isClassic = (detector == DetectorMethod::SHITOMASI || detector == DetectorMethod::HARRIS);
+	bool isGrid = (detector == DetectorMethod::SHITOMASI_GRID || detector == DetectorMethod::HARRIS_GRID);
+	if (!isClassic && !isGrid && createModernDetector(detector) == nullptr) {
+		std::cout << "Unknown detector method!" << std::endl;
+		return 0.0;
+	}
+
+	auto tick = cv::getTickCount();
+	int numTiles = tileConf.gridRows * tileConf.gridCols;
+	int tileWidth = static_cast<int>(std::ceil(img.cols / static_cast<double>(tileConf.gridCols)));
+	int tileHeight = static_cast<int>(std::ceil(img.rows / static_cast<double>(tileConf.gridRows)));
+	cv::Rect imgRect(0, 0, img.cols, img.rows);
+	int border = tileConf.tileBorder >= 0 ? tileConf.tileBorder : detectorTileBorder(detector, img.size());
+
+	std::vector<std::vector<cv::KeyPoint>> tileKeypoints(numTiles);
+	cv::parallel_for_(cv::Range(0, numTiles), [&](const cv::Range &range) {
+		for (int tileIdx = range.start; tileIdx < range.end; ++tileIdx) {
+			cv::Rect tile((tileIdx % tileConf.gridCols) * tileWidth, (tileIdx / tileConf.gridCols) * tileHeight,
+						  tileWidth, tileHeight);
+			tile &= imgRect;
+			cv::Rect paddedTile(tile.x - border, tile.y - border, tile.width + 2 * border, tile.height + 2 * border);
+			paddedTile &= imgRect;
+			if (tile.area() == 0) {
+				continue;
+			}
+
+			std::vector<cv::KeyPoint> &kpts = tileKeypoints[tileIdx];
+			cv::Mat tileImg = img(paddedTile);
+			if (isClassic) {
+				detectCornersClassic(kpts, tileImg, detector == DetectorMethod::HARRIS);
+			} else if (isGrid) {
+				selectCornersBounded(kpts, tileImg, detector == DetectorMethod::HARRIS_GRID);
+			} else {
+				// the same keypoint density as the full image, enough for the top-K of the tile
+				double paddedRatio = static_cast<double>(paddedTile.area()) / imgRect.area();
+				int tileMaxFeatures = static_cast<int>(std::ceil(kOrbMaxFeatures * paddedRatio));
+				if (tileConf.maxKeypointsPerTile > 0) {
+					double coreRatio = static_cast<double>(paddedTile.area()) / tile.area();
+					int topK = static_cast<int>(std::ceil(tileConf.maxKeypointsPerTile * coreRatio));
+					tileMaxFeatures = std::max(tileMaxFeatures, topK);
+				}
+				createModernDetector(detector, tileMaxFeatures)->detect(tileImg, kpts);
+			}
+
+			// move keypoints back into image coordinates and drop the ones detected in the padding
+			cv::Point2f offset(paddedTile.x, paddedTile.y);
+			for (auto &kpt : kpts) {
+				kpt.pt += offset;
+			}
+			cv::Rect2f tileCore(tile);
+			auto newEnd = std::remove_if(kpts.begin(), kpts.end(), [&tileCore](const cv::KeyPoint &kpt) {
+				return !tileCore.contains(kpt.pt);
+			});
+			kpts.erase(newEnd, kpts.end());
+
+			if (tileConf.maxKeypointsPerTile > 0 && kpts.size() > static_cast<size_t>(tileConf.maxKeypointsPerTile)) {
+				if (isClassic) {
+					// corners carry no response but are sorted in descending quality order
+					kpts.erase(kpts.begin() + tileConf.maxKeypointsPerTile, kpts.end());
+				} else {
+					cv::KeyPointsFilter::retainBest(kpts, tileConf.maxKeypointsPerTile);
+				}
+			}
+		}
+	});
+
+	// merge per-tile results in tile order so that the output does not depend on thread scheduling
+	size_t numKeypoints = 0;
+	for (const auto &kpts : tileKeypoints) {
+		numKeypoints += kpts.size();
+	}
+	keypoints.reserve(keypoints.size() + numKeypoints);
+	for (const auto &kpts : tileKeypoints) {
+		keypoints.insert(keypoints.end(), kpts.begin(), kpts.end());
+	}
+
+	double t = static_cast<double>((cv::getTickCount() - tick)) / cv::getTickFrequency();
+	std::cout << "  >>> " << DetectorMethodToString(detector) << " (tiled " << tileConf.gridRows << "x"
+			  << tileConf.gridCols << ") with n= " << keypoints.size() << " keypoints in " << 1000 * t / 1.0 << " ms"
+			  << std::endl;
+	return t;
+}
+
 // Use one of several types of state-of-art descriptors to uniquely identify keypoints
 double descKeypoints(DescriptorMethod descriptor, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
 					 cv::Mat &descriptors) {
@@ -197,68 +425,130 @@ double descKeypoints(DescriptorMethod descriptor, std::vector<cv::KeyPoint> &key
 }
 
 // Find best matches for keypoints in two camera images based on several matching methods
-double matchDescriptors(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
+// The index over the previous frame's descriptors is built once and kept in the frame for later frame pairs; matches
+// are returned with queryIdx referring to the previous frame and trainIdx to the current frame.
+double matchDescriptorsWithIndex(DescriptorIndex &index, const cv::Mat &descriptors, std::vector<cv::DMatch> &matches,
+								 NeighborSelectorMethod nnSelector, bool crossCheck, const MihIndexConf &mihConf,
+								 int rowBytes) {
+	cv::Ptr<cv::DescriptorMatcher> &matcher = index.matcher;
+	cv::Mat descQuery = toIndexDescriptors(index, descriptors);
+
+	// Perform actual matching
+	/*
+	 * TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering
+	 * with t=0.8
+	 */
+	double timeMatching = 0.0;
+	double minDescriptorDistRatio = 0.8;
+	if (!index.matcher) {
+		// BRUTE_FORCE_SIMD, MULTI_INDEX_HASH: nearest neighbour selection and ratio test are done during the search
+		bool useRatioTest = nnSelector == NeighborSelectorMethod::kNN;
+		double t = (double)cv::getTickCount();
+		if (index.multiIndexHash) {
+			matchMultiIndexHash(descriptors, *index.multiIndexHash, matches,
+								useRatioTest ? minDescriptorDistRatio : 0.0, mihConf.maxRadius);
+		} else if (index.l2Index) {
+			matchL2(descriptors, *index.l2Index, matches, useRatioTest ? minDescriptorDistRatio : 0.0, crossCheck);
+		} else {
+			matchHamming(descriptors, index.trainDescriptors, matches, useRatioTest ? minDescriptorDistRatio : 0.0,
+						 crossCheck, rowBytes);
+		}
+		timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+		std::cout << "  >>> (" << (useRatioTest ? "kNN" : "NN") << ") with n=" << matches.size() << " matches in "
+				  << 1000 * timeMatching / 1.0 << " ms" << std::endl;
+	} else {
+		switch (nnSelector) {
+			case NeighborSelectorMethod::NN: {
+				std::cout << "  >>> Using Nearest Neighbor matching ..." << std::endl;
+				double t = (double)cv::getTickCount();
+				matcher->match(descQuery, matches);  // Finds the best match in the index for each descriptor
+				timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+				std::cout << "  >>> (NN) with n=" << matches.size() << " matches in " << 1000 * timeMatching / 1.0
+						  << " ms" << std::endl;
+				break;
+			}
+			case NeighborSelectorMethod::kNN: {
+				if (crossCheck && !index.trainDescriptors.empty()) {
+					// cv::BFMatcher ignores the cross-check for k > 1, ratio test and cross-check in a single pass
+					std::cout << "  >>> Using k-Nearest Neighbor matching with cross-check ..." << std::endl;
+					double t = (double)cv::getTickCount();
+					matchKnnCrossCheck(descQuery, index.trainDescriptors, index.normType, matches,
+									   minDescriptorDistRatio);
+					timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+					std::cout << "  >>> (kNN) with n=" << matches.size() << " cross-checked matches in "
+							  << 1000 * timeMatching / 1.0 << " ms" << std::endl;
+					break;
+				}
+				std::cout << "  >>> Using k-Nearest Neighbor matching ..." << std::endl;
+				// k nearest neighbors (k=2)
+				int desiredNumMatches = 2;
+				timeMatching = runKNN(descQuery, matches, matcher, desiredNumMatches, minDescriptorDistRatio);
+
+			} break;
+			default:
+				std::cout << "Unknown keypoint/descriptor matching method: allowed NN/kNN only!" << std::endl;
+				return 0.0;
+		}
+	}
+	return timeMatching;
+}
+
+double matchDescriptors(DataFrame &previousFrame, DataFrame &currentFrame, std::vector<cv::DMatch> &matches,
 						DescriptorMethod descriptorMethod, DescriptorMetric descrMetric, MatcherMethod matcherMethod,
-						NeighborSelectorMethod nnSelector, bool crossCheck) {
-	// configure matcher
+						NeighborSelectorMethod nnSelector, bool crossCheck, const LshIndexConf &lshConf,
+						const MihIndexConf &mihConf) {
 	std::cout << "#7 : PERFORM KEYPOINT DESCRIPTORS MATCHING" << std::endl;
-	cv::Ptr<cv::DescriptorMatcher> matcher;
+	if (previousFrame.descriptors.empty() || currentFrame.descriptors.empty()) {
+		std::cout << "  >>> No descriptors to match!" << std::endl;
+		return 0.0;
+	}
 	int normType = selectNormTypeMatcher(descriptorMethod, descrMetric);
 	/*
 	 * TASK MP.5 -> add FLANN matching
 	 */
 	// Select matcher method to be used
 	switch (matcherMethod) {
-		case MatcherMethod::FLANN: {
-			std::cout << "      >>> Using FLANN matching ..." << std::endl;
-			if (descSource.type() != CV_32F) {
-				// OpenCV bug workaround : convert binary descriptors to floating point due to
-				// a bug in current OpenCV implementation
-				std::cout << "    >>> Bypassing OpenCV FLANN implementation bug ..." << std::endl;
-				descSource.convertTo(descSource, CV_32F);
-			}
-			if (descRef.type() != CV_32F) {
-				descRef.convertTo(descRef, CV_32F);
-			}
-			matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
+		case MatcherMethod::FLANN:
+			std::cout << "  >>> Using FLANN matching ..." << std::endl;
+			break;
+		case MatcherMethod::FLANN_LSH:
+			std::cout << "  >>> Using FLANN LSH matching ..." << std::endl;
 			break;
-		}
 		case MatcherMethod::BRUTE_FORCE:
 			std::cout << "  >>> Using BRUTE_FORCE matching ..." << std::endl;
-			matcher = cv::BFMatcher::create(normType, crossCheck);
+			break;
+		case MatcherMethod::BRUTE_FORCE_SIMD:
+			std::cout << "  >>> Using BRUTE_FORCE_SIMD ("
+					  << (currentFrame.descriptors.depth() == CV_32F ? l2MatcherInstructionSet()
+																	 : hammingMatcherInstructionSet())
+					  << ") matching ..." << std::endl;
+			break;
+		case MatcherMethod::MULTI_INDEX_HASH:
+			std::cout << "  >>> Using MULTI_INDEX_HASH matching ..." << std::endl;
 			break;
 		default:
-			std::cout << "Unknown descriptor matcher method! Defaulting to BRUTE_FORCE" << std::endl;
-			matcher = cv::BFMatcher::create(normType, crossCheck);
+			break;
 	}
 
-	// Perform actual matching
-	/*
-	 * TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering
-	 * with t=0.8
-	 */
-	double timeMatching = 0.0;
-	switch (nnSelector) {
-		case NeighborSelectorMethod::NN: {
-			std::cout << "  >>> Using Nearest Neighbor matching ..." << std::endl;
-			double t = (double)cv::getTickCount();
-			matcher->match(descSource, descRef, matches);  // Finds the best match for each descriptor in desc1
-			timeMatching = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
-			std::cout << "  >>> (NN) with n=" << matches.size() << " matches in " << 1000 * timeMatching / 1.0 << " ms"
-					  << std::endl;
-			break;
-		}
-		case NeighborSelectorMethod::kNN: {
-			std::cout << "  >>> Using k-Nearest Neighbor matching ..." << std::endl;
-			// k nearest neighbors (k=2)
-			int desiredNumMatches = 2;
-			double minDescriptorDistRatio = 0.8;
-			timeMatching = runKNN(descSource, descRef, matches, matcher, desiredNumMatches, minDescriptorDistRatio);
-
-		} break;
-		default:
-			std::cout << "Unknown keypoint/descriptor matching method: allowed NN/kNN only!" << std::endl;
-			return 0.0;
+	if (crossCheck && (matcherMethod == MatcherMethod::FLANN || matcherMethod == MatcherMethod::FLANN_LSH)) {
+		std::cout << "  >>> Cross-check is supported by the brute force matchers only, ignored" << std::endl;
+	}
+
+	// build the index over the previous frame only if it has not been built by an earlier frame pair
+	if (!isDescriptorIndexValid(previousFrame.descriptorIndex, matcherMethod, normType, crossCheck)) {
+		previousFrame.descriptorIndex =
+			buildDescriptorIndex(previousFrame.descriptors, matcherMethod, normType, crossCheck, lshConf, mihConf);
+		std::cout << "  >>> Descriptor index (n=" << previousFrame.descriptorIndex->numDescriptors << ") built in "
+				  << 1000 * previousFrame.descriptorIndex->buildTimeSec / 1.0 << " ms" << std::endl;
+	} else {
+		std::cout << "  >>> Reusing descriptor index of previous frame" << std::endl;
+	}
+	double timeMatching =
+		matchDescriptorsWithIndex(*previousFrame.descriptorIndex, currentFrame.descriptors, matches, nnSelector,
+								  crossCheck, mihConf, paddedRowBytes(previousFrame, currentFrame));
+	// the current frame is the query side of the index
+	for (auto &match : matches) {
+		std::swap(match.queryIdx, match.trainIdx);
 	}
 	return timeMatching;
 }
@@ -279,16 +569,17 @@ int selectNormTypeMatcher(DescriptorMethod descriptorMethod, DescriptorMetric de
 	}
 }
 
-double runKNN(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
-			  cv::Ptr<cv::DescriptorMatcher> &matcher, int desiredNumMatches, double minDescriptorDistRatio) {
+double runKNN(const cv::Mat &descQuery, std::vector<cv::DMatch> &matches, cv::Ptr<cv::DescriptorMatcher> &matcher,
+			  int desiredNumMatches, double minDescriptorDistRatio) {
 	std::vector<std::vector<cv::DMatch>> knn_matches;
 	double time = (double)cv::getTickCount();
-	matcher->knnMatch(descSource, descRef, knn_matches, desiredNumMatches);
+	matcher->knnMatch(descQuery, knn_matches, desiredNumMatches);
 	time = ((double)cv::getTickCount() - time) / cv::getTickFrequency();
 	std::cout << "  >>> (kNN) with n=" << knn_matches.size() << " matches in " << 1000 * time / 1.0 << " ms"
 			  << std::endl;
 	for (auto it = knn_matches.begin(); it != knn_matches.end(); ++it) {
-		if ((*it)[0].distance < minDescriptorDistRatio * (*it)[1].distance) {
+		// the ratio test needs a second neighbour (missing for tiny indices or cross-checked brute force)
+		if (it->size() > 1 && (*it)[0].distance < minDescriptorDistRatio * (*it)[1].distance) {
 			matches.push_back((*it)[0]);
 		}
 	}
@@ -19,30 +19,47 @@
 #include "dataStructures.h"
 
 void runFeatureDetection(DataFrame &currentFrame, DetectorMethod detector, DescriptorMethod descriptor,
-						 int limitMaxKeypoints, bool visualize);
+						 const TiledDetectionConf &tileConf, int limitMaxKeypoints, bool visualize);
 
 void performFeatureMatching(DataFrame &currentFrame, DataFrame &previousFrame, DescriptorMethod descriptorMethod,
 							DescriptorMetric descriptorMetric, MatcherMethod matcherMethod,
-							NeighborSelectorMethod nnSelector, bool crossCheckBruteForce, bool visualize);
+							NeighborSelectorMethod nnSelector, bool crossCheckBruteForce,
+							const GuidedMatchingConf &guidedConf, bool visualize);
 
 double detectKeypoints(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
-					   bool visualize = false);
+					   const TiledDetectionConf &tileConf, bool visualize = false);
+double detectKeypointsFullImage(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
+double detKeypointsTiled(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
+						 const TiledDetectionConf &tileConf);
+int detectorTileBorder(DetectorMethod detector, const cv::Size &imageSize);
+void detectCornersClassic(std::vector<cv::KeyPoint> &keypoints, const cv::Mat &img, bool useHarris);
 double detectKeypointsClassic(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris);
 double detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
 double detKeypointsShiTomasi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
+double detKeypointsGrid(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool useHarris);
+const int kOrbMaxFeatures = 500;  // max. no. of ORB keypoints of a full image
+cv::Ptr<cv::FeatureDetector> createModernDetector(DetectorMethod detector, int maxFeatures = kOrbMaxFeatures);
 double detKeypointsModern(DetectorMethod detector, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img);
 
 double descKeypoints(DescriptorMethod descriptor, std::vector<cv::KeyPoint> &keypoints, cv::Mat &img,
 					 cv::Mat &descriptors);
 
-double matchDescriptors(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
+double matchDescriptors(DataFrame &previousFrame, DataFrame &currentFrame, std::vector<cv::DMatch> &matches,
 						DescriptorMethod descriptorMethod, DescriptorMetric descrMetric, MatcherMethod matcherMethod,
-						NeighborSelectorMethod nnSelector, bool crossCheck);
+						NeighborSelectorMethod nnSelector, bool crossCheck,
+						const LshIndexConf &lshConf = LshIndexConf(), const MihIndexConf &mihConf = MihIndexConf());
+
+/* Nearest neighbour (NN) or ratio tested (kNN) matches of the descriptors in the index, queryIdx = descriptor row,
+ * trainIdx = index row; rowBytes as for matchHamming (hammingMatcher.h). Returns the matching time in seconds.
+ */
+double matchDescriptorsWithIndex(DescriptorIndex &index, const cv::Mat &descriptors, std::vector<cv::DMatch> &matches,
+								 NeighborSelectorMethod nnSelector, bool crossCheck,
+								 const MihIndexConf &mihConf = MihIndexConf(), int rowBytes = 0);
 
 int selectNormTypeMatcher(DescriptorMethod descriptorMethod, DescriptorMetric descrMetric);
 
-double runKNN(cv::Mat &descSource, cv::Mat &descRef, std::vector<cv::DMatch> &matches,
-			  cv::Ptr<cv::DescriptorMatcher> &matcher, int desiredNumMatches, double minDescriptorDistRatio);
+double runKNN(const cv::Mat &descQuery, std::vector<cv::DMatch> &matches, cv::Ptr<cv::DescriptorMatcher> &matcher,
+			  int desiredNumMatches, double minDescriptorDistRatio);
 
 std::string DetectorMethodToString(int value);
 std::string DescriptorMethodToString(int value);
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+#include <opencv2/core/hal/hal.hpp>
+
+#include "multiIndexHash.h"
+
+namespace {
+
+const int kQueryBlockSize = 64;  // queries per parallel task
+const int kProbeCost = 4;		 // cost of probing a bucket (a cache miss) in units of a descriptor distance
+
+// Bucket of a descriptor in the hash table of the given substring (little endian byte order for 16 bit substrings)
+inline int substringKey(const uchar *descriptor, int table, int substringBits, int numBytes) {
+	if (substringBits == 8) {
+		return descriptor[table];
+	}
+	int byte = 2 * table;
+	return byte + 1 < numBytes ? descriptor[byte] | (descriptor[byte + 1] << 8) : descriptor[byte];
+}
+
+// Nearest and second nearest distance seen so far, ties in favour of the lower train index
+struct NearestTwo {
+	int bestDistance = INT_MAX;
+	int secondDistance = INT_MAX;
+	int bestIdx = -1;
+
+	void insert(int distance, int idx) {
+		if (distance < bestDistance || (distance == bestDistance && idx < bestIdx)) {
+			secondDistance = bestDistance;
+			bestDistance = distance;
+			bestIdx = idx;
+		} else if (distance < secondDistance) {
+			secondDistance = distance;
+		}
+	}
+};
+
+// No. of buckets probed over all tables at substring radius s = 0..substringBits
+std::vector<long> probesPerRadius(const MultiIndexHash &index) {
+	std::vector<long> probes(index.substringBits + 1, 0);
+	for (int bits : index.tableBits) {
+		long masks = 1;	 // binomial coefficient (bits choose s)
+		for (int s = 0; s <= bits; ++s) {
+			probes[s] += masks;
+			masks = masks * (bits - s) / (s + 1);
+		}
+	}
+	return probes;
+}
+
+/* Nearest neighbours of a single query. seen[i] == stamp marks the indexed descriptors whose distance has already been
+ * computed for this query (a descriptor is found in several tables). If the search stops before the second neighbour
+ * is known, secondDistance is set to a lower bound which decides the ratio test the same way as the exact value.
+ */
+NearestTwo searchNearest(const uchar *query, const MultiIndexHash &index, const std::vector<long> &probes,
+						 double maxRatio, int maxRadius, std::vector<int> &seen, int stamp) {
+	const cv::Mat &descriptors = index.descriptors;
+	int numBytes = descriptors.cols;
+	int numTables = static_cast<int>(index.tableBits.size());
+	NearestTwo nearest;
+	long work = 0;	// cost of the probed buckets and the computed distances
+	auto visit = [&](int idx) {
+		if (seen[idx] == stamp) {
+			return;
+		}
+		seen[idx] = stamp;
+		int distance = cv::hal::normHamming(query, descriptors.ptr<uchar>(idx), numBytes);
+		if (maxRadius <= 0 || distance <= maxRadius) {
+			nearest.insert(distance, idx);
+		}
+		++work;
+	};
+
+	for (int s = 0; s <= index.substringBits; ++s) {
+		if (work + kProbeCost * probes[s] > descriptors.rows) {
+			break;	// probing the next radius costs more than scanning all descriptors
+		}
+		work += kProbeCost * probes[s];
+		for (int t = 0; t < numTables; ++t) {
+			int bits = index.tableBits[t];
+			if (s > bits) {
+				continue;
+			}
+			int key = substringKey(query, t, index.substringBits, numBytes);
+			const std::vector<int> &bucketStart = index.bucketStart[t];
+			const std::vector<int> &bucketIds = index.bucketIds[t];
+			// all masks with s bits set (Gosper's hack), s = 0 probes the bucket of the query itself
+			unsigned mask = (1u << s) - 1u;
+			while (mask < (1u << bits)) {
+				int bucket = key ^ static_cast<int>(mask);
+				for (int b = bucketStart[bucket]; b < bucketStart[bucket + 1]; ++b) {
+					visit(bucketIds[b]);
+				}
+				if (mask == 0) {
+					break;
+				}
+				unsigned lowest = mask & (~mask + 1u);
+				unsigned ripple = mask + lowest;
+				mask = (((ripple ^ mask) >> 2) / lowest) | ripple;
+			}
+		}
+
+		// every descriptor within exactRadius bits of the query has been seen
+		int exactRadius = numTables * (s + 1) - 1;
+		if (maxRadius > 0 && exactRadius >= maxRadius) {
+			nearest.secondDistance = std::min(nearest.secondDistance, maxRadius + 1);
+			return nearest;
+		}
+		if (maxRatio <= 0) {
+			if (nearest.bestDistance <= exactRadius) {
+				return nearest;
+			}
+		} else if (nearest.secondDistance <= exactRadius) {
+			return nearest;
+		} else if (nearest.bestDistance <= exactRadius && nearest.bestDistance >= maxRatio * nearest.secondDistance) {
+			// a second neighbour close enough to fail the ratio test has been seen already
+			return nearest;
+		} else if (nearest.bestDistance <= exactRadius && nearest.bestDistance < maxRatio * (exactRadius + 1)) {
+			// the second neighbour is at least exactRadius + 1 bits away, the ratio test passes in any case
+			nearest.secondDistance = exactRadius + 1;
+			return nearest;
+		}
+	}
+	for (int idx = 0; idx < descriptors.rows; ++idx) {
+		visit(idx);
+	}
+	if (maxRadius > 0) {
+		nearest.secondDistance = std::min(nearest.secondDistance, maxRadius + 1);
+	}
+	return nearest;
+}
+
+}  // namespace
+
+std::shared_ptr<MultiIndexHash> buildMultiIndexHash(const cv::Mat &descriptors, int substringBits) {
+	CV_Assert(descriptors.depth() == CV_8U && descriptors.channels() == 1);
+	if (substringBits != 8 && substringBits != 16) {
+		std::cout << "Multi-index hashing supports 8 or 16 bit substrings! Using 16 bits" << std::endl;
+		substringBits = 16;
+	}
+	std::shared_ptr<MultiIndexHash> index = std::make_shared<MultiIndexHash>();
+	index->descriptors = descriptors;
+	index->substringBits = substringBits;
+	int numBytes = descriptors.cols;
+	int bytesPerTable = substringBits / 8;
+	int numTables = (numBytes + bytesPerTable - 1) / bytesPerTable;
+	index->tableBits.resize(numTables);
+	index->bucketStart.resize(numTables);
+	index->bucketIds.resize(numTables);
+	for (int t = 0; t < numTables; ++t) {
+		index->tableBits[t] = std::min(substringBits, 8 * (numBytes - t * bytesPerTable));
+		// counting sort of the descriptor indices by bucket
+		std::vector<int> &bucketStart = index->bucketStart[t];
+		std::vector<int> &bucketIds = index->bucketIds[t];
+		bucketStart.assign((1 << index->tableBits[t]) + 1, 0);
+		for (int i = 0; i < descriptors.rows; ++i) {
+			++bucketStart[substringKey(descriptors.ptr<uchar>(i), t, substringBits, numBytes) + 1];
+		}
+		for (size_t b = 1; b < bucketStart.size(); ++b) {
+			bucketStart[b] += bucketStart[b - 1];
+		}
+		std::vector<int> bucketFill(bucketStart.begin(), bucketStart.end() - 1);
+		bucketIds.resize(descriptors.rows);
+		for (int i = 0; i < descriptors.rows; ++i) {
+			bucketIds[bucketFill[substringKey(descriptors.ptr<uchar>(i), t, substringBits, numBytes)]++] = i;
+		}
+	}
+	return index;
+}
+
+void matchMultiIndexHash(const cv::Mat &descQuery, const MultiIndexHash &index, std::vector<cv::DMatch> &matches,
+						 double maxRatio, int maxRadius) {
+	CV_Assert(descQuery.depth() == CV_8U && descQuery.cols == index.descriptors.cols);
+	if (index.descriptors.rows == 0 || (maxRatio > 0 && maxRadius <= 0 && index.descriptors.rows < 2)) {
+		return;	 // the ratio test needs a second neighbour, as in matchHamming
+	}
+	std::vector<long> probes = probesPerRadius(index);
+	std::vector<NearestTwo> nearest(descQuery.rows);
+	int numBlocks = (descQuery.rows + kQueryBlockSize - 1) / kQueryBlockSize;
+	cv::parallel_for_(cv::Range(0, numBlocks), [&](const cv::Range &blocks) {
+		std::vector<int> seen(index.descriptors.rows, -1);
+		for (int q = blocks.start * kQueryBlockSize; q < std::min(blocks.end * kQueryBlockSize, descQuery.rows); ++q) {
+			nearest[q] = searchNearest(descQuery.ptr<uchar>(q), index, probes, maxRatio, maxRadius, seen, q);
+		}
+	});
+
+	for (int q = 0; q < descQuery.rows; ++q) {
+		const NearestTwo &result = nearest[q];
+		if (result.bestIdx < 0) {
+			continue;
+		}
+		if (maxRatio <= 0 ||
+			(result.secondDistance != INT_MAX && result.bestDistance < maxRatio * result.secondDistance)) {
+			matches.push_back(cv::DMatch(q, result.bestIdx, 0, static_cast<float>(result.bestDistance)));
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef MULTI_INDEX_HASH_H_
+#define MULTI_INDEX_HASH_H_
+
+#include <memory>
+#include <opencv2/core.hpp>
+#include <vector>
+
+/* Multi-index hashing (MIH) for exact Hamming nearest neighbour search over binary descriptors (CV_8U).
+ *
+ * The descriptors are split into m disjoint substrings of substringBits bits (8 or 16) and every substring position is
+ * indexed in its own hash table (direct addressing with 2^substringBits buckets). If two descriptors differ in at most
+ * m * (s + 1) - 1 bits, at least one of their substrings differs in at most s bits (pigeonhole principle). A query
+ * therefore probes the buckets within substring radius s = 0, 1, 2, ... of every table; after radius s all descriptors
+ * within Hamming distance m * (s + 1) - 1 have been seen and the search stops as soon as the neighbours found so far
+ * are provably the nearest ones. If probing the next radius would cost more than scanning all indexed descriptors, the
+ * query is finished with a linear scan instead, hence a query without close neighbours costs at most about twice as
+ * much as brute force while a query with a close neighbour only touches a few buckets.
+ */
+struct MultiIndexHash {
+	cv::Mat descriptors;  // indexed descriptors (shares the data of the frame descriptors)
+	int substringBits = 16;
+	std::vector<int> tableBits;	 // no. of bits of each substring (the last one may be shorter)
+	// per table: the descriptors hashed to bucket b are bucketIds[bucketStart[b]..bucketStart[b + 1])
+	std::vector<std::vector<int>> bucketStart;
+	std::vector<std::vector<int>> bucketIds;
+};
+
+std::shared_ptr<MultiIndexHash> buildMultiIndexHash(const cv::Mat &descriptors, int substringBits);
+
+/* Same interface and results as matchHamming (hammingMatcher.h): nearest neighbour with the distance ratio test for
+ * maxRatio > 0, plain nearest neighbour otherwise, ties in favour of the lower train index.
+ * With maxRadius > 0 the search is a radius search: descriptors farther than maxRadius bits are never matched and a
+ * missing second neighbour is assumed at maxRadius + 1 bits for the ratio test. maxRadius = 0 gives exact results.
+ */
+void matchMultiIndexHash(const cv::Mat &descQuery, const MultiIndexHash &index, std::vector<cv::DMatch> &matches,
+						 double maxRatio = 0.8, int maxRadius = 0);
+
+#endif /* MULTI_INDEX_HASH_H_ */
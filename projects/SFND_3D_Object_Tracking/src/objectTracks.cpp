@@ -0,0 +1,68 @@
+#include <iostream>
+
+#include "cameraFusion.h"
+#include "objectTracks.h"
+
+void updateObjectTracks(TrackManager &manager, DataFrame &prevFrame, DataFrame &currFrame) {
+	if (manager.numFrames == 0) {
+		// the previous frame is the first frame, each of its boxes starts a track
+		for (auto &box : prevFrame.boundingBoxes) {
+			ObjectTrack track;
+			track.trackID = manager.nextTrackID++;
+			track.boxID = box.boxID;
+			box.trackID = track.trackID;
+			manager.tracks[track.trackID] = track;
+		}
+		manager.numFrames = 1;
+	}
+	int frame = manager.numFrames;
+
+	std::vector<int> prevIndexByID = indexBoundingBoxesByID(prevFrame.boundingBoxes);
+	std::map<int, int> prevOfCurr;	// previous box ID of each matched current box ID
+	for (const auto &match : currFrame.bbMatches) {
+		prevOfCurr[match.second] = match.first;
+	}
+	std::map<int, ObjectTrack> tracks;
+	int numContinued = 0, numStarted = 0;
+	for (auto &box : currFrame.boundingBoxes) {
+		auto prev = prevOfCurr.find(box.boxID);
+		BoundingBox *prevBox = nullptr;
+		if (prev != prevOfCurr.end()) {
+			prevBox = findBoundingBoxByID(prevFrame.boundingBoxes, prevIndexByID, prev->second);
+		}
+		auto prevTrack = prevBox ? manager.tracks.find(prevBox->trackID) : manager.tracks.end();
+		// a track is continued by one box only, even if the box matches are not one-to-one
+		if (prevTrack != manager.tracks.end() && tracks.count(prevTrack->first) == 0) {
+			ObjectTrack &track = tracks[prevTrack->first];
+			track = prevTrack->second;
+			track.boxID = box.boxID;
+			box.trackID = track.trackID;
+			++numContinued;
+		} else {
+			ObjectTrack &track = tracks[manager.nextTrackID];
+			track.trackID = manager.nextTrackID++;
+			track.boxID = box.boxID;
+			box.trackID = track.trackID;
+			++numStarted;
+		}
+	}
+	int numEnded = static_cast<int>(manager.tracks.size()) - numContinued;
+	manager.tracks.swap(tracks);
+	manager.numFrames = frame + 1;
+
+	std::cout << "  >>> Object tracks: " << manager.tracks.size() << " (" << numContinued << " continued, "
+			  << numStarted << " started, " << numEnded << " ended)" << std::endl;
+}
+
+ObjectTrack *findObjectTrack(TrackManager &manager, const BoundingBox &box) {
+	auto it = manager.tracks.find(box.trackID);
+	return it != manager.tracks.end() ? &it->second : nullptr;
+}
+
+TrackCache previousTrackCache(const TrackManager &manager, const ObjectTrack *track) {
+	// the previous frame is numFrames - 2
+	if (!track || track->cache.frame != manager.numFrames - 2) {
+		return TrackCache();
+	}
+	return track->cache;
+}
@@ -0,0 +1,52 @@
+#ifndef OBJECT_TRACKS_H_
+#define OBJECT_TRACKS_H_
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "dataStructures.h"
+
+/* Persistent object tracks over the bounding box matches of consecutive frames, with a cache of the quantities derived
+ * from the box of a track.
+ *
+ * Every box of the first frame starts a track. A current frame box continues the track of the previous frame box it
+ * is matched to (bbMatches) and starts a new track otherwise; BoundingBox::trackID is set accordingly, so a track ID
+ * follows an object as long as its box is matched from frame to frame. A track ends with the first frame its box is
+ * not matched in.
+ * The cache holds the robust Lidar distance evalTTC derives from the box of a track in a frame as soon as it is first
+ * computed. When the box is the previous box of the next frame pair, the distance is reused instead of recomputed for
+ * the Lidar TTC. The TTC filter (ttcFilter.h) and the TTC scheduler (ttcScheduler.h) keep their state by track ID.
+ */
+struct TrackCache {	 // quantities derived from the box of a track in one frame, NaN / -1: not computed
+	int frame = -1;
+	double lidarMedianX = NAN;	// median x of the Lidar points [m]
+	double lidarMeanX = NAN;	// mean x of the Lidar points [m]
+};
+
+struct ObjectTrack {
+	int trackID = -1;
+	int boxID = -1;		// box of the latest frame
+	TrackCache cache;	// of the latest box evaluated
+};
+
+struct TrackManager {
+	int numFrames = 0;	// frames added so far, the latest frame is numFrames - 1
+	int nextTrackID = 0;
+	std::map<int, ObjectTrack> tracks;	// tracks of the latest frame, by track ID
+
+	// statistics over all frames: previous box distances taken from the cache / computed
+	long numCacheHits = 0;
+	long numCacheMisses = 0;
+};
+
+// Assign the track IDs of the current frame boxes from the box matches (currFrame.bbMatches)
+void updateObjectTracks(TrackManager &manager, DataFrame &prevFrame, DataFrame &currFrame);
+
+// Track of a box of the latest frame, nullptr if there is none
+ObjectTrack *findObjectTrack(TrackManager &manager, const BoundingBox &box);
+
+// Cache of a track for its box of the previous frame, an empty cache if it has not been computed then
+TrackCache previousTrackCache(const TrackManager &manager, const ObjectTrack *track);
+
+#endif /* OBJECT_TRACKS_H_ */
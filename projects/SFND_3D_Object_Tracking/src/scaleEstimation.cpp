@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "scaleEstimation.h"
+
+namespace {
+
+const unsigned kSamplingSeed = 42;
+const int kMaxRefinements = 5;
+// degenerate minimal samples are redrawn, at most this many draws per hypothesis budget
+const int kMaxDrawsPerIteration = 10;
+
+struct Similarity {
+	double scale, tx, ty;
+};
+
+// Squared residuals of all matches under the model; plain loop over the arrays, vectorized by the compiler
+void squaredResiduals(const MatchedKeypoints &points, const Similarity &model, std::vector<float> &residuals) {
+	size_t n = points.xPrev.size();
+	float scale = static_cast<float>(model.scale), tx = static_cast<float>(model.tx), ty = static_cast<float>(model.ty);
+	const float *xPrev = points.xPrev.data(), *yPrev = points.yPrev.data();
+	const float *xCurr = points.xCurr.data(), *yCurr = points.yCurr.data();
+	float *r = residuals.data();
+	for (size_t k = 0; k < n; ++k) {
+		float dx = xCurr[k] - (scale * xPrev[k] + tx);
+		float dy = yCurr[k] - (scale * yPrev[k] + ty);
+		r[k] = dx * dx + dy * dy;
+	}
+}
+
+int countBelow(const std::vector<float> &residuals, float maxResidual) {
+	int count = 0;
+	for (float r : residuals) {
+		count += r <= maxResidual ? 1 : 0;
+	}
+	return count;
+}
+
+/* Least squares similarity (scale + translation) of the matches with a squared residual of at most maxResidual.
+ * Returns false for fewer than two distinct keypoints.
+ */
+bool fitSimilarity(const MatchedKeypoints &points, const std::vector<float> &residuals, float maxResidual,
+				   Similarity &model) {
+	size_t n = points.xPrev.size();
+	double sumXPrev = 0, sumYPrev = 0, sumXCurr = 0, sumYCurr = 0;
+	size_t count = 0;
+	for (size_t k = 0; k < n; ++k) {
+		if (residuals[k] <= maxResidual) {
+			sumXPrev += points.xPrev[k];
+			sumYPrev += points.yPrev[k];
+			sumXCurr += points.xCurr[k];
+			sumYCurr += points.yCurr[k];
+			++count;
+		}
+	}
+	if (count < 2) {
+		return false;
+	}
+	double mxPrev = sumXPrev / count, myPrev = sumYPrev / count, mxCurr = sumXCurr / count, myCurr = sumYCurr / count;
+	double cross = 0, spread = 0;
+	for (size_t k = 0; k < n; ++k) {
+		if (residuals[k] <= maxResidual) {
+			double dxPrev = points.xPrev[k] - mxPrev, dyPrev = points.yPrev[k] - myPrev;
+			cross += dxPrev * (points.xCurr[k] - mxCurr) + dyPrev * (points.yCurr[k] - myCurr);
+			spread += dxPrev * dxPrev + dyPrev * dyPrev;
+		}
+	}
+	if (spread <= 0) {
+		return false;
+	}
+	model.scale = cross / spread;
+	model.tx = mxCurr - model.scale * mxPrev;
+	model.ty = myCurr - model.scale * myPrev;
+	return true;
+}
+
+// Iterations needed to draw an outlier free minimal sample (two matches) with the given confidence
+int requiredIterations(double inlierRatio, double confidence, int maxIterations) {
+	double outlierFree = inlierRatio * inlierRatio;
+	if (outlierFree >= 1) {
+		return 1;
+	}
+	if (outlierFree <= 0) {
+		return maxIterations;
+	}
+	double iterations = std::log(1 - confidence) / std::log(1 - outlierFree);
+	return static_cast<int>(std::min(std::ceil(iterations), static_cast<double>(maxIterations)));
+}
+
+// Squared robust standard deviation of the LMedS residuals (Rousseeuw & Leroy) from their median
+float lmedsSigmaSq(float medianResidual, size_t n) {
+	double sigma = 1.4826 * (1 + 5.0 / std::max<double>(static_cast<double>(n) - 2, 1)) * std::sqrt(medianResidual);
+	return static_cast<float>(sigma * sigma);
+}
+
+}  // namespace
+
+ScaleEstimate estimateScale(const MatchedKeypoints &points, const CameraTtcConf &conf) {
+	ScaleEstimate estimate;
+	int n = static_cast<int>(points.xPrev.size());
+	if (n < 2) {
+		return estimate;
+	}
+	bool lmeds = conf.method == CameraTtcMethod::LMEDS;
+	float minDistSq = conf.minDist * conf.minDist;
+	float maxResidual = conf.inlierThreshold * conf.inlierThreshold;
+	int maxIterations = std::max(conf.maxIterations, 1);
+
+	std::mt19937 rng(kSamplingSeed);
+	std::uniform_int_distribution<int> first(0, n - 1), second(0, n - 2);
+	std::vector<float> residuals(n), sorted(lmeds ? n : 0);
+	// LMedS assumes no inlier ratio, its iterations are fixed by the breakdown point of 50 % outliers
+	int iterations = lmeds ? requiredIterations(0.5, conf.confidence, maxIterations) : maxIterations;
+	Similarity best = {NAN, 0, 0};
+	int bestInliers = 0;
+	float bestMedian = std::numeric_limits<float>::infinity();
+	auto medianResidual = [&]() {
+		sorted = residuals;
+		std::nth_element(sorted.begin(), sorted.begin() + n / 2, sorted.end());
+		return sorted[n / 2];
+	};
+
+	// only valid hypotheses count as iterations, degenerate samples are redrawn up to maxDraws draws in total
+	int iteration = 0;
+	int maxDraws = kMaxDrawsPerIteration * maxIterations;
+	for (int draw = 0; iteration < iterations && draw < maxDraws; ++draw) {
+		// minimal sample: two matches far enough apart for a stable scale
+		int a = first(rng);
+		int b = second(rng);
+		b += b >= a ? 1 : 0;
+		float dxCurr = points.xCurr[b] - points.xCurr[a], dyCurr = points.yCurr[b] - points.yCurr[a];
+		float dxPrev = points.xPrev[b] - points.xPrev[a], dyPrev = points.yPrev[b] - points.yPrev[a];
+		float prevSq = dxPrev * dxPrev + dyPrev * dyPrev;
+		if (dxCurr * dxCurr + dyCurr * dyCurr < minDistSq || prevSq <= 0) {
+			continue;
+		}
+		++iteration;
+		Similarity model;
+		model.scale = (dxCurr * dxPrev + dyCurr * dyPrev) / prevSq;
+		model.tx = (points.xCurr[a] + points.xCurr[b] - model.scale * (points.xPrev[a] + points.xPrev[b])) / 2;
+		model.ty = (points.yCurr[a] + points.yCurr[b] - model.scale * (points.yPrev[a] + points.yPrev[b])) / 2;
+		squaredResiduals(points, model, residuals);
+
+		if (lmeds) {
+			float median = medianResidual();
+			if (median < bestMedian) {
+				best = model;
+				bestMedian = median;
+			}
+			continue;
+		}
+		int numInliers = countBelow(residuals, maxResidual);
+		if (numInliers <= bestInliers) {
+			continue;
+		}
+		// the scale of two noisy keypoints is coarse: refit the new best hypothesis to its inliers (local optimization)
+		Similarity refined;
+		if (conf.refineScale && fitSimilarity(points, residuals, maxResidual, refined)) {
+			squaredResiduals(points, refined, residuals);
+			int numRefined = countBelow(residuals, maxResidual);
+			if (numRefined >= numInliers) {
+				model = refined;
+				numInliers = numRefined;
+			}
+		}
+		best = model;
+		bestInliers = numInliers;
+		// early termination: enough iterations for the inlier ratio of the best hypothesis
+		iterations = std::min(iterations, requiredIterations(static_cast<double>(numInliers) / n, conf.confidence,
+															  maxIterations));
+	}
+	estimate.numIterations = iteration;
+	if (std::isnan(best.scale)) {
+		return estimate;
+	}
+
+	squaredResiduals(points, best, residuals);
+	if (lmeds) {
+		// inliers: within 2.5 robust standard deviations
+		maxResidual = 6.25f * lmedsSigmaSq(bestMedian, n);
+	}
+	if (conf.refineScale) {
+		// least squares on the inliers until the inliers do not change
+		int numInliers = countBelow(residuals, maxResidual);
+		for (int refinement = 0; refinement < kMaxRefinements; ++refinement) {
+			Similarity refined;
+			if (!fitSimilarity(points, residuals, maxResidual, refined)) {
+				break;
+			}
+			best = refined;
+			squaredResiduals(points, best, residuals);
+			if (lmeds) {
+				maxResidual = 6.25f * lmedsSigmaSq(medianResidual(), n);
+			}
+			int numRefined = countBelow(residuals, maxResidual);
+			if (numRefined == numInliers) {
+				break;
+			}
+			numInliers = numRefined;
+		}
+	}
+	estimate.valid = true;
+	estimate.scale = best.scale;
+	estimate.translation = cv::Point2d(best.tx, best.ty);
+	estimate.numInliers = countBelow(residuals, maxResidual);
+	return estimate;
+}
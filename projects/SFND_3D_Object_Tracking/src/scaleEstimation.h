@@ -0,0 +1,33 @@
+#ifndef SCALE_ESTIMATION_H_
+#define SCALE_ESTIMATION_H_
+
+#include "dataStructures.h"
+#include "distanceRatios.h"
+
+/* Robust scale change of the matched keypoints of an object for the camera TTC.
+ *
+ * The current frame keypoints are modelled as a similarity transform without rotation of the previous frame
+ * keypoints, p_curr = scale * p_prev + translation. The scale is the ratio d_curr / d_prev of the keypoint distances
+ * the median of all distance ratios estimates (distanceRatios.h), but it is fitted at O(iterations x N) instead of
+ * O(N^2) pairs. Every hypothesis is fitted to a minimal sample of two matches whose keypoints are at least
+ * conf.minDist apart in the current frame, and scored over all matches; degenerate samples are redrawn (at most
+ * 10 x conf.maxIterations draws) and do not count as iterations:
+ * - RANSAC: no. of matches with a residual of at most conf.inlierThreshold;
+ * - LMedS: median of the squared residuals, no threshold needed (at most 50 % outliers).
+ * RANSAC adapts the no. of iterations to the inlier ratio w of the best hypothesis and stops after
+ * log(1 - conf.confidence) / log(1 - w^2) iterations (at most conf.maxIterations); LMedS assumes w = 0.5. The inliers
+ * of LMedS are the matches within 2.5 robust standard deviations. With conf.refineScale every new best RANSAC
+ * hypothesis and the final model are refitted to their inliers by least squares, the final model until its inliers do
+ * not change. The sampling uses a fixed seed, results are reproducible.
+ */
+struct ScaleEstimate {
+	bool valid = false;  // false if no minimal sample was found
+	double scale = NAN;
+	cv::Point2d translation;
+	int numInliers = 0;
+	int numIterations = 0;  // no. of valid hypotheses
+};
+
+ScaleEstimate estimateScale(const MatchedKeypoints &points, const CameraTtcConf &conf);
+
+#endif /* SCALE_ESTIMATION_H_ */
@@ -3,81 +3,367 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include "cameraFusion.h"
+#include "distanceRatios.h"
 #include "lidarData.h"
+#include "scaleEstimation.h"
 #include "ttc.h"
 #include <algorithm>
+#include <map>
+#include <numeric>
+#include <sstream>
 
-void evalTTC(LidarTtcMethod lidarTtcMethod, KptMatchesClusterConf kptClusterConfig, DataFrame &currFrame,
-			 DataFrame &prevFrame, cv::Mat &P_rect_00, cv::Mat &R_rect_00, cv::Mat &RT, double sensorFrameRate,
-			 bool showKeypointSelected, bool showTTCOnImage) {
-	// loop over all bounding-boxes matched pairs
+namespace {
+
+/* Median (LidarTtcMethod::MEDIAN) or mean (MEAN) x of the Lidar points of a box, from the track cache of the box if it
+ * was computed before, otherwise computed and stored in the cache
+ */
+double cachedLidarDistance(LidarTtcMethod method, std::vector<LidarPoint> &lidarPoints, TrackCache &cache,
+						   bool *fromCache = nullptr) {
+	double &distance = method == LidarTtcMethod::MEAN ? cache.lidarMeanX : cache.lidarMedianX;
+	if (fromCache) {
+		*fromCache = !std::isnan(distance);
+	}
+	if (std::isnan(distance)) {
+		std::vector<double> xComp = extractXcomponent(lidarPoints);
+		distance = method == LidarTtcMethod::MEAN ? computeMean(xComp) : computeMedian(xComp);
+	}
+	return distance;
+}
+
+}  // namespace
+
+void evalTTC(LidarTtcMethod lidarTtcMethod, KptMatchesClusterConf kptClusterConfig, const CameraTtcConf &cameraTtcConf,
+			 DataFrame &currFrame, DataFrame &prevFrame, cv::Mat &P_rect_00, cv::Mat &R_rect_00, cv::Mat &RT,
+			 double sensorFrameRate, bool showKeypointSelected, bool showTTCOnImage, TtcFilter *ttcFilter,
+			 TtcScheduler *ttcScheduler, TrackManager *trackManager, const KeypointTrackStore *trackStore,
+			 int trackTtcBaseline) {
+	double t = (double)cv::getTickCount();
+	// box lookup by ID through dense tables, built once per frame
+	std::vector<int> currIndexByID = indexBoundingBoxesByID(currFrame.boundingBoxes);
+	std::vector<int> prevIndexByID = indexBoundingBoxesByID(prevFrame.boundingBoxes);
+
+	// bounding-boxes matched pairs, in the order of bbMatches; every box is in at most one pair
+	std::vector<BoundingBox *> currBBs, prevBBs;
 	for (auto it1 = currFrame.bbMatches.begin(); it1 != currFrame.bbMatches.end(); ++it1) {
-		// find bounding boxes associates with current match
-		BoundingBox *currBB = findBoundingBoxByID(currFrame.boundingBoxes, it1->second);
-		BoundingBox *prevBB = findBoundingBoxByID(prevFrame.boundingBoxes, it1->first);
+		BoundingBox *currBB = findBoundingBoxByID(currFrame.boundingBoxes, currIndexByID, it1->second);
+		BoundingBox *prevBB = findBoundingBoxByID(prevFrame.boundingBoxes, prevIndexByID, it1->first);
+		if (!currBB || !prevBB) {
+			std::cout << "  >>> Skipping box match " << it1->first << " => " << it1->second << ": no box with this ID"
+					  << std::endl;
+			continue;
+		}
+		currBBs.push_back(currBB);
+		prevBBs.push_back(prevBB);
+	}
+	int numObjects = static_cast<int>(currBBs.size());
+	std::vector<double> ttcLidar(numObjects, 0), ttcCamera(numObjects, NAN), ttcCameraTracks(numObjects, NAN);
+	std::vector<char> evaluated(numObjects, 0);  // not vector<bool>, its elements share bytes
+
+	/* Kalman filtered TTC: the tracks of the matched boxes are predicted to the current frame, converged tracks skip
+	 * the estimators and are only updated with the Lidar distance (see ttcFilter.h)
+	 */
+	std::vector<TtcTrack> tracks(ttcFilter ? numObjects : 0);
+	std::vector<char> skipEstimators(numObjects, 0);
+	std::vector<double> lidarDistance(numObjects, NAN), estimatorTime(numObjects, 0);
+	if (ttcFilter) {
+		for (int i = 0; i < numObjects; ++i) {
+			tracks[i] = predictTtcTrack(*ttcFilter, currBBs[i]->trackID, 1 / sensorFrameRate);
+			skipEstimators[i] = canSkipEstimators(*ttcFilter, tracks[i]);
+		}
+	}
 
-		// compute TTC for current match
-		double ttcLidar = 0;
+	/* Track caches (see objectTracks.h): the cache of the previous box, if it was filled when the box was the current
+	 * box of the last frame pair, and the cache of the current box, filled by the evaluation
+	 */
+	std::vector<ObjectTrack *> objectTracks(trackManager ? numObjects : 0, nullptr);
+	std::vector<TrackCache> prevCaches(objectTracks.size()), currCaches(objectTracks.size());
+	std::vector<char> cacheHit(numObjects, 0), cacheLookup(numObjects, 0);
+	if (trackManager) {
+		for (int i = 0; i < numObjects; ++i) {
+			objectTracks[i] = findObjectTrack(*trackManager, *currBBs[i]);
+			// a track continued by another box than the previous box of the pair has no cache of that box
+			if (objectTracks[i] && prevBBs[i]->trackID == currBBs[i]->trackID) {
+				prevCaches[i] = previousTrackCache(*trackManager, objectTracks[i]);
+			}
+			currCaches[i].frame = trackManager->numFrames - 1;
+		}
+	}
+
+	auto evalObject = [&](int i, std::ostream &log) {
+		BoundingBox *currBB = currBBs[i], *prevBB = prevBBs[i];
 		// only compute TTC if we have Lidar points otherwise it defaults to 0
 		if (currBB->lidarPoints.size() > 0 && prevBB->lidarPoints.size() > 0) {
+			evaluated[i] = 1;
+			if (ttcFilter) {
+				// distance measurement of the filter, a median of the Lidar points only
+				if (trackManager) {
+					lidarDistance[i] = cachedLidarDistance(LidarTtcMethod::MEDIAN, currBB->lidarPoints, currCaches[i]);
+				} else {
+					std::vector<double> xCompCurr = extractXcomponent(currBB->lidarPoints);
+					lidarDistance[i] = computeMedian(xCompCurr);
+				}
+			}
+			if (skipEstimators[i]) {
+				return;
+			}
+			double tEstimators = (double)cv::getTickCount();
 			// Assignment Task-2 -> compute time-to-collision based on Lidar data
-			ttcLidar = computeTTCLidar(lidarTtcMethod, prevBB->lidarPoints, currBB->lidarPoints, sensorFrameRate);
+			if (trackManager && lidarTtcMethod != LidarTtcMethod::CLUSTER_EUCLID) {
+				// the distance of the previous box is taken from its track cache if it was computed in the last frame
+				bool fromCache;
+				double distance0 = cachedLidarDistance(lidarTtcMethod, prevBB->lidarPoints, prevCaches[i], &fromCache);
+				double distance1 = cachedLidarDistance(lidarTtcMethod, currBB->lidarPoints, currCaches[i]);
+				ttcLidar[i] = computeTTCLidarFromDistances(distance0, distance1, sensorFrameRate, log);
+				cacheLookup[i] = 1;
+				cacheHit[i] = fromCache;
+			} else {
+				ttcLidar[i] =
+					computeTTCLidar(lidarTtcMethod, prevBB->lidarPoints, currBB->lidarPoints, sensorFrameRate, log);
+			}
 			// Assignment Task-3 -> assign enclosed keypoint matches to bounding box
 			clusterKptMatchesWithROI(kptClusterConfig, currFrame.kptMatches, prevFrame, currFrame, *prevBB, *currBB,
-									 showKeypointSelected);
+									 showKeypointSelected, log);
 
 			// TASK FP.4 -> compute time-to-collision based on camera (implement -> computeTTCCamera)
-			double ttcCamera =
-				computeTTCCamera(prevFrame.keypoints, currFrame.keypoints, currBB->kptMatches, sensorFrameRate);
-			if (showTTCOnImage) {
-				cv::Mat visImg = currFrame.cameraImg.clone();
-				showLidarImgOverlay(visImg, currBB->lidarPoints, P_rect_00, R_rect_00, RT, &visImg);
-				cv::rectangle(visImg, cv::Point(currBB->roi.x, currBB->roi.y),
-							  cv::Point(currBB->roi.x + currBB->roi.width, currBB->roi.y + currBB->roi.height),
-							  cv::Scalar(0, 255, 0), 2);
+			ttcCamera[i] = computeTTCCamera(prevFrame.keypoints, currFrame.keypoints, currBB->kptMatches,
+											sensorFrameRate, cameraTtcConf, nullptr, log);
+			if (trackStore) {
+				// longer baseline from the keypoint tracks of the box matches
+				ttcCameraTracks[i] = computeTTCCameraTracks(*trackStore, currBB->kptMatches, trackTtcBaseline,
+															 sensorFrameRate, cameraTtcConf, log);
+			}
+			estimatorTime[i] = ((double)cv::getTickCount() - tEstimators) / cv::getTickFrequency();
+		}
+	};
 
-				char str[200];
-				sprintf(str, "TTC Lidar : %f s, TTC Camera : %f s", ttcLidar, ttcCamera);
-				putText(visImg, str, cv::Point2f(80, 50), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255));
+	/* The objects are independent (each writes only the keypoint matches of its own current box) and are evaluated in
+	 * parallel; their output is buffered and printed in the order of bbMatches. Windows can only be opened from the
+	 * main thread, hence the keypoint selection is shown with serial evaluation only.
+	 */
+	std::vector<std::string> logs(numObjects);
+	auto evalObjects = [&](const std::vector<int> &objects, int begin, int end) {
+		if (showKeypointSelected) {
+			for (int k = begin; k < end; ++k) {
+				evalObject(objects[k], std::cout);
+			}
+			return;
+		}
+		cv::parallel_for_(cv::Range(begin, end), [&](const cv::Range &range) {
+			for (int k = range.start; k < range.end; ++k) {
+				std::ostringstream log;
+				evalObject(objects[k], log);
+				logs[objects[k]] = log.str();
+			}
+		});
+	};
+	std::vector<char> deferred(numObjects, 0);
+	TtcSchedule schedule;
+	int numScheduled = 0;
+	if (!ttcScheduler) {
+		std::vector<int> objects(numObjects);
+		std::iota(objects.begin(), objects.end(), 0);
+		evalObjects(objects, 0, numObjects);
+	} else {
+		/* Priority order within the time budget (see ttcScheduler.h): the forced objects first, then one object per
+		 * thread at a time while the elapsed time plus the expected time of such a wave fits into the budget
+		 */
+		schedule = planTtcSchedule(*ttcScheduler, currBBs, prevBBs);
+		const std::vector<int> &order = schedule.order;
+		int numOrdered = static_cast<int>(order.size());
+		int waveSize = showKeypointSelected ? 1 : std::max(cv::getNumThreads(), 1);
+		auto evalWaves = [&](int begin, int end) {
+			double tWaves = (double)cv::getTickCount();
+			evalObjects(order, begin, end);
+			tWaves = ((double)cv::getTickCount() - tWaves) / cv::getTickFrequency();
+			// the expected wave time is that of running the estimators, objects that skip them do not count
+			int numEstimated = 0;
+			for (int k = begin; k < end; ++k) {
+				numEstimated += skipEstimators[order[k]] ? 0 : 1;
+			}
+			if (numEstimated == 0) {
+				return;
+			}
+			double waveTime = tWaves / ((numEstimated + waveSize - 1) / waveSize);
+			ttcScheduler->waveTime = ttcScheduler->waveTime > 0 ? 0.8 * ttcScheduler->waveTime + 0.2 * waveTime
+																: waveTime;
+		};
+		if (schedule.numForced > 0) {
+			evalWaves(0, schedule.numForced);
+		}
+		numScheduled = schedule.numForced;
+		while (numScheduled < numOrdered) {
+			double elapsed = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+			if (elapsed + ttcScheduler->waveTime > ttcScheduler->conf.timeBudget) {
+				break;
+			}
+			int end = std::min(numScheduled + waveSize, numOrdered);
+			evalWaves(numScheduled, end);
+			numScheduled = end;
+		}
+		for (int k = numScheduled; k < numOrdered; ++k) {
+			deferred[order[k]] = 1;
+		}
+	}
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
 
-				std::string windowName = "opencv: Final Results-TTC";
-				cv::namedWindow(windowName, 4);
-				cv::imshow(windowName, visImg);
-				std::cout << "Press ESC key to continue to next frame" << std::endl;
-				while ((cv::waitKey() & 0xEFFFFF) != 27) {
-					continue;
-				}  // wait for keyboard input before continuing
+	std::map<int, TtcTrack> currTracks;	 // tracks continued into the current frame, by track ID
+	int numSkipped = 0;
+	std::vector<double> ttcPublished(numObjects, NAN);  // filtered TTC if available, else Lidar TTC
+	for (int i = 0; i < numObjects; ++i) {
+		std::cout << logs[i];
+		double ttcFiltered = NAN;
+		if (ttcFilter) {
+			TtcTrack &track = tracks[i];
+			if (evaluated[i]) {
+				updateTtcTrackLidar(track, ttcFilter->conf, lidarDistance[i]);
+				if (!skipEstimators[i]) {
+					updateTtcTrackCamera(track, ttcFilter->conf, ttcCamera[i]);
+				}
+			}
+			track.skippedFrames = evaluated[i] && skipEstimators[i] ? track.skippedFrames + 1 : 0;
+			if (track.age > 0) {
+				currTracks[currBBs[i]->trackID] = track;
+				ttcFiltered = ttcOfTrack(track);
 			}
 		}
+		ttcPublished[i] = std::isnan(ttcFiltered) ? ttcLidar[i] : ttcFiltered;
+		if (!evaluated[i] && !deferred[i]) {
+			continue;
+		}
+		BoundingBox *currBB = currBBs[i];
+		if (deferred[i]) {
+			// lazy evaluation: publish the TTC of the last evaluation
+			ttcLidar[i] = schedule.last[i].ttcLidar;
+			ttcCamera[i] = schedule.last[i].ttcCamera;
+			std::cout << "  >>> TTC Lidar: " << ttcLidar[i] << " s, TTC Camera: " << ttcCamera[i] << " s (deferred, ";
+			if (schedule.last[i].evaluated) {
+				std::cout << "last evaluated " << schedule.last[i].deferredFrames + 1 << " frames ago)";
+			} else {
+				std::cout << "not evaluated yet)";
+			}
+		} else if (skipEstimators[i]) {
+			++numSkipped;
+			std::cout << "  >>> TTC Lidar / Camera: skipped (converged track)";
+		} else {
+			if (ttcFilter) {
+				++ttcFilter->numEvaluations;
+			}
+			std::cout << "  >>> TTC Lidar: " << ttcLidar[i] << " s, TTC Camera: " << ttcCamera[i] << " s";
+			if (trackStore) {
+				std::cout << ", TTC Camera " << trackTtcBaseline << " frames: " << ttcCameraTracks[i] << " s";
+			}
+		}
+		if (ttcFilter) {
+			double invTtcStd;
+			ttcOfTrack(tracks[i], &invTtcStd);
+			std::cout << ", TTC Filter: " << ttcFiltered << " s (1/TTC std " << invTtcStd << " 1/s, "
+					  << tracks[i].age << " updates)";
+		}
+		std::cout << std::endl;
+		if (showTTCOnImage) {
+			cv::Mat visImg = currFrame.cameraImg.clone();
+			showLidarImgOverlay(visImg, currBB->lidarPoints, P_rect_00, R_rect_00, RT, &visImg);
+			cv::rectangle(visImg, cv::Point(currBB->roi.x, currBB->roi.y),
+						  cv::Point(currBB->roi.x + currBB->roi.width, currBB->roi.y + currBB->roi.height),
+						  cv::Scalar(0, 255, 0), 2);
+
+			char str[200];
+			sprintf(str, "TTC Lidar : %f s, TTC Camera : %f s", ttcLidar[i], ttcCamera[i]);
+			putText(visImg, str, cv::Point2f(80, 50), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255));
+			if (ttcFilter) {
+				sprintf(str, "TTC Filter : %f s", ttcFiltered);
+				putText(visImg, str, cv::Point2f(80, 80), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255));
+			}
+
+			std::string windowName = "opencv: Final Results-TTC";
+			cv::namedWindow(windowName, 4);
+			cv::imshow(windowName, visImg);
+			std::cout << "Press ESC key to continue to next frame" << std::endl;
+			while ((cv::waitKey() & 0xEFFFFF) != 27) {
+				continue;
+			}  // wait for keyboard input before continuing
+		}
+	}
+	std::cout << "  >>> TTC of " << numObjects << " objects in " << 1000 * t / 1.0 << " ms ("
+			  << (showKeypointSelected ? 1 : cv::getNumThreads()) << " threads)" << std::endl;
+
+	if (ttcFilter) {
+		ttcFilter->tracks.swap(currTracks);
+		ttcFilter->numSkipped += numSkipped;
+		for (int i = 0; i < numObjects; ++i) {
+			ttcFilter->estimatorTime += estimatorTime[i];
+		}
+		// saved: the skipped evaluations at the mean time of the evaluations run so far
+		double meanTime = ttcFilter->numEvaluations > 0 ? ttcFilter->estimatorTime / ttcFilter->numEvaluations : 0;
+		long numTotal = ttcFilter->numEvaluations + ttcFilter->numSkipped;
+		std::cout << "  >>> TTC filter: " << ttcFilter->tracks.size() << " tracks, estimators skipped for "
+				  << numSkipped << " objects; total " << ttcFilter->numSkipped << " of " << numTotal
+				  << " skipped, estimators " << 1000 * ttcFilter->estimatorTime / 1.0 << " ms, saved ~"
+				  << 1000 * meanTime * ttcFilter->numSkipped / 1.0 << " ms" << std::endl;
+	}
+
+	if (trackManager) {
+		// the caches of the boxes evaluated in this frame, for their evaluation as previous boxes in the next frame
+		int numHits = 0, numLookups = 0;
+		for (int i = 0; i < numObjects; ++i) {
+			if (objectTracks[i] && evaluated[i]) {
+				objectTracks[i]->cache = currCaches[i];
+			}
+			numHits += cacheHit[i];
+			numLookups += cacheLookup[i];
+		}
+		trackManager->numCacheHits += numHits;
+		trackManager->numCacheMisses += numLookups - numHits;
+		std::cout << "  >>> Track cache: previous Lidar distance reused for " << numHits << " of " << numLookups
+				  << " objects; tracks:";
+		for (int i = 0; i < numObjects; ++i) {
+			std::cout << " " << currBBs[i]->boxID << "->" << currBBs[i]->trackID;
+		}
+		std::cout << " (box->track); total " << trackManager->numCacheHits << " of "
+				  << trackManager->numCacheHits + trackManager->numCacheMisses << " reused" << std::endl;
+	}
+
+	if (ttcScheduler) {
+		updateTtcScheduler(*ttcScheduler, schedule, currBBs, evaluated, skipEstimators, deferred, ttcLidar, ttcCamera,
+						   ttcPublished);
+		std::cout << "  >>> TTC schedule: " << numScheduled << " of " << schedule.order.size() << " objects evaluated ("
+				  << schedule.numForced << " forced) within " << 1000 * ttcScheduler->conf.timeBudget / 1.0
+				  << " ms; ego lane boxes:";
+		for (int i = 0; i < numObjects; ++i) {
+			std::cout << (schedule.egoLane[i] ? " " + std::to_string(currBBs[i]->boxID) : "");
+		}
+		std::cout << "; deferred boxes:";
+		for (int i = 0; i < numObjects; ++i) {
+			std::cout << (deferred[i] ? " " + std::to_string(currBBs[i]->boxID) : "");
+		}
+		std::cout << "; total " << ttcScheduler->numDeferred << " of "
+				  << ttcScheduler->numEvaluated + ttcScheduler->numDeferred << " deferred" << std::endl;
 	}
 }
 
 double computeTTCLidar(LidarTtcMethod ttcMethod, std::vector<LidarPoint> &lidarPointsPrev,
-					   std::vector<LidarPoint> &lidarPointsCurr, double lidarFrameRate) {
+					   std::vector<LidarPoint> &lidarPointsCurr, double lidarFrameRate, std::ostream &log) {
 	std::vector<double> xCompPrev = extractXcomponent(lidarPointsPrev);
 	std::vector<double> xCompCurr = extractXcomponent(lidarPointsCurr);
 
 	switch (ttcMethod) {
 		case LidarTtcMethod::MEAN:
-			return computeTTCLidarMeanBased(xCompPrev, xCompCurr, lidarFrameRate);
+			return computeTTCLidarMeanBased(xCompPrev, xCompCurr, lidarFrameRate, log);
 			break;
 		case LidarTtcMethod::CLUSTER_EUCLID:
-			return computeTTCLidarClusterBased(lidarPointsPrev, lidarPointsCurr, lidarFrameRate);
+			return computeTTCLidarClusterBased(lidarPointsPrev, lidarPointsCurr, lidarFrameRate, log);
 			break;
 		case LidarTtcMethod::MEDIAN:
 		default:
-			return computeTTCLidarMedianBased(xCompPrev, xCompCurr, lidarFrameRate);
+			return computeTTCLidarMedianBased(xCompPrev, xCompCurr, lidarFrameRate, log);
 	}
 }
 
-double computeTTCLidarMedianBased(std::vector<double> &xLidarPrev, std::vector<double> &xLidarCurr,
-								  double lidarFrameRate) {
-	double distance0 = computeMedian(xLidarPrev);
-	double distance1 = computeMedian(xLidarCurr);
+double computeTTCLidarFromDistances(double distance0, double distance1, double lidarFrameRate, std::ostream &log) {
 	// Some info output
-	std::cout << "  >>> Lidar TTC: estimated distance to preceeding vehicle: " << std::endl;
-	std::cout << "  >>> previous frame: " << distance0 << std::endl;
-	std::cout << "  >>> current  frame: " << distance1 << std::endl;
+	log << "  >>> Lidar TTC: estimated distance to preceeding vehicle: " << std::endl;
+	log << "  >>> previous frame: " << distance0 << std::endl;
+	log << "  >>> current  frame: " << distance1 << std::endl;
 
 	// Commpute TTC using the constant-velocity model
 	// TTC = d1 * delta_T / (d0 - d1)
@@ -88,71 +374,97 @@ double computeTTCLidarMedianBased(std::vector<double> &xLidarPrev, std::vector<d
 	return ttc;
 }
 
+double computeTTCLidarMedianBased(std::vector<double> &xLidarPrev, std::vector<double> &xLidarCurr,
+								  double lidarFrameRate, std::ostream &log) {
+	return computeTTCLidarFromDistances(computeMedian(xLidarPrev), computeMedian(xLidarCurr), lidarFrameRate, log);
+}
+
 double computeTTCLidarMeanBased(std::vector<double> &xLidarPrev, std::vector<double> &xLidarCurr,
-								double lidarFrameRate) {
-	double distance0 = computeMean(xLidarPrev);
-	double distance1 = computeMean(xLidarCurr);
+								double lidarFrameRate, std::ostream &log) {
+	return computeTTCLidarFromDistances(computeMean(xLidarPrev), computeMean(xLidarCurr), lidarFrameRate, log);
+}
 
-	// Commpute TTC using the constant-velocity model
-	// TTC = d1 * delta_T / (d0 - d1)
-	// where d0 and d1 are the distance to the detected front object in
-	// the previous and the current frame respectively
-	// and  delta_T is 1/lidarFrameRate in our case.
-	double ttc = distance1 / (lidarFrameRate * (distance0 - distance1));
+double computeTTCLidarClusterBased(std::vector<LidarPoint> &lidarPointsPrev, std::vector<LidarPoint> &lidarPointsCurr,
+								   double frameRate, std::ostream &log) {
+	log << "Cluster Based TTC computation not implemented!" << std::endl;
+	return 0.0;
+}
 
-	// Some info output
-	std::cout << "  >>> Lidar TTC: estimated distance to preceeding vehicle: " << std::endl;
-	std::cout << "  >>> previous frame: " << distance0 << std::endl;
-	std::cout << "  >>> current  frame: " << distance1 << std::endl;
+namespace {
 
+// Camera TTC from the scale of a similarity transform fitted to the keypoint matches (RANSAC / LMedS)
+double computeTTCCameraScale(const MatchedKeypoints &points, double frameRate, const CameraTtcConf &conf,
+							 std::ostream &log) {
+	const char *methodName = conf.method == CameraTtcMethod::LMEDS ? "LMedS" : "RANSAC";
+	double t = (double)cv::getTickCount();
+	ScaleEstimate estimate = estimateScale(points, conf);
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+	if (!estimate.valid) {
+		return NAN;
+	}
+	double ttc = 1 / (frameRate * (estimate.scale - 1));
+
+	log << "  >>> Camera TTC: scale d_curr/d_prev of a similarity transform (" << methodName << ")" << std::endl;
+	log << "	>>> scale: " << estimate.scale << " (" << estimate.numInliers << " of " << points.xPrev.size()
+		<< " matches inliers, " << estimate.numIterations << " iterations) in " << 1000 * t / 1.0 << " ms" << std::endl;
+
+	if (conf.evalAccuracy) {
+		// reference: the median distance ratio of all unique pairs
+		double tRatios = (double)cv::getTickCount();
+		std::vector<float> distRatios;
+		allPairRatios(points, conf.minDist, distRatios);
+		double ratio = medianRatio(distRatios);
+		tRatios = ((double)cv::getTickCount() - tRatios) / cv::getTickFrequency();
+		double ttcRatios = 1 / (frameRate * (ratio - 1));
+		log << "  >>> Camera TTC agreement: " << methodName << " " << ttc << " s (" << 1000 * t / 1.0
+			<< " ms), distance ratios " << ttcRatios << " s (" << 1000 * tRatios / 1.0 << " ms), deviation "
+			<< 100 * (ttc - ttcRatios) / ttcRatios << " %" << std::endl;
+	}
 	return ttc;
 }
 
-double computeTTCLidarClusterBased(std::vector<LidarPoint> &lidarPointsPrev, std::vector<LidarPoint> &lidarPointsCurr,
-								   double frameRate) {
-	std::cout << "Cluster Based TTC computation not implemented!" << std::endl;
-	return 0.0;
-}
+}  // namespace
 
 // Compute time-to-collision (TTC) based on keypoint correspondences in successive images
-double computeTTCCamera(std::vector<cv::KeyPoint> &kptsPrev, std::vector<cv::KeyPoint> &kptsCurr,
-						std::vector<cv::DMatch> kptMatches, double frameRate, cv::Mat *visImg) {
+double computeTTCCamera(const std::vector<cv::KeyPoint> &kptsPrev, const std::vector<cv::KeyPoint> &kptsCurr,
+						const std::vector<cv::DMatch> &kptMatches, double frameRate, const CameraTtcConf &conf,
+						cv::Mat *visImg, std::ostream &log) {
 	/* As explained in Lesson 3 - Engineering a Collision Detection System
 	 * given the currnet frame, we compute all distances between all keypoint combinations, let these be h_curr^i
 	 * the same is done for the previous frame for the matched keypoints, let these be h_prev_i
 	 * Then, given the geometrical properties of the camera, the ratio h_prev^i/h_curr^i is directly proportional
 	 * to the inverse ratio of distances (i.e. d_curr^i/d_prev^i) between the matched keypoints
 	 */
-	// compute distance ratios between all matched keypoints
-	std::vector<double> distRatios;  // stores the distance ratios for all keypoints between curr. and prev. frame
-	double minDist = 100.0;			 // min. required distance
-	for (auto it1 = kptMatches.begin(); it1 != kptMatches.end() - 1; ++it1) {
-		// get current keypoint and its matched partner in the prev. frame
-		cv::KeyPoint kpOuterCurr = kptsCurr.at(it1->trainIdx);
-		cv::KeyPoint kpOuterPrev = kptsPrev.at(it1->queryIdx);
-
-		for (auto it2 = kptMatches.begin() + 1; it2 != kptMatches.end(); ++it2) {
-			// get next keypoint and its matched partner in the prev. frame
-			cv::KeyPoint kpInnerCurr = kptsCurr.at(it2->trainIdx);
-			cv::KeyPoint kpInnerPrev = kptsPrev.at(it2->queryIdx);
-
-			// compute distances between keypoints in current frame and do the same for the previous frame
-			double kptDistCurr = cv::norm(kpOuterCurr.pt - kpInnerCurr.pt);
-			double kptDistPrev = cv::norm(kpOuterPrev.pt - kpInnerPrev.pt);
+	// coordinates of the matched keypoints, previous and current frame (structure of arrays)
+	MatchedKeypoints points;
+	gatherMatchedKeypoints(kptsPrev, kptsCurr, kptMatches, points);
+	if (conf.method != CameraTtcMethod::DISTANCE_RATIOS) {
+		return computeTTCCameraScale(points, frameRate, conf, log);
+	}
 
-			// compute the distance ratios h_curr_i/h_prev_i and avoid division by zero
-			if (kptDistPrev > std::numeric_limits<double>::epsilon() && kptDistCurr >= minDist) {
-				double distRatio = kptDistCurr / kptDistPrev;
-				distRatios.push_back(distRatio);
-			}
-		}
+	// compute distance ratios between the matched keypoints, each unique pair once
+	double t = (double)cv::getTickCount();
+	int pairBudget = conf.pairs == CameraTtcPairs::SAMPLED ? conf.pairBudget : 0;
+	size_t numPairs, numRatios;
+	double selectedRatio;
+	HistogramMedianStats histogramStats;
+	if (conf.median == CameraTtcMedian::HISTOGRAM) {
+		// streamed into a histogram, the ratios are not stored
+		selectedRatio = histogramMedianRatio(points, conf.minDist, pairBudget, conf.histogramBins, conf.maxMedianError,
+											 &histogramStats);
+		numPairs = histogramStats.numPairs;
+		numRatios = histogramStats.numRatios;
+	} else {
+		std::vector<float> distRatios;  // stores the distance ratios for all keypoints between curr. and prev. frame
+		numPairs = sampledPairRatios(points, conf.minDist, pairBudget, distRatios);
+		numRatios = distRatios.size();
+		selectedRatio = medianRatio(distRatios);
 	}
+	t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
 
 	// only continue if list of distance ratios is not empty
-	double ttc = 0.0;
-	if (distRatios.size() == 0) {
-		ttc = NAN;
-		return ttc;
+	if (numRatios == 0) {
+		return NAN;
 	}
 
 	// Commpute TTC using the constant-velocity model
@@ -166,12 +478,38 @@ double computeTTCCamera(std::vector<cv::KeyPoint> &kptsPrev, std::vector<cv::Key
 
 	// Compute TTC using median of the data
 	// delta_T = 1 / frameRate;
-	double selectedRatio = computeMedian(distRatios);
-	ttc = 1 / (frameRate * (selectedRatio - 1));
+	double ttc = 1 / (frameRate * (selectedRatio - 1));
 
 	// Some info
-	std::cout << "  >>> Camera TTC: distance ratio d_prev/d_curr" << std::endl;
-	std::cout << "	>>> current median: " << selectedRatio << std::endl;
+	log << "  >>> Camera TTC: distance ratio d_prev/d_curr" << std::endl;
+	log << "	>>> current median: " << selectedRatio << " (" << numRatios << " of " << numPairs << " pairs, "
+		<< distanceRatiosInstructionSet() << ") in " << 1000 * t / 1.0 << " ms" << std::endl;
+
+	if (conf.evalAccuracy && conf.median == CameraTtcMedian::HISTOGRAM) {
+		// reference: the exact median of the same pairs
+		double tExact = (double)cv::getTickCount();
+		std::vector<float> exactRatios;
+		sampledPairRatios(points, conf.minDist, pairBudget, exactRatios);
+		double exactRatio = medianRatio(exactRatios);
+		tExact = ((double)cv::getTickCount() - tExact) / cv::getTickFrequency();
+		double ttcExact = 1 / (frameRate * (exactRatio - 1));
+		log << "  >>> Camera TTC median accuracy: histogram " << selectedRatio << " (" << histogramStats.numPasses
+			<< " passes of " << histogramStats.numBins << " bins, " << 1000 * t / 1.0 << " ms), exact " << exactRatio
+			<< " (" << 1000 * tExact / 1.0 << " ms), ratio error " << (selectedRatio - exactRatio) / exactRatio
+			<< ", TTC deviation " << 100 * (ttc - ttcExact) / ttcExact << " %" << std::endl;
+	}
+	if (conf.evalAccuracy && conf.pairs == CameraTtcPairs::SAMPLED) {
+		// reference: the estimate from all unique pairs
+		double tAll = (double)cv::getTickCount();
+		std::vector<float> allRatios;
+		size_t numAllPairs = allPairRatios(points, conf.minDist, allRatios);
+		double allRatio = medianRatio(allRatios);
+		tAll = ((double)cv::getTickCount() - tAll) / cv::getTickFrequency();
+		double ttcAll = 1 / (frameRate * (allRatio - 1));
+		log << "  >>> Camera TTC accuracy: sampled " << ttc << " s (" << numPairs << " pairs, " << 1000 * t / 1.0
+			<< " ms), exhaustive " << ttcAll << " s (" << numAllPairs << " pairs, " << 1000 * tAll / 1.0
+			<< " ms), deviation " << 100 * (ttc - ttcAll) / ttcAll << " %" << std::endl;
+	}
 
 	return ttc;
 }
@@ -3,26 +3,43 @@
 #define TTC_H_
 
 #include <stdio.h>
+#include <iostream>
 #include "dataStructures.h"
+#include "keypointTracks.h"
+#include "objectTracks.h"
+#include "ttcFilter.h"
+#include "ttcScheduler.h"
 #include "utils.h"
 
-void evalTTC(LidarTtcMethod lidarTtcMethod, KptMatchesClusterConf kptClusterConfig, DataFrame &currFrame,
-             DataFrame &prevFrame, cv::Mat &P_rect_00, cv::Mat &R_rect_00, cv::Mat &RT, double sensorFrameRate,
-             bool showKeypointSelected, bool showTTCOnImage);
+void evalTTC(LidarTtcMethod lidarTtcMethod, KptMatchesClusterConf kptClusterConfig, const CameraTtcConf &cameraTtcConf,
+             DataFrame &currFrame, DataFrame &prevFrame, cv::Mat &P_rect_00, cv::Mat &R_rect_00, cv::Mat &RT,
+             double sensorFrameRate, bool showKeypointSelected, bool showTTCOnImage,
+             TtcFilter *ttcFilter = nullptr, TtcScheduler *ttcScheduler = nullptr,
+             TrackManager *trackManager = nullptr, const KeypointTrackStore *trackStore = nullptr,
+             int trackTtcBaseline = 0);
 
 double computeTTCLidar(LidarTtcMethod ttcMethod, std::vector<LidarPoint> &lidarPointsPrev,
-                       std::vector<LidarPoint> &lidarPointsCurr, double frameRate);
+                       std::vector<LidarPoint> &lidarPointsCurr, double frameRate, std::ostream &log = std::cout);
+
+// Lidar TTC of the constant velocity model from the distance to the object in the previous and the current frame
+double computeTTCLidarFromDistances(double distance0, double distance1, double lidarFrameRate,
+                                    std::ostream &log = std::cout);
 
 double computeTTCLidarMedianBased(std::vector<double> &xLidarPrev, std::vector<double> &xLidarCurr,
-                                  double lidarFrameRate);
+                                  double lidarFrameRate, std::ostream &log = std::cout);
 
 double computeTTCLidarMeanBased(std::vector<double> &xLidarPrev, std::vector<double> &xLidarCurr,
-                                double lidarFrameRate);
+                                double lidarFrameRate, std::ostream &log = std::cout);
 
 double computeTTCLidarClusterBased(std::vector<LidarPoint> &lidarPointsPrev, std::vector<LidarPoint> &lidarPointsCurr,
-                                   double frameRate);
-
-double computeTTCCamera(std::vector<cv::KeyPoint> &kptsPrev, std::vector<cv::KeyPoint> &kptsCurr,
-                        std::vector<cv::DMatch> kptMatches, double frameRate, cv::Mat *visImg = nullptr);
+                                   double frameRate, std::ostream &log = std::cout);
+
+/* Camera TTC from the median distance ratio of keypoint pairs, all unique pairs or a sampled subset (conf.pairs), or
+ * from the scale of a similarity transform fitted with RANSAC / LMedS (conf.method)
+ */
+double computeTTCCamera(const std::vector<cv::KeyPoint> &kptsPrev, const std::vector<cv::KeyPoint> &kptsCurr,
+                        const std::vector<cv::DMatch> &kptMatches, double frameRate,
+                        const CameraTtcConf &conf = CameraTtcConf(), cv::Mat *visImg = nullptr,
+                        std::ostream &log = std::cout);
 
 #endif /* TTC_H_ */
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ttcFilter.h"
+
+namespace {
+
+const double kInitialVelocityStd = 10.0;	  // std. of v of a new track [m/s]
+const double kInitialAccelerationStd = 2.0;	  // std. of a of a new track [m/s^2]
+const double kMaxCameraInnovation = 3.0;	  // camera updates beyond this many std. of the innovation are rejected
+
+// Jacobian of the camera measurement 1 / TTC = -v / d
+cv::Vec3d invTtcJacobian(const cv::Vec3d &x) {
+	return cv::Vec3d(x[1] / (x[0] * x[0]), -1 / x[0], 0);
+}
+
+double projectedVariance(const cv::Matx33d &P, const cv::Vec3d &h) {
+	return h.dot(P * h);
+}
+
+// Kalman update with a scalar measurement of innovation y, measurement Jacobian h and variance r
+void scalarUpdate(TtcTrack &track, const cv::Vec3d &h, double y, double r) {
+	cv::Vec3d ph = track.P * h;
+	double s = h.dot(ph) + r;
+	cv::Vec3d k = ph * (1 / s);
+	track.x += k * y;
+	track.P -= k * ph.t();
+	// keep the covariance symmetric against rounding
+	track.P = 0.5 * (track.P + track.P.t());
+}
+
+}  // namespace
+
+void initTtcFilter(TtcFilter &filter, const TtcFilterConf &conf) {
+	filter = TtcFilter();
+	filter.conf = conf;
+}
+
+TtcTrack predictTtcTrack(const TtcFilter &filter, int trackID, double dt) {
+	auto it = filter.tracks.find(trackID);
+	if (it == filter.tracks.end()) {
+		return TtcTrack();
+	}
+	TtcTrack track = it->second;
+	bool acceleration = filter.conf.acceleration;
+	// constant velocity: the acceleration is noise; constant acceleration: the jerk is noise
+	cv::Matx33d F(1, dt, acceleration ? dt * dt / 2 : 0, 0, 1, acceleration ? dt : 0, 0, 0, 1);
+	cv::Vec3d g = acceleration ? cv::Vec3d(dt * dt * dt / 6, dt * dt / 2, dt) : cv::Vec3d(dt * dt / 2, dt, 0);
+	double q = filter.conf.processNoise * filter.conf.processNoise;
+	track.x = F * track.x;
+	track.P = F * track.P * F.t() + q * g * g.t();
+	return track;
+}
+
+bool canSkipEstimators(const TtcFilter &filter, const TtcTrack &track) {
+	const TtcFilterConf &conf = filter.conf;
+	if (track.age < std::max(conf.minTrackAge, 1) || track.skippedFrames >= conf.maxSkippedFrames) {
+		return false;
+	}
+	double invTtcStd;
+	ttcOfTrack(track, &invTtcStd);
+	return invTtcStd < conf.maxInvTtcStd;
+}
+
+void updateTtcTrackLidar(TtcTrack &track, const TtcFilterConf &conf, double distance) {
+	if (std::isnan(distance)) {
+		return;
+	}
+	double r = conf.lidarDistanceStd * conf.lidarDistanceStd;
+	if (track.age == 0) {
+		double aVar = conf.acceleration ? kInitialAccelerationStd * kInitialAccelerationStd : 0;
+		track.x = cv::Vec3d(distance, 0, 0);
+		track.P = cv::Matx33d::diag(cv::Vec3d(r, kInitialVelocityStd * kInitialVelocityStd, aVar));
+	} else {
+		scalarUpdate(track, cv::Vec3d(1, 0, 0), distance - track.x[0], r);
+	}
+	++track.age;
+}
+
+bool updateTtcTrackCamera(TtcTrack &track, const TtcFilterConf &conf, double ttcCamera) {
+	if (std::isnan(ttcCamera) || track.age == 0 || track.x[0] <= 0) {
+		return false;
+	}
+	// an infinite TTC (no scale change) is a valid measurement of 1 / TTC = 0
+	double y = 1 / ttcCamera + track.x[1] / track.x[0];
+	cv::Vec3d h = invTtcJacobian(track.x);
+	double r = conf.cameraInvTtcStd * conf.cameraInvTtcStd;
+	if (y * y > kMaxCameraInnovation * kMaxCameraInnovation * (projectedVariance(track.P, h) + r)) {
+		return false;
+	}
+	scalarUpdate(track, h, y, r);
+	return true;
+}
+
+double ttcOfTrack(const TtcTrack &track, double *invTtcStd) {
+	if (invTtcStd) {
+		*invTtcStd = track.x[0] > 0 ? std::sqrt(projectedVariance(track.P, invTtcJacobian(track.x))) : INFINITY;
+	}
+	return track.x[0] / -track.x[1];
+}
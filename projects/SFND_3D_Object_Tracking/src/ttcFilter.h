@@ -0,0 +1,56 @@
+#ifndef TTC_FILTER_H_
+#define TTC_FILTER_H_
+
+#include <map>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+
+/* Kalman filtered TTC of the objects tracked through the bounding box matches.
+ *
+ * Each track estimates the distance d to the object, its rate of change v = dd/dt (negative while closing in) and,
+ * with conf.acceleration, the acceleration a. Both sensors measure this state: the median x of the Lidar points of the
+ * box measures d, the camera TTC measures the scale change of the object, 1 / TTC = -v / d, which is fused with an
+ * extended Kalman update and rejected beyond 3 std. of its innovation. The published TTC d / -v of the filtered state
+ * is available every frame. The filter tracks are the object tracks of the boxes (BoundingBox::trackID, see
+ * objectTracks.h) and end with them.
+ * Once a track has converged (conf.minTrackAge updates, predicted std. of 1 / TTC below conf.maxInvTtcStd), the
+ * expensive estimators (Lidar TTC, keypoint clustering and camera TTC) are skipped for up to conf.maxSkippedFrames
+ * frames in a row; the track is then only predicted and updated with the Lidar distance. The filter sums the time of
+ * the estimator runs and estimates the time saved from the no. of skipped evaluations.
+ */
+struct TtcTrack {
+	cv::Vec3d x;			// d [m], v [m/s], a [m/s^2]
+	cv::Matx33d P;			// state covariance
+	int age = 0;			// no. of Lidar updates, 0 for a track not initialized yet
+	int skippedFrames = 0;	// frames in a row the estimators were skipped
+};
+
+struct TtcFilter {
+	TtcFilterConf conf;
+	std::map<int, TtcTrack> tracks;	 // by track ID
+
+	// statistics over all frames
+	long numEvaluations = 0;   // objects the estimators were run for
+	long numSkipped = 0;	   // objects the estimators were skipped for
+	double estimatorTime = 0;  // time of the estimator runs [s]
+};
+
+void initTtcFilter(TtcFilter &filter, const TtcFilterConf &conf);
+
+// Filter track of the object track trackID predicted by dt, a new track (age 0) if there is none
+TtcTrack predictTtcTrack(const TtcFilter &filter, int trackID, double dt);
+
+// True if the track has converged and the estimators have not been skipped for conf.maxSkippedFrames yet
+bool canSkipEstimators(const TtcFilter &filter, const TtcTrack &track);
+
+// Update with the median Lidar distance [m], initializes a new track
+void updateTtcTrackLidar(TtcTrack &track, const TtcFilterConf &conf, double distance);
+
+// Update with the camera TTC [s]; false if it is rejected (NaN, track not initialized, outlier)
+bool updateTtcTrackCamera(TtcTrack &track, const TtcFilterConf &conf, double ttcCamera);
+
+// Filtered TTC d / -v of the track [s] and the std. of its inverse [1/s]
+double ttcOfTrack(const TtcTrack &track, double *invTtcStd = nullptr);
+
+#endif /* TTC_FILTER_H_ */
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "ttcScheduler.h"
+
+namespace {
+
+enum class Tier { FORCED = 0, CRITICAL, OTHER };
+
+struct Rank {
+	int object;
+	Tier tier;
+	double key;  // within the tier, lower is more critical
+};
+
+// Median of a coordinate of the Lidar points (partially reorders vals)
+double medianOf(std::vector<double> &vals) {
+	size_t mid = vals.size() / 2;
+	std::nth_element(vals.begin(), vals.begin() + mid, vals.end());
+	return vals[mid];
+}
+
+}  // namespace
+
+void initTtcScheduler(TtcScheduler &scheduler, const TtcScheduleConf &conf) {
+	scheduler = TtcScheduler();
+	scheduler.conf = conf;
+}
+
+TtcSchedule planTtcSchedule(const TtcScheduler &scheduler, const std::vector<BoundingBox *> &currBBs,
+							const std::vector<BoundingBox *> &prevBBs) {
+	const TtcScheduleConf &conf = scheduler.conf;
+	int numObjects = static_cast<int>(currBBs.size());
+	TtcSchedule schedule;
+	schedule.last.resize(numObjects);
+	schedule.egoLane.assign(numObjects, 0);
+
+	std::vector<Rank> ranks;
+	std::vector<double> xs, ys;
+	for (int i = 0; i < numObjects; ++i) {
+		const std::vector<LidarPoint> &points = currBBs[i]->lidarPoints;
+		if (points.empty() || prevBBs[i]->lidarPoints.empty()) {
+			continue;  // no TTC without Lidar points
+		}
+		auto it = scheduler.objects.find(currBBs[i]->trackID);
+		if (it != scheduler.objects.end()) {
+			schedule.last[i] = it->second;
+		}
+		const ScheduledObject &last = schedule.last[i];
+
+		xs.clear();
+		ys.clear();
+		for (const auto &point : points) {
+			xs.push_back(point.x);
+			ys.push_back(point.y);
+		}
+		double distance = medianOf(xs);
+		double lateralOffset = std::fabs(medianOf(ys));
+		schedule.egoLane[i] = lateralOffset <= conf.egoLaneHalfWidth;
+
+		Rank rank = {i, Tier::OTHER, 0};
+		if (schedule.egoLane[i] || last.deferredFrames >= conf.maxDeferredFrames) {
+			rank.tier = Tier::FORCED;
+			rank.key = distance;
+		} else if (last.evaluated && last.ttc > 0 && last.ttc < conf.criticalTtc) {
+			rank.tier = Tier::CRITICAL;
+			rank.key = last.ttc;
+		} else {
+			rank.key = std::hypot(conf.lateralWeight * (lateralOffset - conf.egoLaneHalfWidth), distance);
+		}
+		ranks.push_back(rank);
+	}
+
+	std::stable_sort(ranks.begin(), ranks.end(), [](const Rank &a, const Rank &b) {
+		return a.tier != b.tier ? a.tier < b.tier : a.key < b.key;
+	});
+	for (const auto &rank : ranks) {
+		schedule.order.push_back(rank.object);
+		schedule.numForced += rank.tier == Tier::FORCED ? 1 : 0;
+	}
+	return schedule;
+}
+
+void updateTtcScheduler(TtcScheduler &scheduler, const TtcSchedule &schedule,
+						const std::vector<BoundingBox *> &currBBs, const std::vector<char> &evaluated,
+						const std::vector<char> &skipped, const std::vector<char> &deferred,
+						const std::vector<double> &ttcLidar, const std::vector<double> &ttcCamera,
+						const std::vector<double> &ttc) {
+	std::map<int, ScheduledObject> objects;
+	for (size_t i = 0; i < currBBs.size(); ++i) {
+		if (evaluated[i] && skipped[i]) {
+			// no new estimates: keep those of the last evaluation, rank by the filtered TTC of this frame
+			ScheduledObject &object = objects[currBBs[i]->trackID];
+			object = schedule.last[i];
+			object.ttc = ttc[i];
+			object.deferredFrames = 0;
+		} else if (evaluated[i]) {
+			ScheduledObject &object = objects[currBBs[i]->trackID];
+			object.ttcLidar = ttcLidar[i];
+			object.ttcCamera = ttcCamera[i];
+			object.ttc = ttc[i];
+			object.evaluated = true;
+			++scheduler.numEvaluated;
+		} else if (deferred[i]) {
+			ScheduledObject &object = objects[currBBs[i]->trackID];
+			object = schedule.last[i];
+			++object.deferredFrames;
+			++scheduler.numDeferred;
+		}
+	}
+	scheduler.objects.swap(objects);
+}
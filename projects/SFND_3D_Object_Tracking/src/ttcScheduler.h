@@ -0,0 +1,63 @@
+#ifndef TTC_SCHEDULER_H_
+#define TTC_SCHEDULER_H_
+
+#include <map>
+#include <vector>
+
+#include "dataStructures.h"
+
+/* Priority ordered TTC evaluation of the objects of a frame within a time budget.
+ *
+ * The objects with Lidar points are ranked by criticality from the median lateral offset (y) and distance (x) of their
+ * current Lidar points and the TTC published for them in the last frame:
+ * 1. forced: objects in the ego lane (|y| <= conf.egoLaneHalfWidth) and objects deferred for conf.maxDeferredFrames
+ *    frames in a row, ordered by distance;
+ * 2. objects closing in with a last TTC below conf.criticalTtc, ordered by TTC;
+ * 3. all others, ordered by hypot(conf.lateralWeight * lateral offset beyond the ego lane, distance).
+ * evalTTC evaluates the forced objects first, whatever the budget, and the others in waves of one object per thread
+ * as long as the elapsed time plus the expected time of a wave stays within conf.timeBudget. The remaining objects are
+ * deferred: they publish the TTC of their last evaluation. An object is the object track of its box
+ * (BoundingBox::trackID, see objectTracks.h).
+ */
+struct ScheduledObject {  // last evaluation of an object
+	double ttcLidar = 0;
+	double ttcCamera = NAN;
+	double ttc = NAN;  // published TTC used for the ranking (filtered if available, else Lidar)
+	int deferredFrames = 0;
+	bool evaluated = false;  // false until the object has been evaluated once
+};
+
+struct TtcScheduler {
+	TtcScheduleConf conf;
+	std::map<int, ScheduledObject> objects;	 // by track ID
+	double waveTime = 0;					 // expected time of a wave of objects [s], running average
+
+	// statistics over all frames
+	long numEvaluated = 0;
+	long numDeferred = 0;
+};
+
+struct TtcSchedule {
+	std::vector<int> order;				   // objects with Lidar points, most critical first
+	int numForced = 0;					   // leading objects of order evaluated whatever the budget
+	std::vector<ScheduledObject> last;	   // per object: last evaluation (from the previous frame)
+	std::vector<char> egoLane;			   // per object: in the ego lane
+};
+
+void initTtcScheduler(TtcScheduler &scheduler, const TtcScheduleConf &conf);
+
+// Rank the objects (matched box pairs) of the current frame
+TtcSchedule planTtcSchedule(const TtcScheduler &scheduler, const std::vector<BoundingBox *> &currBBs,
+							const std::vector<BoundingBox *> &prevBBs);
+
+/* Keep the evaluated objects (TTC of this frame) and the deferred ones (TTC of their last evaluation) by track ID;
+ * objects with neither are dropped. Evaluated objects whose estimators the TTC filter skipped keep the Lidar and
+ * camera TTC of their last evaluation and are ranked by the filtered TTC; they do not count as evaluations.
+ */
+void updateTtcScheduler(TtcScheduler &scheduler, const TtcSchedule &schedule,
+						const std::vector<BoundingBox *> &currBBs, const std::vector<char> &evaluated,
+						const std::vector<char> &skipped, const std::vector<char> &deferred,
+						const std::vector<double> &ttcLidar, const std::vector<double> &ttcCamera,
+						const std::vector<double> &ttc);
+
+#endif /* TTC_SCHEDULER_H_ */
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -74,16 +75,21 @@ std::string getDatasetImageName(DataSetConfig &dataInfo, size_t imgIndex) {
 	return ss.str();
 }
 
-void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame) {
-	int dataBufferSize = 2;  // no. of images which are held in memory (ring
-							 // buffer) at the same time
+void pushToBuffer(std::vector<DataFrame> &buffer, DataFrame &newFrame, size_t bufferSize) {
+	// no. of images which are held in memory (ring buffer) at the same time
+	size_t dataBufferSize = std::max<size_t>(bufferSize, 2);
 	if (buffer.size() < dataBufferSize) {
 		buffer.emplace_back(newFrame);
 		std::cout << "Initializing buffer; Buffer size is: " << buffer.size() << std::endl;
 	} else {
 		std::rotate(buffer.begin(), buffer.begin() + 1, buffer.end());
+		// recycle the descriptor memory of the dropped frame unless something else still refers to it
+		std::shared_ptr<DescriptorArena> arena = buffer.back().descriptorArena;
 		buffer.pop_back();
 		buffer.emplace_back(newFrame);
+		if (!buffer.back().descriptorArena && arena.use_count() == 1) {
+			buffer.back().descriptorArena = arena;
+		}
 		std::cout << "Updating buffer; Buffer size is: " << buffer.size() << std::endl;
 	}
 
@@ -168,7 +174,7 @@ void showMultimapContent(std::multimap<int, int> &myMap) {
 
 NormalDistribution evalNormalDistributionParams(std::vector<double> &vals) {
 	NormalDistribution ndist;
-	double sum = std::accumulate(vals.begin(), vals.end(), 0.0, [](int sum, const double val) { return sum + val; });
+	double sum = std::accumulate(vals.begin(), vals.end(), 0.0, [](double sum, const double val) { return sum + val; });
 	double mean = sum / vals.size();
 
 	std::vector<double> diff(vals.size());
@@ -180,6 +186,22 @@ NormalDistribution evalNormalDistributionParams(std::vector<double> &vals) {
 	return ndist;
 }
 
+void updateRunningStats(RunningStats &stats, double value) {
+	++stats.count;
+	double delta = value - stats.mean;
+	stats.mean += delta / stats.count;
+	stats.m2 += delta * (value - stats.mean);
+	stats.min = std::min(stats.min, value);
+	stats.max = std::max(stats.max, value);
+}
+
+NormalDistribution evalNormalDistributionParams(const RunningStats &stats) {
+	NormalDistribution ndist;
+	ndist.mean = stats.mean;
+	ndist.stddev = stats.count > 0 ? std::sqrt(stats.m2 / stats.count) : 0.0;
+	return ndist;
+}
+
 void drawMatches(std::vector<cv::DMatch> &matches, DataFrame &currentFrame, DataFrame &previousFrame,
 				 std::string windowTitle) {
 	cv::Mat matchImg = currentFrame.cameraImg.clone();
@@ -212,7 +234,7 @@ double computeMedian(std::vector<double> &vals) {
 }
 
 double computeMean(std::vector<double> &vals) {
-	double sum = std::accumulate(vals.begin(), vals.end(), 0.0, [](int sum, const double &p) { return sum + p; });
+	double sum = std::accumulate(vals.begin(), vals.end(), 0.0, [](double sum, const double &p) { return sum + p; });
 	return sum / vals.size();
 }
 